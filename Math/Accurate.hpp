@@ -0,0 +1,305 @@
+#pragma once
+
+#include <Math/Matrix.hpp>
+
+namespace Scoop::Math
+{
+    // Compensated arithmetic
+    //
+    // Error-free transformations split a sum or product into its rounded result and the exact
+    // rounding error. Accumulating the errors separately gives sums, dot products and matrix
+    // products as accurate as if they were computed in twice the working precision and then
+    // rounded (Ogita, Rump and Oishi). The transformations rely on strict IEEE arithmetic, so
+    // this file must not be compiled with -ffast-math or similar reassociating options.
+
+    // Products use a fused multiply-add when the target has one, and Dekker's splitting otherwise,
+    // since std::fma is emulated in software (and much slower) without hardware support
+
+    #if defined(__FMA__) || defined(__ARM_FEATURE_FMA) || defined(__aarch64__)
+        #define __ACCURATE_HAS_FMA true
+    #else
+        #define __ACCURATE_HAS_FMA false
+    #endif
+
+    // As in the GEMM micro-kernel, lane loops are kept rolled so they are vectorized across lanes
+
+    #if defined(__clang__)
+        #define __ACCURATE_LANE_LOOP _Pragma("clang loop unroll(disable)")
+    #elif defined(__GNUC__)
+        #define __ACCURATE_LANE_LOOP _Pragma("GCC unroll 1")
+    #else
+        #define __ACCURATE_LANE_LOOP
+    #endif
+
+    namespace Detail
+    {
+        // Independent accumulators of the vectorized reductions, and the register tile of the
+        // compensated GEMM kernel (AccurateGemmMR rows by AccurateGemmNR columns)
+
+        constexpr size_t AccurateLanes = 8;
+        template <typename Type> constexpr size_t AccurateGemmMR = std::max<size_t>(64 / sizeof(Type), 4);
+        constexpr size_t AccurateGemmNR = 6;
+
+        // sum + error = a + b exactly (Knuth)
+
+        template <typename Type>
+        inline void TwoSum(Type a, Type b, Type &sum, Type &error)
+        {
+            sum = a + b;
+            const Type virtualB = sum - a;
+            error = (a - (sum - virtualB)) + (b - virtualB);
+        }
+
+        // product + error = a * b exactly
+
+        template <typename Type>
+        inline void TwoProduct(Type a, Type b, Type &product, Type &error)
+        {
+            product = a * b;
+
+            if constexpr (__ACCURATE_HAS_FMA)
+            {
+                error = std::fma(a, b, -product);
+            }
+            else
+            {
+                constexpr Type split = Type((uint64_t(1) << ((std::numeric_limits<Type>::digits + 1) / 2)) + 1);
+
+                const Type aSplit = split * a;
+                const Type aHigh = aSplit - (aSplit - a);
+                const Type aLow = a - aHigh;
+                const Type bSplit = split * b;
+                const Type bHigh = bSplit - (bSplit - b);
+                const Type bLow = b - bHigh;
+
+                error = aLow * bLow - (((product - aHigh * bHigh) - aLow * bHigh) - aHigh * bLow);
+            }
+        }
+
+        // Adds the lane sums and errors of a vectorized reduction, compensated
+
+        template <typename Type>
+        inline Type AccurateReduce(const Type *sums, const Type *errors)
+        {
+            Type sum = sums[0];
+            Type error = errors[0];
+
+            for (size_t lane = 1; lane < AccurateLanes; lane++)
+            {
+                Type rounding;
+                TwoSum(sum, sums[lane], sum, rounding);
+                error += rounding + errors[lane];
+            }
+
+            return sum + error;
+        }
+
+        // Compensated dot product (Dot2), with AccurateLanes independent sums so the loop vectorizes
+
+        template <typename Type>
+        Type DotAccurate(const Type *a, const Type *b, size_t count)
+        {
+            Type sums[AccurateLanes] = { };
+            Type errors[AccurateLanes] = { };
+            size_t i = 0;
+
+            for (; i + AccurateLanes <= count; i += AccurateLanes)
+            {
+                __ACCURATE_LANE_LOOP
+                for (size_t lane = 0; lane < AccurateLanes; lane++)
+                {
+                    Type product, productError, sumError;
+                    TwoProduct(a[i + lane], b[i + lane], product, productError);
+                    TwoSum(sums[lane], product, sums[lane], sumError);
+                    errors[lane] += productError + sumError;
+                }
+            }
+
+            for (size_t lane = 0; i < count; i++, lane++)
+            {
+                Type product, productError, sumError;
+                TwoProduct(a[i], b[i], product, productError);
+                TwoSum(sums[lane], product, sums[lane], sumError);
+                errors[lane] += productError + sumError;
+            }
+
+            return AccurateReduce(sums, errors);
+        }
+
+        // Compensated summation (Sum2)
+
+        template <typename Type>
+        Type SumAccurate(const Type *a, size_t count)
+        {
+            Type sums[AccurateLanes] = { };
+            Type errors[AccurateLanes] = { };
+            size_t i = 0;
+
+            for (; i + AccurateLanes <= count; i += AccurateLanes)
+            {
+                __ACCURATE_LANE_LOOP
+                for (size_t lane = 0; lane < AccurateLanes; lane++)
+                {
+                    Type sumError;
+                    TwoSum(sums[lane], a[i + lane], sums[lane], sumError);
+                    errors[lane] += sumError;
+                }
+            }
+
+            for (size_t lane = 0; i < count; i++, lane++)
+            {
+                Type sumError;
+                TwoSum(sums[lane], a[i], sums[lane], sumError);
+                errors[lane] += sumError;
+            }
+
+            return AccurateReduce(sums, errors);
+        }
+
+        // One tile of the compensated GEMM: every element of the rows x cols tile of C is a Dot2
+        // over the inner dimension, its sum and error kept apart until the end. Full tiles have
+        // compile-time sizes, so the sums and errors stay in registers and the row loop
+        // vectorizes; each element is accumulated in the same order either way.
+
+        template <size_t MR, size_t NR, bool Full, typename Type>
+        inline void AccurateGemmTile(size_t rows, size_t cols, size_t inner, const Type *a, size_t lda, const Type *b, size_t ldb,
+            Type *c, size_t ldc, Type *cLow, size_t ldcLow, bool accumulate)
+        {
+            if constexpr (Full)
+            {
+                rows = MR;
+                cols = NR;
+            }
+
+            Type sums[NR][MR];
+            Type errors[NR][MR];
+
+            for (size_t j = 0; j < NR; j++)
+            {
+                for (size_t i = 0; i < MR; i++)
+                {
+                    const bool inside = i < rows && j < cols;
+                    sums[j][i] = accumulate && inside ? c[j * ldc + i] : Type(0);
+                    errors[j][i] = accumulate && inside && cLow != nullptr ? cLow[j * ldcLow + i] : Type(0);
+                }
+            }
+
+            for (size_t k = 0; k < inner; k++)
+            {
+                const Type *aCol = a + k * lda;
+                Type aValues[MR];
+
+                for (size_t i = 0; i < MR; i++)
+                    aValues[i] = i < rows ? aCol[i] : Type(0);
+
+                for (size_t j = 0; j < NR; j++)
+                {
+                    const Type bValue = j < cols ? b[j * ldb + k] : Type(0);
+
+                    __ACCURATE_LANE_LOOP
+                    for (size_t i = 0; i < MR; i++)
+                    {
+                        Type product, productError, sumError;
+                        TwoProduct(aValues[i], bValue, product, productError);
+                        TwoSum(sums[j][i], product, sums[j][i], sumError);
+                        errors[j][i] += productError + sumError;
+                    }
+                }
+            }
+
+            for (size_t j = 0; j < cols; j++)
+            {
+                for (size_t i = 0; i < rows; i++)
+                {
+                    if (cLow != nullptr)
+                    {
+                        TwoSum(sums[j][i], errors[j][i], c[j * ldc + i], cLow[j * ldcLow + i]);
+                    }
+                    else
+                    {
+                        c[j * ldc + i] = sums[j][i] + errors[j][i];
+                    }
+                }
+            }
+        }
+
+        // C = AB (or C = C + AB when accumulate is set) with every element computed as if in twice
+        // the working precision. When cLow is given, C + cLow is that double-length result, and
+        // it is also the accumulated input. Row tiles are outermost so each strip of A stays in
+        // cache across the column tiles, and column tiles are split between threads.
+
+        template <typename Type>
+        void GemmAccurate(size_t rows, size_t cols, size_t inner, const Type *a, size_t lda, const Type *b, size_t ldb,
+            Type *c, size_t ldc, Type *cLow, size_t ldcLow, bool accumulate)
+        {
+            constexpr size_t MR = AccurateGemmMR<Type>;
+            constexpr size_t NR = AccurateGemmNR;
+            const size_t slivers = (cols + NR - 1) / NR;
+            const size_t minSlivers = std::max<size_t>(1, GemmParallelSize / std::max<size_t>(1, rows * inner * NR));
+
+            ParallelFor(0, slivers, minSlivers, [&](size_t begin, size_t end)
+            {
+                for (size_t row = 0; row < rows; row += MR)
+                {
+                    const size_t mr = std::min(MR, rows - row);
+
+                    for (size_t sliver = begin; sliver < end; sliver++)
+                    {
+                        const size_t col = sliver * NR;
+                        const size_t nr = std::min(NR, cols - col);
+
+                        if (mr == MR && nr == NR)
+                        {
+                            AccurateGemmTile<MR, NR, true>(MR, NR, inner, a + row, lda, b + col * ldb, ldb, c + col * ldc + row, ldc,
+                                cLow != nullptr ? cLow + col * ldcLow + row : nullptr, ldcLow, accumulate);
+                        }
+                        else
+                        {
+                            AccurateGemmTile<MR, NR, false>(mr, nr, inner, a + row, lda, b + col * ldb, ldb, c + col * ldc + row, ldc,
+                                cLow != nullptr ? cLow + col * ldcLow + row : nullptr, ldcLow, accumulate);
+                        }
+                    }
+                }
+            });
+        }
+    }
+
+    // Compensated sums and dot products, as accurate as if computed in twice the working precision
+
+    template <typename Type>
+    Type SumAccurate(const Type *values, size_t count)
+    { return Detail::SumAccurate(values, count); }
+
+    template <typename Type, size_t Size>
+    Type SumAccurate(const Vector<Type, Size> &vec)
+    { return Detail::SumAccurate(vec.data, Size); }
+
+    template <typename Type>
+    Type DotAccurate(const Type *a, const Type *b, size_t count)
+    { return Detail::DotAccurate(a, b, count); }
+
+    template <typename Type, size_t Size>
+    Type DotAccurate(const Vector<Type, Size> &a, const Vector<Type, Size> &b)
+    { return Detail::DotAccurate(a.data, b.data, Size); }
+
+    // Compensated matrix products
+
+    template <typename Type, size_t Rows, size_t Inner, size_t Cols>
+    Matrix<Type, Rows, Cols> MultiplyAccurate(const Matrix<Type, Rows, Inner> &a, const Matrix<Type, Inner, Cols> &b)
+    {
+        Matrix<Type, Rows, Cols> newMat;
+        Detail::GemmAccurate<Type>(Rows, Cols, Inner, a.data, Rows, b.data, Inner, newMat.data, Rows, nullptr, Rows, false);
+        return newMat;
+    }
+
+    template <typename Type, size_t Rows, size_t Cols>
+    Vector<Type, Rows> MultiplyAccurate(const Matrix<Type, Rows, Cols> &a, const Vector<Type, Cols> &vec)
+    {
+        Vector<Type, Rows> newVec;
+        Detail::GemmAccurate<Type>(Rows, 1, Cols, a.data, Rows, vec.data, Cols, newVec.data, Rows, nullptr, Rows, false);
+        return newVec;
+    }
+
+    #undef __ACCURATE_HAS_FMA
+    #undef __ACCURATE_LANE_LOOP
+}
@@ -0,0 +1,541 @@
+#pragma once
+
+#include <Math/Matrix.hpp>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+#endif
+
+namespace Scoop::Math
+{
+    // Bit matrix kernels
+    //
+    // Bit matrices are stored row-major, 64 entries per word, with the entry in column c of a
+    // row held in bit (c % 64) of word (c / 64). Padding bits past the last column are always 0.
+
+    namespace Detail
+    {
+        constexpr size_t BitWords(size_t bits)
+        { return (bits + 63) / 64; }
+
+        inline size_t Popcount(uint64_t word)
+        {
+            #if defined(__GNUC__) || defined(__clang__)
+                return (size_t)__builtin_popcountll(word);
+            #elif defined(_MSC_VER) && defined(_M_X64)
+                return (size_t)__popcnt64(word);
+            #else
+                word = word - ((word >> 1) & 0x5555555555555555ull);
+                word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+                word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+                return (size_t)((word * 0x0101010101010101ull) >> 56);
+            #endif
+        }
+
+        inline size_t BitCount(const uint64_t *words, size_t count)
+        {
+            size_t total = 0;
+
+            for (size_t i = 0; i < count; i++)
+                total += Popcount(words[i]);
+
+            return total;
+        }
+
+        // In-place transposition of a 64x64 bit block, where block[r] holds row r
+
+        inline void Transpose64(uint64_t *block)
+        {
+            uint64_t mask = 0x00000000FFFFFFFFull;
+
+            for (size_t j = 32; j != 0; j >>= 1, mask ^= mask << j)
+            {
+                for (size_t k = 0; k < 64; k = ((k | j) + 1) & ~j)
+                {
+                    uint64_t t = ((block[k] >> j) ^ block[k | j]) & mask;
+                    block[k] ^= t << j;
+                    block[k | j] ^= t;
+                }
+            }
+        }
+
+        inline void BitTranspose(size_t rows, size_t cols, const uint64_t *src, uint64_t *dst)
+        {
+            const size_t srcWords = BitWords(cols);
+            const size_t dstWords = BitWords(rows);
+            uint64_t block[64];
+
+            for (size_t rowTile = 0; rowTile < dstWords; rowTile++)
+            {
+                size_t tileRows = std::min<size_t>(64, rows - rowTile * 64);
+
+                for (size_t colTile = 0; colTile < srcWords; colTile++)
+                {
+                    size_t tileCols = std::min<size_t>(64, cols - colTile * 64);
+
+                    for (size_t i = 0; i < tileRows; i++)
+                        block[i] = src[(rowTile * 64 + i) * srcWords + colTile];
+                    for (size_t i = tileRows; i < 64; i++)
+                        block[i] = 0;
+
+                    Transpose64(block);
+
+                    for (size_t i = 0; i < tileCols; i++)
+                        dst[(colTile * 64 + i) * dstWords + rowTile] = block[i];
+                }
+            }
+        }
+
+        // Four Russians multiplication, C = A * B over the boolean semiring (Xor = false) or GF(2)
+        // (Xor = true). The inner dimension is consumed 8 bits at a time: the 256 combinations of
+        // 8 rows of B are tabulated, and each row of A then gathers one table row per byte.
+
+        template <bool Xor>
+        void BitMultiply(size_t rows, size_t inner, size_t cols, const uint64_t *a, const uint64_t *b, uint64_t *c)
+        {
+            const size_t aWords = BitWords(inner);
+            const size_t cWords = BitWords(cols);
+
+            std::fill(c, c + rows * cWords, uint64_t(0));
+
+            if (rows == 0 || cols == 0)
+                return;
+
+            ParallelFor(0, rows, 512, [&](size_t rowBegin, size_t rowEnd)
+            {
+                std::vector<uint64_t> table(256 * cWords);
+
+                for (size_t group = 0; group < inner; group += 8)
+                {
+                    size_t groupSize = std::min<size_t>(8, inner - group);
+                    size_t entries = size_t(1) << groupSize;
+
+                    std::fill(table.begin(), table.begin() + cWords, uint64_t(0));
+
+                    for (size_t entry = 1; entry < entries; entry++)
+                    {
+                        size_t bit = 0;
+                        while (!(entry & (size_t(1) << bit)))
+                            bit++;
+
+                        const uint64_t *prev = table.data() + (entry & (entry - 1)) * cWords;
+                        const uint64_t *bRow = b + (group + bit) * cWords;
+                        uint64_t *dst = table.data() + entry * cWords;
+
+                        for (size_t w = 0; w < cWords; w++)
+                            dst[w] = Xor ? (prev[w] ^ bRow[w]) : (prev[w] | bRow[w]);
+                    }
+
+                    const size_t word = group / 64;
+                    const size_t shift = group % 64;
+
+                    for (size_t row = rowBegin; row < rowEnd; row++)
+                    {
+                        size_t entry = (size_t)((a[row * aWords + word] >> shift) & (entries - 1));
+
+                        if (entry == 0)
+                            continue;
+
+                        const uint64_t *src = table.data() + entry * cWords;
+                        uint64_t *dst = c + row * cWords;
+
+                        for (size_t w = 0; w < cWords; w++)
+                            dst[w] = Xor ? (dst[w] ^ src[w]) : (dst[w] | src[w]);
+                    }
+                }
+            });
+        }
+
+        // Integer product C = A * B, counting the matching bits of each row of A and column of B.
+        // bT holds B transposed, so each entry is the popcount of two ANDed bit rows.
+
+        inline void BitMultiplyCount(size_t rows, size_t inner, size_t cols, const uint64_t *a, const uint64_t *bT, uint32_t *c)
+        {
+            const size_t words = BitWords(inner);
+
+            ParallelFor(0, cols, 64, [&](size_t colBegin, size_t colEnd)
+            {
+                for (size_t col = colBegin; col < colEnd; col++)
+                {
+                    const uint64_t *bRow = bT + col * words;
+
+                    for (size_t row = 0; row < rows; row++)
+                    {
+                        const uint64_t *aRow = a + row * words;
+                        size_t count = 0;
+
+                        for (size_t w = 0; w < words; w++)
+                            count += Popcount(aRow[w] & bRow[w]);
+
+                        c[col * rows + row] = (uint32_t)count;
+                    }
+                }
+            });
+        }
+
+        template <typename Type>
+        void BitPack(size_t rows, size_t cols, const Type *src, uint64_t *dst)
+        {
+            const size_t words = BitWords(cols);
+
+            std::fill(dst, dst + rows * words, uint64_t(0));
+
+            for (size_t col = 0; col < cols; col++)
+            {
+                const Type *srcCol = src + col * rows;
+                const uint64_t bit = uint64_t(1) << (col % 64);
+                uint64_t *dstWord = dst + col / 64;
+
+                for (size_t row = 0; row < rows; row++)
+                {
+                    if (srcCol[row] != 0)
+                        dstWord[row * words] |= bit;
+                }
+            }
+        }
+
+        template <typename Type>
+        void BitUnpack(size_t rows, size_t cols, const uint64_t *src, Type *dst)
+        {
+            const size_t words = BitWords(cols);
+
+            for (size_t col = 0; col < cols; col++)
+            {
+                const uint64_t *srcWord = src + col / 64;
+                const size_t shift = col % 64;
+                Type *dstCol = dst + col * rows;
+
+                for (size_t row = 0; row < rows; row++)
+                    dstCol[row] = (Type)((srcWord[row * words] >> shift) & 1);
+            }
+        }
+    }
+
+    template <size_t Rows, size_t Cols> class BitMatrix
+    {
+        public:
+
+        static constexpr size_t WordsPerRow = Detail::BitWords(Cols);
+
+        // Matrix elements
+
+        uint64_t words[Rows * WordsPerRow];
+
+        // Constructors
+
+        BitMatrix() = default;
+
+        explicit BitMatrix(bool diagonal)
+        { this->Assign(diagonal); }
+
+        template <typename Type>
+        explicit BitMatrix(const Matrix<Type, Rows, Cols> &mat)
+        { this->Assign(mat); }
+
+        // Assignment
+
+        void Assign(bool diagonal)
+        {
+            std::fill(this->words, this->words + Rows * WordsPerRow, uint64_t(0));
+
+            if (diagonal)
+            {
+                for (size_t i = 0; i < Rows && i < Cols; i++)
+                    this->words[i * WordsPerRow + i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+
+        template <typename Type>
+        void Assign(const Matrix<Type, Rows, Cols> &mat)
+        { Detail::BitPack(Rows, Cols, mat.data, this->words); }
+
+        // Indexing
+
+        bool Get(size_t row, size_t col) const
+        {
+            if (row >= Rows || col >= Cols)
+                throw std::out_of_range("BitMatrix::Get: index out of range.");
+            return (this->words[row * WordsPerRow + col / 64] >> (col % 64)) & 1;
+        }
+
+        void Set(size_t row, size_t col, bool value)
+        {
+            if (row >= Rows || col >= Cols)
+                throw std::out_of_range("BitMatrix::Set: index out of range.");
+
+            uint64_t &word = this->words[row * WordsPerRow + col / 64];
+            const uint64_t bit = uint64_t(1) << (col % 64);
+            word = value ? (word | bit) : (word & ~bit);
+        }
+
+        // Matrix conversion
+
+        template <typename Type = uint8_t>
+        Matrix<Type, Rows, Cols> AsMatrix() const
+        {
+            Matrix<Type, Rows, Cols> mat;
+            Detail::BitUnpack(Rows, Cols, this->words, mat.data);
+            return mat;
+        }
+
+        // Matrix properties
+
+        size_t Count() const
+        { return Detail::BitCount(this->words, Rows * WordsPerRow); }
+
+        BitMatrix<Cols, Rows> Transpose() const
+        {
+            BitMatrix<Cols, Rows> newMat;
+            Detail::BitTranspose(Rows, Cols, this->words, newMat.words);
+            return newMat;
+        }
+
+        // Element-wise logic
+
+        BitMatrix<Rows, Cols> And(const BitMatrix<Rows, Cols> &mat) const
+        { BitMatrix<Rows, Cols> newMat(*this); newMat.AndInPlace(mat); return newMat; }
+
+        BitMatrix<Rows, Cols> Or(const BitMatrix<Rows, Cols> &mat) const
+        { BitMatrix<Rows, Cols> newMat(*this); newMat.OrInPlace(mat); return newMat; }
+
+        BitMatrix<Rows, Cols> Xor(const BitMatrix<Rows, Cols> &mat) const
+        { BitMatrix<Rows, Cols> newMat(*this); newMat.XorInPlace(mat); return newMat; }
+
+        void AndInPlace(const BitMatrix<Rows, Cols> &mat)
+        {
+            for (size_t i = 0; i < Rows * WordsPerRow; i++)
+                this->words[i] &= mat.words[i];
+        }
+
+        void OrInPlace(const BitMatrix<Rows, Cols> &mat)
+        {
+            for (size_t i = 0; i < Rows * WordsPerRow; i++)
+                this->words[i] |= mat.words[i];
+        }
+
+        void XorInPlace(const BitMatrix<Rows, Cols> &mat)
+        {
+            for (size_t i = 0; i < Rows * WordsPerRow; i++)
+                this->words[i] ^= mat.words[i];
+        }
+
+        // Matrix products
+
+        template <size_t Cols2> BitMatrix<Rows, Cols2> Multiply(const BitMatrix<Cols, Cols2> &mat) const
+        {
+            BitMatrix<Rows, Cols2> newMat;
+            Detail::BitMultiply<false>(Rows, Cols, Cols2, this->words, mat.words, newMat.words);
+            return newMat;
+        }
+
+        template <size_t Cols2> BitMatrix<Rows, Cols2> MultiplyGF2(const BitMatrix<Cols, Cols2> &mat) const
+        {
+            BitMatrix<Rows, Cols2> newMat;
+            Detail::BitMultiply<true>(Rows, Cols, Cols2, this->words, mat.words, newMat.words);
+            return newMat;
+        }
+
+        template <size_t Cols2> Matrix<uint32_t, Rows, Cols2> MultiplyCount(const BitMatrix<Cols, Cols2> &mat) const
+        {
+            Matrix<uint32_t, Rows, Cols2> newMat;
+            BitMatrix<Cols2, Cols> transposed = mat.Transpose();
+            Detail::BitMultiplyCount(Rows, Cols, Cols2, this->words, transposed.words, newMat.data);
+            return newMat;
+        }
+
+        // Logic operators
+
+        inline BitMatrix<Rows, Cols> operator&(const BitMatrix<Rows, Cols> &mat) const { return And(mat); }
+        inline BitMatrix<Rows, Cols> operator|(const BitMatrix<Rows, Cols> &mat) const { return Or(mat); }
+        inline BitMatrix<Rows, Cols> operator^(const BitMatrix<Rows, Cols> &mat) const { return Xor(mat); }
+        template <size_t Cols2> inline BitMatrix<Rows, Cols2> operator*(const BitMatrix<Cols, Cols2> &mat) const { return Multiply(mat); }
+
+        inline BitMatrix<Rows, Cols> &operator&=(const BitMatrix<Rows, Cols> &mat) { this->AndInPlace(mat); return *this; }
+        inline BitMatrix<Rows, Cols> &operator|=(const BitMatrix<Rows, Cols> &mat) { this->OrInPlace(mat); return *this; }
+        inline BitMatrix<Rows, Cols> &operator^=(const BitMatrix<Rows, Cols> &mat) { this->XorInPlace(mat); return *this; }
+
+        // Identity matrix
+
+        static BitMatrix<Rows, Cols> Identity()
+        { return BitMatrix<Rows, Cols>(true); }
+    };
+
+    class DynamicBitMatrix
+    {
+        public:
+
+        // Matrix dimensions and elements
+
+        size_t rows = 0;
+        size_t cols = 0;
+        size_t wordsPerRow = 0;
+        std::vector<uint64_t> words;
+
+        // Constructors
+
+        DynamicBitMatrix() = default;
+
+        DynamicBitMatrix(size_t rows, size_t cols, bool diagonal = false)
+            : rows(rows), cols(cols), wordsPerRow(Detail::BitWords(cols)), words(rows * Detail::BitWords(cols), 0)
+        {
+            if (diagonal)
+                this->Assign(true);
+        }
+
+        template <typename Type, size_t Rows, size_t Cols>
+        explicit DynamicBitMatrix(const Matrix<Type, Rows, Cols> &mat)
+            : DynamicBitMatrix(Rows, Cols)
+        { Detail::BitPack(Rows, Cols, mat.data, this->words.data()); }
+
+        template <size_t Rows, size_t Cols>
+        explicit DynamicBitMatrix(const BitMatrix<Rows, Cols> &mat)
+            : rows(Rows), cols(Cols), wordsPerRow(BitMatrix<Rows, Cols>::WordsPerRow), words(mat.words, mat.words + Rows * BitMatrix<Rows, Cols>::WordsPerRow)
+        { }
+
+        // Assignment
+
+        void Assign(bool diagonal)
+        {
+            std::fill(this->words.begin(), this->words.end(), uint64_t(0));
+
+            if (diagonal)
+            {
+                for (size_t i = 0; i < this->rows && i < this->cols; i++)
+                    this->words[i * this->wordsPerRow + i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+
+        // Indexing
+
+        bool Get(size_t row, size_t col) const
+        {
+            if (row >= this->rows || col >= this->cols)
+                throw std::out_of_range("DynamicBitMatrix::Get: index out of range.");
+            return (this->words[row * this->wordsPerRow + col / 64] >> (col % 64)) & 1;
+        }
+
+        void Set(size_t row, size_t col, bool value)
+        {
+            if (row >= this->rows || col >= this->cols)
+                throw std::out_of_range("DynamicBitMatrix::Set: index out of range.");
+
+            uint64_t &word = this->words[row * this->wordsPerRow + col / 64];
+            const uint64_t bit = uint64_t(1) << (col % 64);
+            word = value ? (word | bit) : (word & ~bit);
+        }
+
+        // Matrix conversion
+
+        template <typename Type, size_t Rows, size_t Cols>
+        Matrix<Type, Rows, Cols> AsMatrix() const
+        {
+            if (Rows != this->rows || Cols != this->cols)
+                throw std::runtime_error("DynamicBitMatrix::AsMatrix: dimension mismatch.");
+
+            Matrix<Type, Rows, Cols> mat;
+            Detail::BitUnpack(Rows, Cols, this->words.data(), mat.data);
+            return mat;
+        }
+
+        // Matrix properties
+
+        size_t Count() const
+        { return Detail::BitCount(this->words.data(), this->words.size()); }
+
+        DynamicBitMatrix Transpose() const
+        {
+            DynamicBitMatrix newMat(this->cols, this->rows);
+            Detail::BitTranspose(this->rows, this->cols, this->words.data(), newMat.words.data());
+            return newMat;
+        }
+
+        // Element-wise logic
+
+        DynamicBitMatrix And(const DynamicBitMatrix &mat) const
+        { DynamicBitMatrix newMat(*this); newMat.AndInPlace(mat); return newMat; }
+
+        DynamicBitMatrix Or(const DynamicBitMatrix &mat) const
+        { DynamicBitMatrix newMat(*this); newMat.OrInPlace(mat); return newMat; }
+
+        DynamicBitMatrix Xor(const DynamicBitMatrix &mat) const
+        { DynamicBitMatrix newMat(*this); newMat.XorInPlace(mat); return newMat; }
+
+        void AndInPlace(const DynamicBitMatrix &mat)
+        {
+            this->CheckSameSize(mat, "DynamicBitMatrix::AndInPlace: dimension mismatch.");
+            for (size_t i = 0; i < this->words.size(); i++)
+                this->words[i] &= mat.words[i];
+        }
+
+        void OrInPlace(const DynamicBitMatrix &mat)
+        {
+            this->CheckSameSize(mat, "DynamicBitMatrix::OrInPlace: dimension mismatch.");
+            for (size_t i = 0; i < this->words.size(); i++)
+                this->words[i] |= mat.words[i];
+        }
+
+        void XorInPlace(const DynamicBitMatrix &mat)
+        {
+            this->CheckSameSize(mat, "DynamicBitMatrix::XorInPlace: dimension mismatch.");
+            for (size_t i = 0; i < this->words.size(); i++)
+                this->words[i] ^= mat.words[i];
+        }
+
+        // Matrix products
+
+        DynamicBitMatrix Multiply(const DynamicBitMatrix &mat) const
+        {
+            if (this->cols != mat.rows)
+                throw std::runtime_error("DynamicBitMatrix::Multiply: dimension mismatch.");
+
+            DynamicBitMatrix newMat(this->rows, mat.cols);
+            Detail::BitMultiply<false>(this->rows, this->cols, mat.cols, this->words.data(), mat.words.data(), newMat.words.data());
+            return newMat;
+        }
+
+        DynamicBitMatrix MultiplyGF2(const DynamicBitMatrix &mat) const
+        {
+            if (this->cols != mat.rows)
+                throw std::runtime_error("DynamicBitMatrix::MultiplyGF2: dimension mismatch.");
+
+            DynamicBitMatrix newMat(this->rows, mat.cols);
+            Detail::BitMultiply<true>(this->rows, this->cols, mat.cols, this->words.data(), mat.words.data(), newMat.words.data());
+            return newMat;
+        }
+
+        std::vector<uint32_t> MultiplyCount(const DynamicBitMatrix &mat) const
+        {
+            if (this->cols != mat.rows)
+                throw std::runtime_error("DynamicBitMatrix::MultiplyCount: dimension mismatch.");
+
+            std::vector<uint32_t> counts(this->rows * mat.cols);
+            DynamicBitMatrix transposed = mat.Transpose();
+            Detail::BitMultiplyCount(this->rows, this->cols, mat.cols, this->words.data(), transposed.words.data(), counts.data());
+            return counts;
+        }
+
+        // Logic operators
+
+        inline DynamicBitMatrix operator&(const DynamicBitMatrix &mat) const { return And(mat); }
+        inline DynamicBitMatrix operator|(const DynamicBitMatrix &mat) const { return Or(mat); }
+        inline DynamicBitMatrix operator^(const DynamicBitMatrix &mat) const { return Xor(mat); }
+        inline DynamicBitMatrix operator*(const DynamicBitMatrix &mat) const { return Multiply(mat); }
+
+        inline DynamicBitMatrix &operator&=(const DynamicBitMatrix &mat) { this->AndInPlace(mat); return *this; }
+        inline DynamicBitMatrix &operator|=(const DynamicBitMatrix &mat) { this->OrInPlace(mat); return *this; }
+        inline DynamicBitMatrix &operator^=(const DynamicBitMatrix &mat) { this->XorInPlace(mat); return *this; }
+
+        // Identity matrix
+
+        static DynamicBitMatrix Identity(size_t size)
+        { return DynamicBitMatrix(size, size, true); }
+
+        private:
+
+        void CheckSameSize(const DynamicBitMatrix &mat, const char *message) const
+        {
+            if (this->rows != mat.rows || this->cols != mat.cols)
+                throw std::runtime_error(message);
+        }
+    };
+}
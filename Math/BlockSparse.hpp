@@ -0,0 +1,286 @@
+#pragma once
+
+#include <Math/Decomposition.hpp>
+
+namespace Scoop::Math
+{
+    // Block sparse kernels
+    //
+    // Blocks are column-major Matrix data with a compile-time size, so these loops are fully
+    // unrolled and vectorized by the compiler.
+
+    namespace Detail
+    {
+        template <typename Type, size_t Block>
+        inline void BlockMultiplyAdd(const Type *block, const Type *x, Type *y)
+        {
+            for (size_t col = 0; col < Block; col++)
+            {
+                const Type value = x[col];
+                const Type *blockCol = block + col * Block;
+
+                for (size_t row = 0; row < Block; row++)
+                    y[row] += blockCol[row] * value;
+            }
+        }
+
+        template <typename Type, size_t Block>
+        inline void BlockMultiply(const Type *block, const Type *x, Type *y)
+        {
+            std::fill(y, y + Block, Type(0));
+            BlockMultiplyAdd<Type, Block>(block, x, y);
+        }
+    }
+
+    // One block of a block sparse matrix, used for assembly
+
+    template <typename Type, size_t Block> struct BlockTriplet
+    {
+        size_t row;
+        size_t col;
+        Matrix<Type, Block, Block> block;
+    };
+
+    // Block compressed sparse row matrix
+    //
+    // Stores blockRows x blockCols blocks of Block x Block elements. The blocks of block row i are
+    // blocks[rowOffsets[i]] to blocks[rowOffsets[i + 1] - 1], sorted by their column in colIndices.
+
+    template <typename Type, size_t Block> class BlockSparseMatrix
+    {
+        public:
+
+        // Matrix structure and blocks
+
+        size_t blockRows;
+        size_t blockCols;
+        std::vector<size_t> rowOffsets;
+        std::vector<size_t> colIndices;
+        std::vector<Matrix<Type, Block, Block>> blocks;
+
+        // Constructors
+
+        BlockSparseMatrix()
+            : blockRows(0), blockCols(0), rowOffsets(1, 0)
+        { }
+
+        BlockSparseMatrix(size_t blockRows, size_t blockCols)
+            : blockRows(blockRows), blockCols(blockCols), rowOffsets(blockRows + 1, 0)
+        { }
+
+        // Assembles the matrix from triplets, summing blocks given more than once. Block rows are
+        // sorted and merged in parallel.
+
+        BlockSparseMatrix(size_t blockRows, size_t blockCols, const std::vector<BlockTriplet<Type, Block>> &triplets)
+            : blockRows(blockRows), blockCols(blockCols), rowOffsets(blockRows + 1, 0)
+        {
+            std::vector<size_t> bucketOffsets(blockRows + 1, 0);
+
+            for (const BlockTriplet<Type, Block> &triplet : triplets)
+            {
+                if (triplet.row >= blockRows || triplet.col >= blockCols)
+                    throw std::runtime_error("BlockSparseMatrix: triplet index out of range.");
+                bucketOffsets[triplet.row + 1]++;
+            }
+
+            for (size_t row = 0; row < blockRows; row++)
+                bucketOffsets[row + 1] += bucketOffsets[row];
+
+            std::vector<size_t> order(triplets.size());
+            std::vector<size_t> fill(bucketOffsets.begin(), bucketOffsets.end() - 1);
+
+            for (size_t i = 0; i < triplets.size(); i++)
+                order[fill[triplets[i].row]++] = i;
+
+            // Sort each bucket by column and count the distinct columns
+
+            ParallelFor(0, blockRows, 256, [&](size_t rowBegin, size_t rowEnd)
+            {
+                for (size_t row = rowBegin; row < rowEnd; row++)
+                {
+                    auto begin = order.begin() + bucketOffsets[row];
+                    auto end = order.begin() + bucketOffsets[row + 1];
+
+                    std::stable_sort(begin, end, [&](size_t a, size_t b) { return triplets[a].col < triplets[b].col; });
+
+                    size_t distinct = 0;
+
+                    for (auto it = begin; it != end; ++it)
+                    {
+                        if (it == begin || triplets[*it].col != triplets[*(it - 1)].col)
+                            distinct++;
+                    }
+
+                    this->rowOffsets[row + 1] = distinct;
+                }
+            });
+
+            for (size_t row = 0; row < blockRows; row++)
+                this->rowOffsets[row + 1] += this->rowOffsets[row];
+
+            this->colIndices.resize(this->rowOffsets[blockRows]);
+            this->blocks.resize(this->rowOffsets[blockRows]);
+
+            ParallelFor(0, blockRows, 256, [&](size_t rowBegin, size_t rowEnd)
+            {
+                for (size_t row = rowBegin; row < rowEnd; row++)
+                {
+                    size_t at = this->rowOffsets[row];
+
+                    for (size_t i = bucketOffsets[row]; i < bucketOffsets[row + 1]; i++)
+                    {
+                        const BlockTriplet<Type, Block> &triplet = triplets[order[i]];
+
+                        if (i > bucketOffsets[row] && triplet.col == this->colIndices[at - 1])
+                        {
+                            this->blocks[at - 1] += triplet.block;
+                        }
+                        else
+                        {
+                            this->colIndices[at] = triplet.col;
+                            this->blocks[at] = triplet.block;
+                            at++;
+                        }
+                    }
+                }
+            });
+        }
+
+        // Dimensions
+
+        size_t Rows() const
+        { return this->blockRows * Block; }
+
+        size_t Cols() const
+        { return this->blockCols * Block; }
+
+        size_t BlockCount() const
+        { return this->blocks.size(); }
+
+        // Block access, returning nullptr if the block is not stored
+
+        const Matrix<Type, Block, Block> *Find(size_t blockRow, size_t blockCol) const
+        {
+            auto begin = this->colIndices.begin() + this->rowOffsets[blockRow];
+            auto end = this->colIndices.begin() + this->rowOffsets[blockRow + 1];
+            auto it = std::lower_bound(begin, end, blockCol);
+
+            if (it == end || *it != blockCol)
+                return nullptr;
+            return &this->blocks[it - this->colIndices.begin()];
+        }
+
+        // Sparse matrix-vector product, y = A x. Block rows are split between threads.
+
+        void Multiply(const Type *x, Type *y) const
+        {
+            ParallelFor(0, this->blockRows, 512, [&](size_t rowBegin, size_t rowEnd)
+            {
+                for (size_t row = rowBegin; row < rowEnd; row++)
+                {
+                    Type *yBlock = y + row * Block;
+                    std::fill(yBlock, yBlock + Block, Type(0));
+
+                    for (size_t i = this->rowOffsets[row]; i < this->rowOffsets[row + 1]; i++)
+                        Detail::BlockMultiplyAdd<Type, Block>(this->blocks[i].data, x + this->colIndices[i] * Block, yBlock);
+                }
+            });
+        }
+
+        std::vector<Type> Multiply(const std::vector<Type> &x) const
+        {
+            if (x.size() != this->Cols())
+                throw std::runtime_error("BlockSparseMatrix::Multiply: vector size mismatch.");
+
+            std::vector<Type> y(this->Rows());
+            this->Multiply(x.data(), y.data());
+            return y;
+        }
+
+        // Sparse matrix-matrix product, Y = A X, for count column-major right-hand sides. Each block is
+        // applied to every right-hand side while it is in registers.
+
+        void Multiply(const Type *x, size_t ldx, Type *y, size_t ldy, size_t count) const
+        {
+            ParallelFor(0, this->blockRows, 512 / std::max<size_t>(count, 1) + 1, [&](size_t rowBegin, size_t rowEnd)
+            {
+                for (size_t row = rowBegin; row < rowEnd; row++)
+                {
+                    for (size_t rhs = 0; rhs < count; rhs++)
+                        std::fill(y + rhs * ldy + row * Block, y + rhs * ldy + (row + 1) * Block, Type(0));
+
+                    for (size_t i = this->rowOffsets[row]; i < this->rowOffsets[row + 1]; i++)
+                    {
+                        const Type *block = this->blocks[i].data;
+                        const size_t offset = this->colIndices[i] * Block;
+
+                        for (size_t rhs = 0; rhs < count; rhs++)
+                            Detail::BlockMultiplyAdd<Type, Block>(block, x + rhs * ldx + offset, y + rhs * ldy + row * Block);
+                    }
+                }
+            });
+        }
+    };
+
+    // Block Jacobi preconditioner
+    //
+    // Inverts each diagonal block with LUDecomposition, so applying the preconditioner is one small
+    // dense product per block row.
+
+    template <typename Type, size_t Block> class BlockJacobi
+    {
+        public:
+
+        // Inverted diagonal blocks
+
+        std::vector<Matrix<Type, Block, Block>> inverses;
+
+        // Constructors
+
+        explicit BlockJacobi(const BlockSparseMatrix<Type, Block> &mat)
+            : inverses(mat.blockRows)
+        {
+            if (mat.blockRows != mat.blockCols)
+                throw std::runtime_error("BlockJacobi: matrix must be square.");
+
+            ParallelFor(0, mat.blockRows, 256, [&](size_t rowBegin, size_t rowEnd)
+            {
+                for (size_t row = rowBegin; row < rowEnd; row++)
+                {
+                    const Matrix<Type, Block, Block> *diagonal = mat.Find(row, row);
+
+                    if (diagonal == nullptr)
+                        throw std::runtime_error("BlockJacobi: missing diagonal block.");
+
+                    LUDecomposition<Type, Block> lu(*diagonal);
+
+                    if (lu.singular)
+                        throw std::runtime_error("BlockJacobi: singular diagonal block.");
+
+                    this->inverses[row] = lu.Inverse();
+                }
+            });
+        }
+
+        // Application, z = D⁻¹ r
+
+        void Apply(const Type *r, Type *z) const
+        {
+            ParallelFor(0, this->inverses.size(), 1024, [&](size_t rowBegin, size_t rowEnd)
+            {
+                for (size_t row = rowBegin; row < rowEnd; row++)
+                    Detail::BlockMultiply<Type, Block>(this->inverses[row].data, r + row * Block, z + row * Block);
+            });
+        }
+
+        std::vector<Type> Apply(const std::vector<Type> &r) const
+        {
+            if (r.size() != this->inverses.size() * Block)
+                throw std::runtime_error("BlockJacobi::Apply: vector size mismatch.");
+
+            std::vector<Type> z(r.size());
+            this->Apply(r.data(), z.data());
+            return z;
+        }
+    };
+}
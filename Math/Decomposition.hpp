@@ -0,0 +1,1558 @@
+#pragma once
+
+#include <Math/Matrix.hpp>
+
+#include <complex>
+
+namespace Scoop::Math
+{
+    // Dense factorization kernels
+    //
+    // All kernels work in place on column-major storage with a leading dimension, so they can be
+    // applied to Matrix data as well as to blocks of larger arrays.
+
+    namespace Detail
+    {
+        constexpr size_t CholeskyBlock = 64;
+
+        // LU factorization with partial pivoting, PA = LU. Returns false if a zero pivot is found.
+
+        template <typename Type>
+        bool LUFactor(size_t n, Type *a, size_t lda, size_t *pivots)
+        {
+            bool regular = true;
+
+            for (size_t k = 0; k < n; k++)
+            {
+                Type *aCol = a + k * lda;
+                size_t pivot = k;
+                Type pivotMagnitude = std::abs(aCol[k]);
+
+                for (size_t row = k + 1; row < n; row++)
+                {
+                    if (std::abs(aCol[row]) > pivotMagnitude)
+                    {
+                        pivot = row;
+                        pivotMagnitude = std::abs(aCol[row]);
+                    }
+                }
+
+                pivots[k] = pivot;
+
+                if (pivot != k)
+                {
+                    for (size_t col = 0; col < n; col++)
+                        std::swap(a[col * lda + k], a[col * lda + pivot]);
+                }
+
+                if (aCol[k] == Type(0))
+                {
+                    regular = false;
+                    continue;
+                }
+
+                const Type inverse = Type(1) / aCol[k];
+
+                for (size_t row = k + 1; row < n; row++)
+                    aCol[row] *= inverse;
+
+                for (size_t col = k + 1; col < n; col++)
+                {
+                    Type *dst = a + col * lda;
+                    const Type scale = dst[k];
+
+                    if (scale == Type(0))
+                        continue;
+
+                    for (size_t row = k + 1; row < n; row++)
+                        dst[row] -= aCol[row] * scale;
+                }
+            }
+
+            return regular;
+        }
+
+        template <typename Type>
+        void LUSolve(size_t n, const Type *lu, size_t lda, const size_t *pivots, Type *b, size_t ldb, size_t nrhs)
+        {
+            for (size_t rhs = 0; rhs < nrhs; rhs++)
+            {
+                Type *x = b + rhs * ldb;
+
+                for (size_t k = 0; k < n; k++)
+                {
+                    if (pivots[k] != k)
+                        std::swap(x[k], x[pivots[k]]);
+                }
+
+                for (size_t col = 0; col < n; col++)
+                {
+                    const Type value = x[col];
+                    const Type *luCol = lu + col * lda;
+
+                    for (size_t row = col + 1; row < n; row++)
+                        x[row] -= luCol[row] * value;
+                }
+
+                for (size_t col = n; col-- > 0;)
+                {
+                    const Type *luCol = lu + col * lda;
+                    x[col] /= luCol[col];
+
+                    const Type value = x[col];
+
+                    for (size_t row = 0; row < col; row++)
+                        x[row] -= luCol[row] * value;
+                }
+            }
+        }
+
+        // Unblocked Cholesky factorization A = LLᵀ of the lower triangle. Returns false if the
+        // matrix is not positive definite.
+
+        template <typename Type>
+        bool CholeskyFactorUnblocked(size_t n, Type *a, size_t lda)
+        {
+            for (size_t k = 0; k < n; k++)
+            {
+                Type *aCol = a + k * lda;
+
+                if (!(aCol[k] > Type(0)))
+                    return false;
+
+                const Type diagonal = std::sqrt(aCol[k]);
+                const Type inverse = Type(1) / diagonal;
+                aCol[k] = diagonal;
+
+                for (size_t row = k + 1; row < n; row++)
+                    aCol[row] *= inverse;
+
+                for (size_t col = k + 1; col < n; col++)
+                {
+                    Type *dst = a + col * lda;
+                    const Type scale = aCol[col];
+
+                    for (size_t row = col; row < n; row++)
+                        dst[row] -= aCol[row] * scale;
+                }
+            }
+
+            return true;
+        }
+
+        // Solves X Lᵀ = B in place for the rows x cols matrix B, with L lower triangular n x n (n = cols)
+
+        template <typename Type>
+        void SolveLowerTransposeRight(size_t rows, size_t cols, const Type *l, size_t ldl, Type *b, size_t ldb)
+        {
+            for (size_t col = 0; col < cols; col++)
+            {
+                Type *bCol = b + col * ldb;
+
+                for (size_t m = 0; m < col; m++)
+                {
+                    const Type scale = l[m * ldl + col];
+                    const Type *src = b + m * ldb;
+
+                    for (size_t row = 0; row < rows; row++)
+                        bCol[row] -= src[row] * scale;
+                }
+
+                const Type inverse = Type(1) / l[col * ldl + col];
+
+                for (size_t row = 0; row < rows; row++)
+                    bCol[row] *= inverse;
+            }
+        }
+
+        // Blocked right-looking Cholesky factorization. The trailing update is a GEMM with the
+        // negated, transposed panel, so it runs on the blocked GEMM kernel.
+
+        template <typename Type>
+        bool CholeskyFactor(size_t n, Type *a, size_t lda)
+        {
+            if (n <= CholeskyBlock)
+                return CholeskyFactorUnblocked(n, a, lda);
+
+            std::vector<Type> panelTranspose;
+
+            for (size_t k = 0; k < n; k += CholeskyBlock)
+            {
+                const size_t kb = std::min(CholeskyBlock, n - k);
+                Type *diagonal = a + k * lda + k;
+
+                if (!CholeskyFactorUnblocked(kb, diagonal, lda))
+                    return false;
+
+                const size_t below = n - k - kb;
+
+                if (below == 0)
+                    break;
+
+                Type *panel = diagonal + kb;
+                SolveLowerTransposeRight(below, kb, diagonal, lda, panel, lda);
+
+                panelTranspose.resize(kb * below);
+
+                for (size_t col = 0; col < kb; col++)
+                {
+                    for (size_t row = 0; row < below; row++)
+                        panelTranspose[row * kb + col] = -panel[col * lda + row];
+                }
+
+                // Only the lower triangle of the trailing matrix is used, but updating whole
+                // column strips keeps the GEMM calls large
+
+                Type *trailing = a + (k + kb) * lda + k + kb;
+
+                for (size_t col = 0; col < below; col += CholeskyBlock)
+                {
+                    const size_t cb = std::min(CholeskyBlock, below - col);
+                    Gemm<PlusTimes>(below - col, cb, kb, panel + col, lda, panelTranspose.data() + col * kb, kb, trailing + col * lda + col, lda, true);
+                }
+            }
+
+            return true;
+        }
+
+        template <typename Type>
+        void CholeskySolve(size_t n, const Type *l, size_t lda, Type *b, size_t ldb, size_t nrhs)
+        {
+            for (size_t rhs = 0; rhs < nrhs; rhs++)
+            {
+                Type *x = b + rhs * ldb;
+
+                for (size_t col = 0; col < n; col++)
+                {
+                    const Type *lCol = l + col * lda;
+                    x[col] /= lCol[col];
+
+                    const Type value = x[col];
+
+                    for (size_t row = col + 1; row < n; row++)
+                        x[row] -= lCol[row] * value;
+                }
+
+                for (size_t col = n; col-- > 0;)
+                {
+                    const Type *lCol = l + col * lda;
+                    Type sum = x[col];
+
+                    for (size_t row = col + 1; row < n; row++)
+                        sum -= lCol[row] * x[row];
+
+                    x[col] = sum / lCol[col];
+                }
+            }
+        }
+
+        // Symmetric eigendecomposition by Householder tridiagonalization and the implicit QL
+        // algorithm. On return a holds the orthonormal eigenvectors in its columns, and values
+        // the eigenvalues in ascending order. Returns false if the iteration does not converge.
+
+        template <typename Type>
+        bool SymmetricEigen(size_t n, Type *a, size_t lda, Type *values)
+        {
+            if (n == 0)
+                return true;
+
+            auto V = [&](size_t row, size_t col) -> Type & { return a[col * lda + row]; };
+
+            std::vector<Type> e(n, Type(0));
+            Type *d = values;
+
+            for (size_t j = 0; j < n; j++)
+                d[j] = V(n - 1, j);
+
+            // Tridiagonalization
+
+            for (size_t i = n - 1; i > 0; i--)
+            {
+                Type scale = 0;
+                Type h = 0;
+
+                for (size_t k = 0; k < i; k++)
+                    scale += std::abs(d[k]);
+
+                if (scale == Type(0))
+                {
+                    e[i] = d[i - 1];
+
+                    for (size_t j = 0; j < i; j++)
+                    {
+                        d[j] = V(i - 1, j);
+                        V(i, j) = 0;
+                        V(j, i) = 0;
+                    }
+                }
+                else
+                {
+                    for (size_t k = 0; k < i; k++)
+                    {
+                        d[k] /= scale;
+                        h += d[k] * d[k];
+                    }
+
+                    Type f = d[i - 1];
+                    Type g = std::sqrt(h);
+
+                    if (f > 0)
+                        g = -g;
+
+                    e[i] = scale * g;
+                    h -= f * g;
+                    d[i - 1] = f - g;
+
+                    for (size_t j = 0; j < i; j++)
+                        e[j] = 0;
+
+                    for (size_t j = 0; j < i; j++)
+                    {
+                        f = d[j];
+                        V(j, i) = f;
+                        g = e[j] + V(j, j) * f;
+
+                        for (size_t k = j + 1; k < i; k++)
+                        {
+                            g += V(k, j) * d[k];
+                            e[k] += V(k, j) * f;
+                        }
+
+                        e[j] = g;
+                    }
+
+                    f = 0;
+
+                    for (size_t j = 0; j < i; j++)
+                    {
+                        e[j] /= h;
+                        f += e[j] * d[j];
+                    }
+
+                    const Type hh = f / (h + h);
+
+                    for (size_t j = 0; j < i; j++)
+                        e[j] -= hh * d[j];
+
+                    for (size_t j = 0; j < i; j++)
+                    {
+                        f = d[j];
+                        g = e[j];
+
+                        for (size_t k = j; k < i; k++)
+                            V(k, j) -= f * e[k] + g * d[k];
+
+                        d[j] = V(i - 1, j);
+                        V(i, j) = 0;
+                    }
+                }
+
+                d[i] = h;
+            }
+
+            // Accumulation of the transformations
+
+            for (size_t i = 0; i + 1 < n; i++)
+            {
+                V(n - 1, i) = V(i, i);
+                V(i, i) = 1;
+
+                const Type h = d[i + 1];
+
+                if (h != Type(0))
+                {
+                    for (size_t k = 0; k <= i; k++)
+                        d[k] = V(k, i + 1) / h;
+
+                    for (size_t j = 0; j <= i; j++)
+                    {
+                        Type g = 0;
+
+                        for (size_t k = 0; k <= i; k++)
+                            g += V(k, i + 1) * V(k, j);
+                        for (size_t k = 0; k <= i; k++)
+                            V(k, j) -= g * d[k];
+                    }
+                }
+
+                for (size_t k = 0; k <= i; k++)
+                    V(k, i + 1) = 0;
+            }
+
+            for (size_t j = 0; j < n; j++)
+            {
+                d[j] = V(n - 1, j);
+                V(n - 1, j) = 0;
+            }
+
+            V(n - 1, n - 1) = 1;
+
+            // Implicit QL iterations on the tridiagonal matrix
+
+            for (size_t i = 1; i < n; i++)
+                e[i - 1] = e[i];
+
+            e[n - 1] = 0;
+
+            const Type eps = std::numeric_limits<Type>::epsilon();
+            Type f = 0;
+            Type tst1 = 0;
+
+            for (size_t l = 0; l < n; l++)
+            {
+                tst1 = std::max(tst1, std::abs(d[l]) + std::abs(e[l]));
+                size_t m = l;
+
+                while (m < n && std::abs(e[m]) > eps * tst1)
+                    m++;
+
+                if (m > l)
+                {
+                    size_t iterations = 0;
+
+                    do
+                    {
+                        if (++iterations > 60)
+                            return false;
+
+                        Type g = d[l];
+                        Type p = (d[l + 1] - g) / (2 * e[l]);
+                        Type r = std::hypot(p, Type(1));
+
+                        if (p < 0)
+                            r = -r;
+
+                        d[l] = e[l] / (p + r);
+                        d[l + 1] = e[l] * (p + r);
+
+                        const Type dl1 = d[l + 1];
+                        Type h = g - d[l];
+
+                        for (size_t i = l + 2; i < n; i++)
+                            d[i] -= h;
+
+                        f += h;
+                        p = d[m];
+
+                        Type c = 1, c2 = 1, c3 = 1, s = 0, s2 = 0;
+                        const Type el1 = e[l + 1];
+
+                        for (size_t i = m; i-- > l;)
+                        {
+                            c3 = c2;
+                            c2 = c;
+                            s2 = s;
+                            g = c * e[i];
+                            h = c * p;
+                            r = std::hypot(p, e[i]);
+                            e[i + 1] = s * r;
+                            s = e[i] / r;
+                            c = p / r;
+                            p = c * d[i] - s * g;
+                            d[i + 1] = h + s * (c * g + s * d[i]);
+
+                            Type *left = a + i * lda;
+                            Type *right = a + (i + 1) * lda;
+
+                            for (size_t k = 0; k < n; k++)
+                            {
+                                h = right[k];
+                                right[k] = s * left[k] + c * h;
+                                left[k] = c * left[k] - s * h;
+                            }
+                        }
+
+                        p = -s * s2 * c3 * el1 * e[l] / dl1;
+                        e[l] = s * p;
+                        d[l] = c * p;
+                    }
+                    while (std::abs(e[l]) > eps * tst1);
+                }
+
+                d[l] += f;
+                e[l] = 0;
+            }
+
+            // Ascending order
+
+            for (size_t i = 0; i + 1 < n; i++)
+            {
+                size_t k = i;
+
+                for (size_t j = i + 1; j < n; j++)
+                {
+                    if (d[j] < d[k])
+                        k = j;
+                }
+
+                if (k != i)
+                {
+                    std::swap(d[i], d[k]);
+                    std::swap_ranges(a + i * lda, a + i * lda + n, a + k * lda);
+                }
+            }
+
+            return true;
+        }
+
+        // Reduction to upper Hessenberg form by Householder reflections, A = QHQᵀ. h is reduced in
+        // place and q receives Q.
+
+        template <typename Type>
+        void HessenbergReduce(size_t n, Type *h, size_t ldh, Type *q, size_t ldq)
+        {
+            auto H = [&](size_t row, size_t col) -> Type & { return h[col * ldh + row]; };
+            auto Q = [&](size_t row, size_t col) -> Type & { return q[col * ldq + row]; };
+
+            std::vector<Type> ort(n, Type(0));
+
+            for (size_t m = 1; m + 1 < n; m++)
+            {
+                Type scale = 0;
+
+                for (size_t i = m; i < n; i++)
+                    scale += std::abs(H(i, m - 1));
+
+                if (scale == Type(0))
+                    continue;
+
+                Type hh = 0;
+
+                for (size_t i = n; i-- > m;)
+                {
+                    ort[i] = H(i, m - 1) / scale;
+                    hh += ort[i] * ort[i];
+                }
+
+                Type g = std::sqrt(hh);
+
+                if (ort[m] > 0)
+                    g = -g;
+
+                hh -= ort[m] * g;
+                ort[m] -= g;
+
+                for (size_t j = m; j < n; j++)
+                {
+                    Type f = 0;
+
+                    for (size_t i = n; i-- > m;)
+                        f += ort[i] * H(i, j);
+
+                    f /= hh;
+
+                    for (size_t i = m; i < n; i++)
+                        H(i, j) -= f * ort[i];
+                }
+
+                for (size_t i = 0; i < n; i++)
+                {
+                    Type f = 0;
+
+                    for (size_t j = n; j-- > m;)
+                        f += ort[j] * H(i, j);
+
+                    f /= hh;
+
+                    for (size_t j = m; j < n; j++)
+                        H(i, j) -= f * ort[j];
+                }
+
+                ort[m] *= scale;
+                H(m, m - 1) = scale * g;
+            }
+
+            for (size_t col = 0; col < n; col++)
+            {
+                for (size_t row = 0; row < n; row++)
+                    Q(row, col) = row == col ? Type(1) : Type(0);
+            }
+
+            for (size_t m = n >= 2 ? n - 2 : 0; m >= 1 && m + 1 < n; m--)
+            {
+                if (H(m, m - 1) != Type(0))
+                {
+                    for (size_t i = m + 1; i < n; i++)
+                        ort[i] = H(i, m - 1);
+
+                    for (size_t j = m; j < n; j++)
+                    {
+                        Type g = 0;
+
+                        for (size_t i = m; i < n; i++)
+                            g += ort[i] * Q(i, j);
+
+                        g = (g / ort[m]) / H(m, m - 1);
+
+                        for (size_t i = m; i < n; i++)
+                            Q(i, j) += g * ort[i];
+                    }
+                }
+            }
+
+            for (size_t col = 0; col < n; col++)
+            {
+                for (size_t row = col + 2; row < n; row++)
+                    H(row, col) = 0;
+            }
+        }
+
+        // Real Schur form of an upper Hessenberg matrix by the Francis double-shift QR algorithm.
+        // h becomes quasi-upper triangular T, with 2 x 2 diagonal blocks for complex conjugate
+        // pairs, and z is multiplied by the Schur vectors (pass Q from HessenbergReduce to get
+        // A = ZTZᵀ). Eigenvalues are returned in real and imag; the first of each complex pair has
+        // a positive imaginary part. Returns false if the iteration does not converge.
+
+        template <typename Type>
+        bool RealSchur(size_t size, Type *h, size_t ldh, Type *z, size_t ldz, Type *real, Type *imag)
+        {
+            auto H = [&](ptrdiff_t row, ptrdiff_t col) -> Type & { return h[col * (ptrdiff_t)ldh + row]; };
+            auto Z = [&](ptrdiff_t row, ptrdiff_t col) -> Type & { return z[col * (ptrdiff_t)ldz + row]; };
+
+            const ptrdiff_t nn = (ptrdiff_t)size;
+            const Type eps = std::numeric_limits<Type>::epsilon();
+            ptrdiff_t n = nn - 1;
+            Type exshift = 0;
+            Type p = 0, q = 0, r = 0, s = 0, w = 0, x = 0, y = 0, zz = 0;
+            Type norm = 0;
+
+            for (ptrdiff_t i = 0; i < nn; i++)
+            {
+                for (ptrdiff_t j = std::max<ptrdiff_t>(i - 1, 0); j < nn; j++)
+                    norm += std::abs(H(i, j));
+            }
+
+            size_t iterations = 0;
+            size_t totalIterations = 0;
+
+            while (n >= 0)
+            {
+                // Look for a single small subdiagonal element
+
+                ptrdiff_t l = n;
+
+                while (l > 0)
+                {
+                    s = std::abs(H(l - 1, l - 1)) + std::abs(H(l, l));
+
+                    if (s == Type(0))
+                        s = norm;
+                    if (std::abs(H(l, l - 1)) < eps * s)
+                        break;
+                    l--;
+                }
+
+                if (l == n)
+                {
+                    // One root found
+
+                    H(n, n) += exshift;
+                    real[n] = H(n, n);
+                    imag[n] = 0;
+
+                    if (n > 0)
+                        H(n, n - 1) = 0;
+
+                    n--;
+                    iterations = 0;
+                }
+                else if (l == n - 1)
+                {
+                    // Two roots found
+
+                    w = H(n, n - 1) * H(n - 1, n);
+                    p = (H(n - 1, n - 1) - H(n, n)) / 2;
+                    q = p * p + w;
+                    zz = std::sqrt(std::abs(q));
+                    H(n, n) += exshift;
+                    H(n - 1, n - 1) += exshift;
+                    x = H(n, n);
+
+                    if (q >= 0)
+                    {
+                        // Real pair, split by a rotation
+
+                        zz = p >= 0 ? p + zz : p - zz;
+                        real[n - 1] = x + zz;
+                        real[n] = zz != Type(0) ? x - w / zz : real[n - 1];
+                        imag[n - 1] = 0;
+                        imag[n] = 0;
+
+                        x = H(n, n - 1);
+                        s = std::abs(x) + std::abs(zz);
+                        p = x / s;
+                        q = zz / s;
+                        r = std::sqrt(p * p + q * q);
+                        p /= r;
+                        q /= r;
+
+                        for (ptrdiff_t j = n - 1; j < nn; j++)
+                        {
+                            zz = H(n - 1, j);
+                            H(n - 1, j) = q * zz + p * H(n, j);
+                            H(n, j) = q * H(n, j) - p * zz;
+                        }
+
+                        for (ptrdiff_t i = 0; i <= n; i++)
+                        {
+                            zz = H(i, n - 1);
+                            H(i, n - 1) = q * zz + p * H(i, n);
+                            H(i, n) = q * H(i, n) - p * zz;
+                        }
+
+                        for (ptrdiff_t i = 0; i < nn; i++)
+                        {
+                            zz = Z(i, n - 1);
+                            Z(i, n - 1) = q * zz + p * Z(i, n);
+                            Z(i, n) = q * Z(i, n) - p * zz;
+                        }
+
+                        H(n, n - 1) = 0;
+                    }
+                    else
+                    {
+                        // Complex pair
+
+                        real[n - 1] = x + p;
+                        real[n] = x + p;
+                        imag[n - 1] = zz;
+                        imag[n] = -zz;
+                    }
+
+                    n -= 2;
+                    iterations = 0;
+                }
+                else
+                {
+                    if (++totalIterations > 40 * size)
+                        return false;
+
+                    // Form the shift
+
+                    x = H(n, n);
+                    y = 0;
+                    w = 0;
+
+                    if (l < n)
+                    {
+                        y = H(n - 1, n - 1);
+                        w = H(n, n - 1) * H(n - 1, n);
+                    }
+
+                    // Exceptional shifts
+
+                    if (iterations == 10)
+                    {
+                        exshift += x;
+
+                        for (ptrdiff_t i = 0; i <= n; i++)
+                            H(i, i) -= x;
+
+                        s = std::abs(H(n, n - 1)) + std::abs(H(n - 1, n - 2));
+                        x = y = Type(0.75) * s;
+                        w = Type(-0.4375) * s * s;
+                    }
+
+                    if (iterations == 30)
+                    {
+                        s = (y - x) / 2;
+                        s = s * s + w;
+
+                        if (s > 0)
+                        {
+                            s = std::sqrt(s);
+
+                            if (y < x)
+                                s = -s;
+
+                            s = x - w / ((y - x) / 2 + s);
+
+                            for (ptrdiff_t i = 0; i <= n; i++)
+                                H(i, i) -= s;
+
+                            exshift += s;
+                            x = y = w = Type(0.964);
+                        }
+                    }
+
+                    iterations++;
+
+                    // Look for two consecutive small subdiagonal elements
+
+                    ptrdiff_t m = n - 2;
+
+                    while (m >= l)
+                    {
+                        zz = H(m, m);
+                        r = x - zz;
+                        s = y - zz;
+                        p = (r * s - w) / H(m + 1, m) + H(m, m + 1);
+                        q = H(m + 1, m + 1) - zz - r - s;
+                        r = H(m + 2, m + 1);
+                        s = std::abs(p) + std::abs(q) + std::abs(r);
+                        p /= s;
+                        q /= s;
+                        r /= s;
+
+                        if (m == l)
+                            break;
+
+                        if (std::abs(H(m, m - 1)) * (std::abs(q) + std::abs(r)) <
+                            eps * (std::abs(p) * (std::abs(H(m - 1, m - 1)) + std::abs(zz) + std::abs(H(m + 1, m + 1)))))
+                            break;
+
+                        m--;
+                    }
+
+                    for (ptrdiff_t i = m + 2; i <= n; i++)
+                    {
+                        H(i, i - 2) = 0;
+
+                        if (i > m + 2)
+                            H(i, i - 3) = 0;
+                    }
+
+                    // Double QR step on rows l to n and columns m to n
+
+                    for (ptrdiff_t k = m; k <= n - 1; k++)
+                    {
+                        const bool notLast = k != n - 1;
+
+                        if (k != m)
+                        {
+                            p = H(k, k - 1);
+                            q = H(k + 1, k - 1);
+                            r = notLast ? H(k + 2, k - 1) : Type(0);
+                            x = std::abs(p) + std::abs(q) + std::abs(r);
+
+                            if (x == Type(0))
+                                continue;
+
+                            p /= x;
+                            q /= x;
+                            r /= x;
+                        }
+
+                        s = std::sqrt(p * p + q * q + r * r);
+
+                        if (p < 0)
+                            s = -s;
+
+                        if (s == Type(0))
+                            continue;
+
+                        if (k != m)
+                            H(k, k - 1) = -s * x;
+                        else if (l != m)
+                            H(k, k - 1) = -H(k, k - 1);
+
+                        p += s;
+                        x = p / s;
+                        y = q / s;
+                        zz = r / s;
+                        q /= p;
+                        r /= p;
+
+                        for (ptrdiff_t j = k; j < nn; j++)
+                        {
+                            p = H(k, j) + q * H(k + 1, j);
+
+                            if (notLast)
+                            {
+                                p += r * H(k + 2, j);
+                                H(k + 2, j) -= p * zz;
+                            }
+
+                            H(k, j) -= p * x;
+                            H(k + 1, j) -= p * y;
+                        }
+
+                        for (ptrdiff_t i = 0; i <= std::min(n, k + 3); i++)
+                        {
+                            p = x * H(i, k) + y * H(i, k + 1);
+
+                            if (notLast)
+                            {
+                                p += zz * H(i, k + 2);
+                                H(i, k + 2) -= p * r;
+                            }
+
+                            H(i, k) -= p;
+                            H(i, k + 1) -= p * q;
+                        }
+
+                        for (ptrdiff_t i = 0; i < nn; i++)
+                        {
+                            p = x * Z(i, k) + y * Z(i, k + 1);
+
+                            if (notLast)
+                            {
+                                p += zz * Z(i, k + 2);
+                                Z(i, k + 2) -= p * r;
+                            }
+
+                            Z(i, k) -= p;
+                            Z(i, k + 1) -= p * q;
+                        }
+                    }
+                }
+            }
+
+            for (ptrdiff_t col = 0; col < nn; col++)
+            {
+                for (ptrdiff_t row = col + 2; row < nn; row++)
+                    H(row, col) = 0;
+            }
+
+            return true;
+        }
+
+        // Eigenvectors from a real Schur form A = ZTZᵀ. t is overwritten, and z receives the
+        // eigenvectors: column j for a real eigenvalue, or columns j and j + 1 holding the real and
+        // imaginary parts of the eigenvector of real[j] + i imag[j] for a complex pair.
+
+        template <typename Type>
+        void SchurEigenvectors(size_t size, Type *t, size_t ldt, Type *z, size_t ldz, const Type *real, const Type *imag)
+        {
+            auto H = [&](ptrdiff_t row, ptrdiff_t col) -> Type & { return t[col * (ptrdiff_t)ldt + row]; };
+            auto Z = [&](ptrdiff_t row, ptrdiff_t col) -> Type & { return z[col * (ptrdiff_t)ldz + row]; };
+            auto divide = [](Type xr, Type xi, Type yr, Type yi)
+            { return std::complex<Type>(xr, xi) / std::complex<Type>(yr, yi); };
+
+            const ptrdiff_t nn = (ptrdiff_t)size;
+            const Type eps = std::numeric_limits<Type>::epsilon();
+            Type norm = 0;
+
+            for (ptrdiff_t i = 0; i < nn; i++)
+            {
+                for (ptrdiff_t j = std::max<ptrdiff_t>(i - 1, 0); j < nn; j++)
+                    norm += std::abs(H(i, j));
+            }
+
+            if (norm == Type(0))
+                return;
+
+            Type p, q, r = 0, s = 0, w, x, y, zz = 0, tt;
+
+            for (ptrdiff_t n = nn - 1; n >= 0; n--)
+            {
+                p = real[n];
+                q = imag[n];
+
+                if (q == Type(0))
+                {
+                    // Real vector
+
+                    ptrdiff_t l = n;
+                    H(n, n) = 1;
+
+                    for (ptrdiff_t i = n - 1; i >= 0; i--)
+                    {
+                        w = H(i, i) - p;
+                        r = 0;
+
+                        for (ptrdiff_t j = l; j <= n; j++)
+                            r += H(i, j) * H(j, n);
+
+                        if (imag[i] < 0)
+                        {
+                            zz = w;
+                            s = r;
+                            continue;
+                        }
+
+                        l = i;
+
+                        if (imag[i] == Type(0))
+                        {
+                            H(i, n) = w != Type(0) ? -r / w : -r / (eps * norm);
+                        }
+                        else
+                        {
+                            x = H(i, i + 1);
+                            y = H(i + 1, i);
+                            q = (real[i] - p) * (real[i] - p) + imag[i] * imag[i];
+                            tt = (x * s - zz * r) / q;
+                            H(i, n) = tt;
+                            H(i + 1, n) = std::abs(x) > std::abs(zz) ? (-r - w * tt) / x : (-s - y * tt) / zz;
+                        }
+
+                        tt = std::abs(H(i, n));
+
+                        if ((eps * tt) * tt > 1)
+                        {
+                            for (ptrdiff_t j = i; j <= n; j++)
+                                H(j, n) /= tt;
+                        }
+                    }
+                }
+                else if (q < 0)
+                {
+                    // Complex vector, stored in columns n - 1 and n
+
+                    ptrdiff_t l = n - 1;
+
+                    if (std::abs(H(n, n - 1)) > std::abs(H(n - 1, n)))
+                    {
+                        H(n - 1, n - 1) = q / H(n, n - 1);
+                        H(n - 1, n) = -(H(n, n) - p) / H(n, n - 1);
+                    }
+                    else
+                    {
+                        std::complex<Type> c = divide(0, -H(n - 1, n), H(n - 1, n - 1) - p, q);
+                        H(n - 1, n - 1) = c.real();
+                        H(n - 1, n) = c.imag();
+                    }
+
+                    H(n, n - 1) = 0;
+                    H(n, n) = 1;
+
+                    for (ptrdiff_t i = n - 2; i >= 0; i--)
+                    {
+                        Type ra = 0, sa = 0;
+
+                        for (ptrdiff_t j = l; j <= n; j++)
+                        {
+                            ra += H(i, j) * H(j, n - 1);
+                            sa += H(i, j) * H(j, n);
+                        }
+
+                        w = H(i, i) - p;
+
+                        if (imag[i] < 0)
+                        {
+                            zz = w;
+                            r = ra;
+                            s = sa;
+                            continue;
+                        }
+
+                        l = i;
+
+                        if (imag[i] == Type(0))
+                        {
+                            std::complex<Type> c = divide(-ra, -sa, w, q);
+                            H(i, n - 1) = c.real();
+                            H(i, n) = c.imag();
+                        }
+                        else
+                        {
+                            x = H(i, i + 1);
+                            y = H(i + 1, i);
+                            Type vr = (real[i] - p) * (real[i] - p) + imag[i] * imag[i] - q * q;
+                            Type vi = (real[i] - p) * 2 * q;
+
+                            if (vr == Type(0) && vi == Type(0))
+                                vr = eps * norm * (std::abs(w) + std::abs(q) + std::abs(x) + std::abs(y) + std::abs(zz));
+
+                            std::complex<Type> c = divide(x * r - zz * ra + q * sa, x * s - zz * sa - q * ra, vr, vi);
+                            H(i, n - 1) = c.real();
+                            H(i, n) = c.imag();
+
+                            if (std::abs(x) > std::abs(zz) + std::abs(q))
+                            {
+                                H(i + 1, n - 1) = (-ra - w * H(i, n - 1) + q * H(i, n)) / x;
+                                H(i + 1, n) = (-sa - w * H(i, n) - q * H(i, n - 1)) / x;
+                            }
+                            else
+                            {
+                                c = divide(-r - y * H(i, n - 1), -s - y * H(i, n), zz, q);
+                                H(i + 1, n - 1) = c.real();
+                                H(i + 1, n) = c.imag();
+                            }
+                        }
+
+                        tt = std::max(std::abs(H(i, n - 1)), std::abs(H(i, n)));
+
+                        if ((eps * tt) * tt > 1)
+                        {
+                            for (ptrdiff_t j = i; j <= n; j++)
+                            {
+                                H(j, n - 1) /= tt;
+                                H(j, n) /= tt;
+                            }
+                        }
+                    }
+                }
+            }
+
+            // Back transformation, Z = Z * U with U the upper triangular eigenvectors of T
+
+            std::vector<Type> row(size);
+
+            for (ptrdiff_t i = 0; i < nn; i++)
+            {
+                for (ptrdiff_t j = 0; j < nn; j++)
+                {
+                    Type sum = 0;
+
+                    for (ptrdiff_t k = 0; k <= j; k++)
+                        sum += Z(i, k) * H(k, j);
+
+                    row[j] = sum;
+                }
+
+                for (ptrdiff_t j = 0; j < nn; j++)
+                    Z(i, j) = row[j];
+            }
+        }
+
+        // Householder QR, A = QR, for rows >= cols. R is left in the upper triangle and the
+        // Householder vectors (with an implicit leading 1) below it, with their scales in tau.
+
+        template <typename Type>
+        void QRFactor(size_t rows, size_t cols, Type *a, size_t lda, Type *tau)
+        {
+            for (size_t k = 0; k < cols; k++)
+            {
+                Type *col = a + k * lda;
+                Type norm = 0;
+
+                for (size_t row = k; row < rows; row++)
+                    norm += col[row] * col[row];
+
+                norm = std::sqrt(norm);
+
+                if (norm == Type(0))
+                {
+                    tau[k] = 0;
+                    continue;
+                }
+
+                const Type alpha = col[k];
+                const Type beta = alpha >= 0 ? -norm : norm;
+                const Type scale = 1 / (alpha - beta);
+
+                tau[k] = (beta - alpha) / beta;
+                col[k] = beta;
+
+                for (size_t row = k + 1; row < rows; row++)
+                    col[row] *= scale;
+
+                for (size_t j = k + 1; j < cols; j++)
+                {
+                    Type *other = a + j * lda;
+                    Type dot = other[k];
+
+                    for (size_t row = k + 1; row < rows; row++)
+                        dot += col[row] * other[row];
+
+                    dot *= tau[k];
+                    other[k] -= dot;
+
+                    for (size_t row = k + 1; row < rows; row++)
+                        other[row] -= dot * col[row];
+                }
+            }
+        }
+
+        // Overwrites a factored by QRFactor with the first cols columns of Q
+
+        template <typename Type>
+        void QRFormQ(size_t rows, size_t cols, Type *a, size_t lda, const Type *tau)
+        {
+            for (size_t k = cols; k-- > 0;)
+            {
+                Type *col = a + k * lda;
+
+                for (size_t j = k + 1; j < cols; j++)
+                {
+                    Type *other = a + j * lda;
+                    Type dot = 0;
+
+                    for (size_t row = k + 1; row < rows; row++)
+                        dot += col[row] * other[row];
+
+                    dot *= tau[k];
+                    other[k] = -dot;
+
+                    for (size_t row = k + 1; row < rows; row++)
+                        other[row] -= dot * col[row];
+                }
+
+                for (size_t row = k + 1; row < rows; row++)
+                    col[row] *= -tau[k];
+
+                col[k] = 1 - tau[k];
+
+                for (size_t row = 0; row < k; row++)
+                    col[row] = 0;
+            }
+        }
+
+        // Singular value decomposition by one-sided Jacobi rotations, A = UΣVᵀ, for rows >= cols.
+        // Columns of a are rotated until they are mutually orthogonal; on return a holds U, s the
+        // singular values in descending order and v the right singular vectors. Columns of U for
+        // zero singular values are zero. Returns false if the rotations do not converge.
+
+        template <typename Type>
+        bool JacobiSVD(size_t rows, size_t cols, Type *a, size_t lda, Type *s, Type *v, size_t ldv)
+        {
+            const Type eps = std::numeric_limits<Type>::epsilon();
+            bool rotated = true;
+            Type total = 0;
+
+            for (size_t col = 0; col < cols; col++)
+            {
+                for (size_t row = 0; row < cols; row++)
+                    v[col * ldv + row] = row == col ? Type(1) : Type(0);
+
+                for (size_t row = 0; row < rows; row++)
+                    total += a[col * lda + row] * a[col * lda + row];
+            }
+
+            // Columns below rounding level of the whole matrix (left by cancellation) are taken as
+            // converged, since rotating them against a large column only exchanges rounding errors
+
+            const Type negligible = eps * eps * total;
+
+            for (size_t sweep = 0; sweep < 60 && rotated; sweep++)
+            {
+                rotated = false;
+
+                for (size_t p = 0; p + 1 < cols; p++)
+                {
+                    for (size_t q = p + 1; q < cols; q++)
+                    {
+                        Type *ap = a + p * lda;
+                        Type *aq = a + q * lda;
+                        Type alpha = 0, beta = 0, gamma = 0;
+
+                        for (size_t row = 0; row < rows; row++)
+                        {
+                            alpha += ap[row] * ap[row];
+                            beta += aq[row] * aq[row];
+                            gamma += ap[row] * aq[row];
+                        }
+
+                        if (std::abs(gamma) <= eps * std::sqrt(alpha * beta) || std::min(alpha, beta) <= negligible)
+                            continue;
+
+                        rotated = true;
+
+                        const Type zeta = (beta - alpha) / (2 * gamma);
+                        const Type t = (zeta >= 0 ? Type(1) : Type(-1)) / (std::abs(zeta) + std::sqrt(1 + zeta * zeta));
+                        const Type c = 1 / std::sqrt(1 + t * t);
+                        const Type sn = c * t;
+
+                        for (size_t row = 0; row < rows; row++)
+                        {
+                            const Type x = ap[row];
+                            ap[row] = c * x - sn * aq[row];
+                            aq[row] = sn * x + c * aq[row];
+                        }
+
+                        Type *vp = v + p * ldv;
+                        Type *vq = v + q * ldv;
+
+                        for (size_t row = 0; row < cols; row++)
+                        {
+                            const Type x = vp[row];
+                            vp[row] = c * x - sn * vq[row];
+                            vq[row] = sn * x + c * vq[row];
+                        }
+                    }
+                }
+            }
+
+            for (size_t col = 0; col < cols; col++)
+            {
+                Type *ac = a + col * lda;
+                Type norm = 0;
+
+                for (size_t row = 0; row < rows; row++)
+                    norm += ac[row] * ac[row];
+
+                s[col] = std::sqrt(norm);
+
+                if (s[col] != Type(0))
+                {
+                    for (size_t row = 0; row < rows; row++)
+                        ac[row] /= s[col];
+                }
+            }
+
+            // Descending order
+
+            for (size_t i = 0; i + 1 < cols; i++)
+            {
+                size_t k = i;
+
+                for (size_t j = i + 1; j < cols; j++)
+                {
+                    if (s[j] > s[k])
+                        k = j;
+                }
+
+                if (k != i)
+                {
+                    std::swap(s[i], s[k]);
+                    std::swap_ranges(a + i * lda, a + i * lda + rows, a + k * lda);
+                    std::swap_ranges(v + i * ldv, v + i * ldv + cols, v + k * ldv);
+                }
+            }
+
+            return !rotated;
+        }
+    }
+
+    // LU decomposition with partial pivoting
+
+    template <typename Type, size_t Size> class LUDecomposition
+    {
+        public:
+
+        // Factors, stored in place of the matrix (unit lower triangle below the diagonal)
+
+        Matrix<Type, Size, Size> lu;
+        size_t pivots[Size];
+        bool singular;
+
+        // Constructors
+
+        explicit LUDecomposition(const Matrix<Type, Size, Size> &mat)
+            : lu(mat)
+        { this->singular = !Detail::LUFactor(Size, this->lu.data, Size, this->pivots); }
+
+        // Solving
+
+        Vector<Type, Size> Solve(const Vector<Type, Size> &vec) const
+        {
+            if (this->singular)
+                throw std::runtime_error("LUDecomposition::Solve: matrix is singular.");
+
+            Vector<Type, Size> newVec(vec);
+            Detail::LUSolve(Size, this->lu.data, Size, this->pivots, newVec.data, Size, 1);
+            return newVec;
+        }
+
+        template <size_t Cols> Matrix<Type, Size, Cols> Solve(const Matrix<Type, Size, Cols> &mat) const
+        {
+            if (this->singular)
+                throw std::runtime_error("LUDecomposition::Solve: matrix is singular.");
+
+            Matrix<Type, Size, Cols> newMat(mat);
+            Detail::LUSolve(Size, this->lu.data, Size, this->pivots, newMat.data, Size, Cols);
+            return newMat;
+        }
+
+        Matrix<Type, Size, Size> Inverse() const
+        { return this->Solve(Matrix<Type, Size, Size>::Identity()); }
+
+        Type Determinant() const
+        {
+            Type determinant = 1;
+
+            for (size_t i = 0; i < Size; i++)
+            {
+                determinant *= this->lu.data[i * Size + i];
+                if (this->pivots[i] != i)
+                    determinant = -determinant;
+            }
+
+            return determinant;
+        }
+    };
+
+    // Cholesky decomposition of a symmetric positive definite matrix, A = LLᵀ
+
+    template <typename Type, size_t Size> class CholeskyDecomposition
+    {
+        public:
+
+        // Factor, stored in the lower triangle (the strict upper triangle is unspecified)
+
+        Matrix<Type, Size, Size> l;
+        bool positiveDefinite;
+
+        // Constructors
+
+        explicit CholeskyDecomposition(const Matrix<Type, Size, Size> &mat)
+            : l(mat)
+        { this->positiveDefinite = Detail::CholeskyFactor(Size, this->l.data, Size); }
+
+        // Solving
+
+        Vector<Type, Size> Solve(const Vector<Type, Size> &vec) const
+        {
+            if (!this->positiveDefinite)
+                throw std::runtime_error("CholeskyDecomposition::Solve: matrix is not positive definite.");
+
+            Vector<Type, Size> newVec(vec);
+            Detail::CholeskySolve(Size, this->l.data, Size, newVec.data, Size, 1);
+            return newVec;
+        }
+
+        template <size_t Cols> Matrix<Type, Size, Cols> Solve(const Matrix<Type, Size, Cols> &mat) const
+        {
+            if (!this->positiveDefinite)
+                throw std::runtime_error("CholeskyDecomposition::Solve: matrix is not positive definite.");
+
+            Matrix<Type, Size, Cols> newMat(mat);
+            Detail::CholeskySolve(Size, this->l.data, Size, newMat.data, Size, Cols);
+            return newMat;
+        }
+
+        Matrix<Type, Size, Size> Inverse() const
+        { return this->Solve(Matrix<Type, Size, Size>::Identity()); }
+
+        Matrix<Type, Size, Size> Lower() const
+        {
+            Matrix<Type, Size, Size> lower(this->l);
+
+            for (size_t col = 1; col < Size; col++)
+            {
+                for (size_t row = 0; row < col; row++)
+                    lower.data[col * Size + row] = 0;
+            }
+
+            return lower;
+        }
+    };
+
+    // Eigendecomposition of a symmetric matrix, A = VΛVᵀ
+
+    template <typename Type, size_t Size> class SymmetricEigenDecomposition
+    {
+        public:
+
+        // Eigenvalues in ascending order and the orthonormal eigenvectors in matching columns
+
+        Vector<Type, Size> values;
+        Matrix<Type, Size, Size> vectors;
+        bool converged;
+
+        // Constructors
+
+        explicit SymmetricEigenDecomposition(const Matrix<Type, Size, Size> &mat)
+            : vectors(mat)
+        { this->converged = Detail::SymmetricEigen(Size, this->vectors.data, Size, this->values.data); }
+    };
+
+    // Real Schur decomposition of a general matrix, A = ZTZᵀ
+    //
+    // T is quasi-upper triangular, with a 2 x 2 diagonal block for each complex conjugate pair of
+    // eigenvalues, and Z is orthogonal.
+
+    template <typename Type, size_t Size> class SchurDecomposition
+    {
+        public:
+
+        // Factors and eigenvalues (the first of each complex pair has a positive imaginary part)
+
+        Matrix<Type, Size, Size> t;
+        Matrix<Type, Size, Size> z;
+        Vector<Type, Size> realValues;
+        Vector<Type, Size> imagValues;
+        bool converged;
+
+        // Constructors
+
+        explicit SchurDecomposition(const Matrix<Type, Size, Size> &mat)
+            : t(mat)
+        {
+            Detail::HessenbergReduce(Size, this->t.data, Size, this->z.data, Size);
+            this->converged = Detail::RealSchur(Size, this->t.data, Size, this->z.data, Size, this->realValues.data, this->imagValues.data);
+        }
+
+        // Eigenvectors, with the real and imaginary parts of a complex pair in consecutive columns
+
+        Matrix<Type, Size, Size> Eigenvectors() const
+        {
+            if (!this->converged)
+                throw std::runtime_error("SchurDecomposition::Eigenvectors: iteration did not converge.");
+
+            Matrix<Type, Size, Size> triangle(this->t);
+            Matrix<Type, Size, Size> vectors(this->z);
+            Detail::SchurEigenvectors(Size, triangle.data, Size, vectors.data, Size, this->realValues.data, this->imagValues.data);
+            return vectors;
+        }
+    };
+
+    // QR decomposition by Householder reflections, A = QR, for Rows >= Cols
+
+    template <typename Type, size_t Rows, size_t Cols> class QRDecomposition
+    {
+        static_assert(Rows >= Cols, "QRDecomposition requires at least as many rows as columns.");
+
+        public:
+
+        // Orthonormal columns of Q and the upper triangular R
+
+        Matrix<Type, Rows, Cols> q;
+        Matrix<Type, Cols, Cols> r;
+
+        // Constructors
+
+        explicit QRDecomposition(const Matrix<Type, Rows, Cols> &mat)
+            : q(mat)
+        {
+            Type tau[Cols];
+            Detail::QRFactor(Rows, Cols, this->q.data, Rows, tau);
+
+            for (size_t col = 0; col < Cols; col++)
+            {
+                for (size_t row = 0; row < Cols; row++)
+                    this->r.data[col * Cols + row] = row <= col ? this->q.data[col * Rows + row] : Type(0);
+            }
+
+            Detail::QRFormQ(Rows, Cols, this->q.data, Rows, tau);
+        }
+
+        // Least-squares solution of A x = vec, x = R⁻¹Qᵀvec
+
+        Vector<Type, Cols> Solve(const Vector<Type, Rows> &vec) const
+        {
+            Vector<Type, Cols> newVec;
+
+            for (size_t col = 0; col < Cols; col++)
+            {
+                Type dot = 0;
+
+                for (size_t row = 0; row < Rows; row++)
+                    dot += this->q.data[col * Rows + row] * vec.data[row];
+
+                newVec.data[col] = dot;
+            }
+
+            for (size_t row = Cols; row-- > 0;)
+            {
+                const Type diagonal = this->r.data[row * Cols + row];
+
+                if (diagonal == Type(0))
+                    throw std::runtime_error("QRDecomposition::Solve: matrix is rank deficient.");
+
+                Type sum = newVec.data[row];
+
+                for (size_t col = row + 1; col < Cols; col++)
+                    sum -= this->r.data[col * Cols + row] * newVec.data[col];
+
+                newVec.data[row] = sum / diagonal;
+            }
+
+            return newVec;
+        }
+    };
+
+    // Singular value decomposition, A = UΣVᵀ, for Rows >= Cols (decompose the transpose otherwise)
+
+    template <typename Type, size_t Rows, size_t Cols> class SingularValueDecomposition
+    {
+        static_assert(Rows >= Cols, "SingularValueDecomposition requires at least as many rows as columns.");
+
+        public:
+
+        // Left singular vectors, singular values in descending order and right singular vectors
+
+        Matrix<Type, Rows, Cols> u;
+        Vector<Type, Cols> values;
+        Matrix<Type, Cols, Cols> v;
+        bool converged;
+
+        // Constructors
+
+        explicit SingularValueDecomposition(const Matrix<Type, Rows, Cols> &mat)
+            : u(mat)
+        { this->converged = Detail::JacobiSVD(Rows, Cols, this->u.data, Rows, this->values.data, this->v.data, Cols); }
+    };
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <Math/Matrix.hpp>
+
+namespace Scoop::Math
+{
+    // Dual number for forward-mode automatic differentiation
+    //
+    // Carries a value and its derivatives with respect to N variables. Every operation applies the
+    // chain rule to all N derivative lanes at once, as a loop over a contiguous array that the
+    // compiler vectorizes. Constants convert implicitly, with zero derivatives, so duals work as the
+    // element type of Vector and Matrix, and one evaluation of a function on dual inputs gives its
+    // value and its Jacobian.
+
+    template <typename Type, size_t N> class Dual
+    {
+        public:
+
+        // Value and derivatives
+
+        Type value;
+        Type derivatives[N];
+
+        // Constructors
+
+        Dual() = default;
+
+        Dual(Type value)
+            : value(value), derivatives()
+        { }
+
+        // Independent variable index, whose derivative with respect to itself is 1
+
+        static Dual Variable(Type value, size_t index)
+        {
+            if (index >= N)
+                throw std::out_of_range("Dual::Variable: index out of range.");
+
+            Dual newDual(value);
+            newDual.derivatives[index] = 1;
+            return newDual;
+        }
+
+        // Chain rule for f(this), given f and f' at the value
+
+        Dual Chain(Type newValue, Type derivative) const
+        {
+            Dual newDual;
+            newDual.value = newValue;
+
+            for (size_t i = 0; i < N; i++)
+                newDual.derivatives[i] = derivative * this->derivatives[i];
+
+            return newDual;
+        }
+
+        // Arithmetic operators
+
+        friend Dual operator+(const Dual &a, const Dual &b)
+        {
+            Dual newDual;
+            newDual.value = a.value + b.value;
+
+            for (size_t i = 0; i < N; i++)
+                newDual.derivatives[i] = a.derivatives[i] + b.derivatives[i];
+
+            return newDual;
+        }
+
+        friend Dual operator-(const Dual &a, const Dual &b)
+        {
+            Dual newDual;
+            newDual.value = a.value - b.value;
+
+            for (size_t i = 0; i < N; i++)
+                newDual.derivatives[i] = a.derivatives[i] - b.derivatives[i];
+
+            return newDual;
+        }
+
+        friend Dual operator*(const Dual &a, const Dual &b)
+        {
+            Dual newDual;
+            newDual.value = a.value * b.value;
+
+            for (size_t i = 0; i < N; i++)
+                newDual.derivatives[i] = a.derivatives[i] * b.value + a.value * b.derivatives[i];
+
+            return newDual;
+        }
+
+        friend Dual operator/(const Dual &a, const Dual &b)
+        {
+            const Type inverse = Type(1) / b.value;
+            const Type quotient = a.value * inverse;
+            Dual newDual;
+            newDual.value = quotient;
+
+            for (size_t i = 0; i < N; i++)
+                newDual.derivatives[i] = (a.derivatives[i] - quotient * b.derivatives[i]) * inverse;
+
+            return newDual;
+        }
+
+        Dual operator-() const
+        { return this->Chain(-this->value, Type(-1)); }
+
+        Dual operator+() const
+        { return *this; }
+
+        Dual &operator+=(const Dual &b) { *this = *this + b; return *this; }
+        Dual &operator-=(const Dual &b) { *this = *this - b; return *this; }
+        Dual &operator*=(const Dual &b) { *this = *this * b; return *this; }
+        Dual &operator/=(const Dual &b) { *this = *this / b; return *this; }
+
+        // Comparison operators, on values
+
+        friend bool operator==(const Dual &a, const Dual &b) { return a.value == b.value; }
+        friend bool operator!=(const Dual &a, const Dual &b) { return a.value != b.value; }
+        friend bool operator<(const Dual &a, const Dual &b) { return a.value < b.value; }
+        friend bool operator>(const Dual &a, const Dual &b) { return a.value > b.value; }
+        friend bool operator<=(const Dual &a, const Dual &b) { return a.value <= b.value; }
+        friend bool operator>=(const Dual &a, const Dual &b) { return a.value >= b.value; }
+    };
+
+    // Elementary functions, found by argument-dependent lookup from unqualified calls
+
+    template <typename Type, size_t N> Dual<Type, N> sqrt(const Dual<Type, N> &x)
+    {
+        const Type root = std::sqrt(x.value);
+        return x.Chain(root, Type(0.5) / root);
+    }
+
+    template <typename Type, size_t N> Dual<Type, N> abs(const Dual<Type, N> &x)
+    { return x.value < Type(0) ? -x : x; }
+
+    template <typename Type, size_t N> Dual<Type, N> exp(const Dual<Type, N> &x)
+    {
+        const Type value = std::exp(x.value);
+        return x.Chain(value, value);
+    }
+
+    template <typename Type, size_t N> Dual<Type, N> log(const Dual<Type, N> &x)
+    { return x.Chain(std::log(x.value), Type(1) / x.value); }
+
+    template <typename Type, size_t N> Dual<Type, N> pow(const Dual<Type, N> &x, Type exponent)
+    {
+        const Type value = std::pow(x.value, exponent);
+        return x.Chain(value, exponent * std::pow(x.value, exponent - 1));
+    }
+
+    template <typename Type, size_t N> Dual<Type, N> pow(const Dual<Type, N> &x, const Dual<Type, N> &exponent)
+    { return exp(exponent * log(x)); }
+
+    template <typename Type, size_t N> Dual<Type, N> sin(const Dual<Type, N> &x)
+    { return x.Chain(std::sin(x.value), std::cos(x.value)); }
+
+    template <typename Type, size_t N> Dual<Type, N> cos(const Dual<Type, N> &x)
+    { return x.Chain(std::cos(x.value), -std::sin(x.value)); }
+
+    template <typename Type, size_t N> Dual<Type, N> tan(const Dual<Type, N> &x)
+    {
+        const Type value = std::tan(x.value);
+        return x.Chain(value, 1 + value * value);
+    }
+
+    template <typename Type, size_t N> Dual<Type, N> asin(const Dual<Type, N> &x)
+    { return x.Chain(std::asin(x.value), Type(1) / std::sqrt(1 - x.value * x.value)); }
+
+    template <typename Type, size_t N> Dual<Type, N> acos(const Dual<Type, N> &x)
+    { return x.Chain(std::acos(x.value), Type(-1) / std::sqrt(1 - x.value * x.value)); }
+
+    template <typename Type, size_t N> Dual<Type, N> atan(const Dual<Type, N> &x)
+    { return x.Chain(std::atan(x.value), Type(1) / (1 + x.value * x.value)); }
+
+    template <typename Type, size_t N> Dual<Type, N> atan2(const Dual<Type, N> &y, const Dual<Type, N> &x)
+    {
+        // d atan2(y, x) = (x dy - y dx) / (x² + y²)
+
+        const Type inverse = Type(1) / (x.value * x.value + y.value * y.value);
+        Dual<Type, N> newDual;
+        newDual.value = std::atan2(y.value, x.value);
+
+        for (size_t i = 0; i < N; i++)
+            newDual.derivatives[i] = (x.value * y.derivatives[i] - y.value * x.derivatives[i]) * inverse;
+
+        return newDual;
+    }
+
+    template <typename Type, size_t N> Dual<Type, N> sinh(const Dual<Type, N> &x)
+    { return x.Chain(std::sinh(x.value), std::cosh(x.value)); }
+
+    template <typename Type, size_t N> Dual<Type, N> cosh(const Dual<Type, N> &x)
+    { return x.Chain(std::cosh(x.value), std::sinh(x.value)); }
+
+    template <typename Type, size_t N> Dual<Type, N> tanh(const Dual<Type, N> &x)
+    {
+        const Type value = std::tanh(x.value);
+        return x.Chain(value, 1 - value * value);
+    }
+
+    // Jacobians
+    //
+    // DualVariables seeds x as the N independent variables, and DualValue and DualJacobian read
+    // the value and the M x N Jacobian back from the result.
+
+    template <typename Type, size_t N> Vector<Dual<Type, N>, N> DualVariables(const Vector<Type, N> &x)
+    {
+        Vector<Dual<Type, N>, N> newVec;
+
+        for (size_t i = 0; i < N; i++)
+            newVec.data[i] = Dual<Type, N>::Variable(x.data[i], i);
+
+        return newVec;
+    }
+
+    template <typename Type, size_t N, size_t M> Vector<Type, M> DualValue(const Vector<Dual<Type, N>, M> &y)
+    {
+        Vector<Type, M> newVec;
+
+        for (size_t i = 0; i < M; i++)
+            newVec.data[i] = y.data[i].value;
+
+        return newVec;
+    }
+
+    template <typename Type, size_t N, size_t M> Matrix<Type, M, N> DualJacobian(const Vector<Dual<Type, N>, M> &y)
+    {
+        Matrix<Type, M, N> newMat;
+
+        for (size_t col = 0; col < N; col++)
+        {
+            for (size_t row = 0; row < M; row++)
+                newMat.data[col * M + row] = y.data[row].derivatives[col];
+        }
+
+        return newMat;
+    }
+
+    // Jacobian of function at x from one evaluation on dual numbers. function takes a
+    // Vector<Dual<Type, N>, N> and returns a Vector<Dual<Type, N>, M>.
+
+    template <typename Type, size_t N, typename Function> auto Jacobian(const Function &function, const Vector<Type, N> &x)
+    { return DualJacobian(function(DualVariables(x))); }
+}
@@ -0,0 +1,610 @@
+#pragma once
+
+#include <Math/Decomposition.hpp>
+#include <Math/Sparse.hpp>
+#include <Math/BlockSparse.hpp>
+
+#include <complex>
+#include <random>
+
+namespace Scoop::Math
+{
+    // Eigensolver options and results
+
+    enum class EigenTarget
+    {
+        LargestMagnitude,
+        LargestReal,
+        SmallestReal
+    };
+
+    struct EigenOptions
+    {
+        size_t count = 6;
+        size_t subspace = 0;
+        size_t blockSize = 1;
+        size_t maxRestarts = 1000;
+        double tolerance = 1e-8;
+        EigenTarget target = EigenTarget::LargestMagnitude;
+    };
+
+    template <typename Type> struct SymmetricEigenResult
+    {
+        std::vector<Type> values;
+        std::vector<Type> vectors;
+        size_t restarts = 0;
+        size_t products = 0;
+        bool converged = false;
+    };
+
+    template <typename Type> struct EigenResult
+    {
+        std::vector<std::complex<Type>> values;
+        std::vector<std::complex<Type>> vectors;
+        size_t restarts = 0;
+        size_t products = 0;
+        bool converged = false;
+    };
+
+    // Krylov subspace kernels
+    //
+    // Bases are column-major n x m blocks. Products against the basis are InnerProducts (VᵀX) and
+    // GEMM updates, both threaded over rows, so a whole block is orthogonalized in one pass over
+    // the basis.
+
+    namespace Detail
+    {
+        // Orthonormalizes count columns of x against the vCount orthonormal columns of v and each
+        // other, by two passes of block classical Gram-Schmidt followed by modified Gram-Schmidt
+        // within the block. Columns that vanish are replaced by random directions.
+
+        template <typename Type>
+        void KrylovOrthonormalize(size_t n, const Type *v, size_t ldv, size_t vCount, Type *x, size_t ldx, size_t count, std::mt19937_64 &random)
+        {
+            std::vector<Type> coefficients(std::max<size_t>(vCount, 1) * count);
+            std::vector<Type> norms(count);
+
+            for (size_t col = 0; col < count; col++)
+                InnerProducts(n, 1, 1, x + col * ldx, ldx, x + col * ldx, ldx, &norms[col], 1);
+
+            auto project = [&](Type *y, size_t yCount)
+            {
+                if (vCount == 0)
+                    return;
+
+                for (size_t pass = 0; pass < 2; pass++)
+                {
+                    InnerProducts(n, vCount, yCount, v, ldv, y, ldx, coefficients.data(), vCount);
+
+                    for (size_t i = 0; i < vCount * yCount; i++)
+                        coefficients[i] = -coefficients[i];
+
+                    Gemm<PlusTimes>(n, yCount, vCount, v, ldv, coefficients.data(), vCount, y, ldx, true);
+                }
+            };
+
+            project(x, count);
+
+            std::normal_distribution<double> normal;
+
+            for (size_t col = 0; col < count; col++)
+            {
+                Type *xCol = x + col * ldx;
+
+                for (size_t attempt = 0; attempt < 2; attempt++)
+                {
+                    for (size_t pass = 0; pass < 2; pass++)
+                    {
+                        for (size_t prev = 0; prev < col; prev++)
+                        {
+                            const Type *prevCol = x + prev * ldx;
+                            Type dot;
+                            InnerProducts(n, 1, 1, prevCol, ldx, xCol, ldx, &dot, 1);
+
+                            for (size_t row = 0; row < n; row++)
+                                xCol[row] -= dot * prevCol[row];
+                        }
+                    }
+
+                    Type norm;
+                    InnerProducts(n, 1, 1, xCol, ldx, xCol, ldx, &norm, 1);
+
+                    if (norm > Type(1e-20) * norms[col] && norm > std::numeric_limits<Type>::min())
+                    {
+                        norm = std::sqrt(norm);
+
+                        for (size_t row = 0; row < n; row++)
+                            xCol[row] /= norm;
+                        break;
+                    }
+
+                    if (attempt == 1)
+                        throw std::runtime_error("KrylovOrthonormalize: subspace exhausted.");
+
+                    for (size_t row = 0; row < n; row++)
+                        xCol[row] = Type(normal(random));
+
+                    norms[col] = Type(n);
+                    project(xCol, 1);
+                }
+            }
+        }
+
+        // Ritz values and vectors of the projected matrix h (size x size, overwritten), ordered
+        // by target. Vectors are returned in the columns of y, with the real and imaginary parts
+        // of a complex conjugate pair in consecutive columns; order lists the eigenvalues, keeping
+        // each pair together with the positive imaginary part first.
+
+        template <typename Type>
+        void KrylovRitz(size_t size, Type *h, bool symmetric, EigenTarget target, Type *y, Type *real, Type *imag, std::vector<size_t> &order)
+        {
+            if (symmetric)
+            {
+                for (size_t col = 0; col < size; col++)
+                {
+                    for (size_t row = 0; row < col; row++)
+                    {
+                        const Type mean = (h[col * size + row] + h[row * size + col]) / 2;
+                        h[col * size + row] = mean;
+                        h[row * size + col] = mean;
+                    }
+                }
+
+                if (!SymmetricEigen(size, h, size, real))
+                    throw std::runtime_error("KrylovRitz: Rayleigh-Ritz iteration did not converge.");
+
+                std::copy(h, h + size * size, y);
+                std::fill(imag, imag + size, Type(0));
+            }
+            else
+            {
+                HessenbergReduce(size, h, size, y, size);
+
+                if (!RealSchur(size, h, size, y, size, real, imag))
+                    throw std::runtime_error("KrylovRitz: Rayleigh-Ritz iteration did not converge.");
+
+                SchurEigenvectors(size, h, size, y, size, real, imag);
+
+                for (size_t col = 0; col < size; col++)
+                {
+                    const size_t width = imag[col] > 0 ? 2 : 1;
+                    Type norm = 0;
+
+                    for (size_t i = col * size; i < (col + width) * size; i++)
+                        norm += y[i] * y[i];
+
+                    norm = std::sqrt(norm);
+
+                    for (size_t i = col * size; i < (col + width) * size; i++)
+                        y[i] /= norm;
+
+                    col += width - 1;
+                }
+            }
+
+            std::vector<size_t> groups;
+
+            for (size_t col = 0; col < size; col += imag[col] > 0 ? 2 : 1)
+                groups.push_back(col);
+
+            auto key = [&](size_t col) -> Type
+            {
+                switch (target)
+                {
+                    case EigenTarget::LargestReal:
+                        return -real[col];
+                    case EigenTarget::SmallestReal:
+                        return real[col];
+                    default:
+                        return -std::hypot(real[col], imag[col]);
+                }
+            };
+
+            std::stable_sort(groups.begin(), groups.end(), [&](size_t a, size_t b) { return key(a) < key(b); });
+
+            order.clear();
+
+            for (size_t col : groups)
+            {
+                order.push_back(col);
+                if (imag[col] > 0)
+                    order.push_back(col + 1);
+            }
+        }
+
+        // Thick-restarted block Krylov eigensolver
+        //
+        // Grows an orthonormal basis V and W = AV one block at a time, extracts Ritz pairs from
+        // H = VᵀW, and restarts from the wanted Ritz subspace together with the residual block of
+        // the last expansion, so the basis stays a Krylov decomposition. This is Krylov-Schur
+        // restarting, equivalent to implicit QR restarting with exact shifts. Full
+        // reorthogonalization keeps the symmetric (Lanczos) case free of ghost eigenvalues.
+
+        template <typename Type, typename Product>
+        class KrylovEigensolver
+        {
+            public:
+
+            // Selected eigenvalues and vectors, as returned by KrylovRitz restricted to the wanted
+            // columns (n x columns, column-major)
+
+            std::vector<Type> real;
+            std::vector<Type> imag;
+            std::vector<Type> vectors;
+            size_t restarts = 0;
+            size_t products = 0;
+            bool converged = false;
+
+            KrylovEigensolver(size_t n, const Product &product, const EigenOptions &options, bool symmetric)
+                : n(n), product(product), options(options), symmetric(symmetric), random(5489)
+            {
+                if (options.count == 0 || options.count > n)
+                    throw std::runtime_error("KrylovEigensolver: count must be between 1 and the matrix size.");
+                if (options.blockSize == 0)
+                    throw std::runtime_error("KrylovEigensolver: block size must be positive.");
+
+                this->block = options.blockSize;
+                this->size = options.subspace != 0 ? options.subspace : std::max<size_t>({ 2 * options.count, options.count + 8 * this->block, 20 });
+                this->size = std::max(this->size, options.count + 2 * this->block + 1);
+
+                if (this->size >= n)
+                    this->SolveDense();
+                else
+                    this->Solve();
+            }
+
+            private:
+
+            size_t n;
+            const Product &product;
+            EigenOptions options;
+            bool symmetric;
+            std::mt19937_64 random;
+            size_t block;
+            size_t size;
+
+            std::vector<Type> basis;
+            std::vector<Type> images;
+            std::vector<Type> projected;
+            std::vector<Type> ritzVectors;
+            std::vector<Type> ritzReal;
+            std::vector<Type> ritzImag;
+            std::vector<size_t> order;
+
+            void Apply(const Type *x, Type *y, size_t count)
+            {
+                this->product(x, this->n, y, this->n, count);
+                this->products += count;
+            }
+
+            // Rayleigh-Ritz on the first cols basis columns
+
+            void Ritz(size_t cols)
+            {
+                this->projected.resize(cols * cols);
+                this->ritzVectors.resize(cols * cols);
+                this->ritzReal.resize(cols);
+                this->ritzImag.resize(cols);
+
+                InnerProducts(this->n, cols, cols, this->basis.data(), this->n, this->images.data(), this->n, this->projected.data(), cols);
+                KrylovRitz(cols, this->projected.data(), this->symmetric, this->options.target, this->ritzVectors.data(), this->ritzReal.data(), this->ritzImag.data(), this->order);
+            }
+
+            // Ritz columns covering the first count eigenvalues, completing a split pair
+
+            size_t Wanted(size_t count) const
+            {
+                size_t wanted = count;
+                if (wanted < this->order.size() && this->ritzImag[this->order[wanted - 1]] > 0)
+                    wanted++;
+                return wanted;
+            }
+
+            void Gather(size_t cols, size_t wanted, std::vector<Type> &selected) const
+            {
+                selected.resize(cols * wanted);
+
+                for (size_t i = 0; i < wanted; i++)
+                {
+                    // The second of a pair takes the imaginary part stored after the real part
+
+                    const size_t col = this->order[i];
+                    std::copy(this->ritzVectors.begin() + col * cols, this->ritzVectors.begin() + (col + 1) * cols, selected.begin() + i * cols);
+                }
+            }
+
+            // Computes the wanted Ritz vectors and checks their residuals ‖Ax - θx‖
+
+            bool Check(size_t cols)
+            {
+                const size_t wanted = this->Wanted(this->options.count);
+                std::vector<Type> selected, images(this->n * wanted);
+
+                this->Gather(cols, wanted, selected);
+                this->vectors.resize(this->n * wanted);
+
+                Gemm<PlusTimes>(this->n, wanted, cols, this->basis.data(), this->n, selected.data(), cols, this->vectors.data(), this->n, false);
+                Gemm<PlusTimes>(this->n, wanted, cols, this->images.data(), this->n, selected.data(), cols, images.data(), this->n, false);
+
+                this->real.resize(wanted);
+                this->imag.resize(wanted);
+
+                Type scale = 0;
+
+                for (size_t i = 0; i < cols; i++)
+                    scale = std::max(scale, std::hypot(this->ritzReal[i], this->ritzImag[i]));
+
+                const Type tolerance = Type(this->options.tolerance) * std::max(scale, std::numeric_limits<Type>::min());
+                bool done = true;
+
+                for (size_t i = 0; i < wanted; i++)
+                {
+                    const Type re = this->ritzReal[this->order[i]];
+                    const Type im = this->ritzImag[this->order[i]];
+
+                    this->real[i] = re;
+                    this->imag[i] = im;
+
+                    Type *x = this->vectors.data() + i * this->n;
+                    Type *ax = images.data() + i * this->n;
+                    Type residual = 0;
+
+                    if (im == Type(0))
+                    {
+                        for (size_t row = 0; row < this->n; row++)
+                        {
+                            const Type r = ax[row] - re * x[row];
+                            residual += r * r;
+                        }
+                    }
+                    else if (im > 0)
+                    {
+                        const Type *y = x + this->n;
+                        const Type *ay = ax + this->n;
+
+                        for (size_t row = 0; row < this->n; row++)
+                        {
+                            const Type r = ax[row] - (re * x[row] - im * y[row]);
+                            const Type s = ay[row] - (re * y[row] + im * x[row]);
+                            residual += r * r + s * s;
+                        }
+                    }
+                    else
+                    {
+                        continue;
+                    }
+
+                    if (std::sqrt(residual) > tolerance)
+                        done = false;
+                }
+
+                return done;
+            }
+
+            // Small problems: the basis is the whole space
+
+            void SolveDense()
+            {
+                this->basis.assign(this->n * this->n, Type(0));
+                this->images.resize(this->n * this->n);
+
+                for (size_t i = 0; i < this->n; i++)
+                    this->basis[i * this->n + i] = 1;
+
+                this->Apply(this->basis.data(), this->images.data(), this->n);
+                this->Ritz(this->n);
+                this->Check(this->n);
+                this->converged = true;
+            }
+
+            void Solve()
+            {
+                const size_t n = this->n;
+                const size_t block = this->block;
+
+                this->basis.resize(n * this->size);
+                this->images.resize(n * this->size);
+
+                std::normal_distribution<double> normal;
+
+                for (size_t i = 0; i < n * block; i++)
+                    this->basis[i] = Type(normal(this->random));
+
+                KrylovOrthonormalize(n, this->basis.data(), n, 0, this->basis.data(), n, block, this->random);
+                this->Apply(this->basis.data(), this->images.data(), block);
+
+                size_t cols = block;
+                const size_t keep = this->options.count + (this->size - 2 * block - this->options.count) / 2;
+                std::vector<Type> selected, scratch, residual(n * block);
+
+                for (this->restarts = 0;; this->restarts++)
+                {
+                    // Expand with A applied to the newest block
+
+                    while (cols + block <= this->size)
+                    {
+                        Type *next = this->basis.data() + cols * n;
+
+                        std::copy(this->images.begin() + (cols - block) * n, this->images.begin() + cols * n, next);
+                        KrylovOrthonormalize(n, this->basis.data(), n, cols, next, n, block, this->random);
+                        this->Apply(next, this->images.data() + cols * n, block);
+                        cols += block;
+                    }
+
+                    this->Ritz(cols);
+
+                    if (this->Check(cols))
+                    {
+                        this->converged = true;
+                        return;
+                    }
+
+                    if (this->restarts == this->options.maxRestarts)
+                        return;
+
+                    // Residual block of the last expansion, orthogonal to the whole basis
+
+                    std::copy(this->images.begin() + (cols - block) * n, this->images.begin() + cols * n, residual.begin());
+                    KrylovOrthonormalize(n, this->basis.data(), n, cols, residual.data(), n, block, this->random);
+
+                    // Restart from an orthonormal basis of the wanted Ritz subspace
+
+                    const size_t wanted = this->Wanted(keep);
+                    this->Gather(cols, wanted, selected);
+
+                    for (size_t i = 0; i < wanted; i++)
+                    {
+                        Type *col = selected.data() + i * cols;
+
+                        for (size_t pass = 0; pass < 2; pass++)
+                        {
+                            for (size_t prev = 0; prev < i; prev++)
+                            {
+                                const Type *prevCol = selected.data() + prev * cols;
+                                Type dot = 0;
+
+                                for (size_t row = 0; row < cols; row++)
+                                    dot += prevCol[row] * col[row];
+                                for (size_t row = 0; row < cols; row++)
+                                    col[row] -= dot * prevCol[row];
+                            }
+                        }
+
+                        Type norm = 0;
+
+                        for (size_t row = 0; row < cols; row++)
+                            norm += col[row] * col[row];
+
+                        norm = std::sqrt(norm);
+
+                        for (size_t row = 0; row < cols; row++)
+                            col[row] /= norm;
+                    }
+
+                    scratch.resize(n * wanted);
+
+                    Gemm<PlusTimes>(n, wanted, cols, this->basis.data(), n, selected.data(), cols, scratch.data(), n, false);
+                    std::copy(scratch.begin(), scratch.end(), this->basis.begin());
+                    Gemm<PlusTimes>(n, wanted, cols, this->images.data(), n, selected.data(), cols, scratch.data(), n, false);
+                    std::copy(scratch.begin(), scratch.end(), this->images.begin());
+
+                    std::copy(residual.begin(), residual.end(), this->basis.begin() + wanted * n);
+                    this->Apply(this->basis.data() + wanted * n, this->images.data() + wanted * n, block);
+                    cols = wanted + block;
+                }
+            }
+        };
+    }
+
+    // Lanczos eigensolver for symmetric matrices
+    //
+    // Finds options.count eigenpairs of the symmetric n x n operator applied by
+    // product(x, ldx, y, ldy, count), which must set the count column-major columns of y to A times
+    // the columns of x. Blocks of options.blockSize vectors are multiplied together, so sparse
+    // operators run as SpMM. The Krylov basis has options.subspace columns (by default
+    // max(2 count, count + 8 blockSize, 20)); problems no larger than the basis are solved densely.
+    //
+    // Eigenvalues are returned in target order with orthonormal vectors in the n x count
+    // column-major result. A pair is converged when ‖Ax - θx‖ ≤ tolerance times the largest Ritz
+    // value magnitude.
+
+    template <typename Type, typename Product>
+    SymmetricEigenResult<Type> LanczosEigen(size_t n, const Product &product, const EigenOptions &options = EigenOptions())
+    {
+        Detail::KrylovEigensolver<Type, Product> solver(n, product, options, true);
+        SymmetricEigenResult<Type> result;
+
+        result.values.assign(solver.real.begin(), solver.real.begin() + options.count);
+        result.vectors.assign(solver.vectors.begin(), solver.vectors.begin() + n * options.count);
+        result.restarts = solver.restarts;
+        result.products = solver.products;
+        result.converged = solver.converged;
+        return result;
+    }
+
+    // Arnoldi eigensolver for general matrices
+    //
+    // Same interface as LanczosEigen. Complex eigenvalues come in conjugate pairs, the one with
+    // positive imaginary part first, and eigenvectors are normalized to unit length.
+
+    template <typename Type, typename Product>
+    EigenResult<Type> ArnoldiEigen(size_t n, const Product &product, const EigenOptions &options = EigenOptions())
+    {
+        Detail::KrylovEigensolver<Type, Product> solver(n, product, options, false);
+        EigenResult<Type> result;
+
+        result.values.resize(options.count);
+        result.vectors.resize(n * options.count);
+
+        for (size_t i = 0; i < options.count; i++)
+        {
+            const Type *x = solver.vectors.data() + i * n;
+            std::complex<Type> *vector = result.vectors.data() + i * n;
+
+            result.values[i] = std::complex<Type>(solver.real[i], solver.imag[i]);
+
+            if (solver.imag[i] > 0)
+            {
+                for (size_t row = 0; row < n; row++)
+                    vector[row] = std::complex<Type>(x[row], x[row + n]);
+            }
+            else if (solver.imag[i] < 0)
+            {
+                for (size_t row = 0; row < n; row++)
+                    vector[row] = std::complex<Type>((x - n)[row], -x[row]);
+            }
+            else
+            {
+                for (size_t row = 0; row < n; row++)
+                    vector[row] = x[row];
+            }
+        }
+
+        result.restarts = solver.restarts;
+        result.products = solver.products;
+        result.converged = solver.converged;
+        return result;
+    }
+
+    // Sparse matrix overloads
+
+    template <typename Type>
+    SymmetricEigenResult<Type> LanczosEigen(const SparseMatrix<Type> &mat, const EigenOptions &options = EigenOptions())
+    {
+        if (mat.rows != mat.cols)
+            throw std::runtime_error("LanczosEigen: matrix must be square.");
+
+        auto product = [&](const Type *x, size_t ldx, Type *y, size_t ldy, size_t count) { mat.Multiply(x, ldx, y, ldy, count); };
+        return LanczosEigen<Type>(mat.rows, product, options);
+    }
+
+    template <typename Type>
+    EigenResult<Type> ArnoldiEigen(const SparseMatrix<Type> &mat, const EigenOptions &options = EigenOptions())
+    {
+        if (mat.rows != mat.cols)
+            throw std::runtime_error("ArnoldiEigen: matrix must be square.");
+
+        auto product = [&](const Type *x, size_t ldx, Type *y, size_t ldy, size_t count) { mat.Multiply(x, ldx, y, ldy, count); };
+        return ArnoldiEigen<Type>(mat.rows, product, options);
+    }
+
+    template <typename Type, size_t Block>
+    SymmetricEigenResult<Type> LanczosEigen(const BlockSparseMatrix<Type, Block> &mat, const EigenOptions &options = EigenOptions())
+    {
+        if (mat.blockRows != mat.blockCols)
+            throw std::runtime_error("LanczosEigen: matrix must be square.");
+
+        auto product = [&](const Type *x, size_t ldx, Type *y, size_t ldy, size_t count) { mat.Multiply(x, ldx, y, ldy, count); };
+        return LanczosEigen<Type>(mat.Rows(), product, options);
+    }
+
+    template <typename Type, size_t Block>
+    EigenResult<Type> ArnoldiEigen(const BlockSparseMatrix<Type, Block> &mat, const EigenOptions &options = EigenOptions())
+    {
+        if (mat.blockRows != mat.blockCols)
+            throw std::runtime_error("ArnoldiEigen: matrix must be square.");
+
+        auto product = [&](const Type *x, size_t ldx, Type *y, size_t ldy, size_t count) { mat.Multiply(x, ldx, y, ldy, count); };
+        return ArnoldiEigen<Type>(mat.Rows(), product, options);
+    }
+}
@@ -0,0 +1,398 @@
+#pragma once
+
+#include <Math/Sparse.hpp>
+
+#include <atomic>
+#include <mutex>
+
+namespace Scoop::Math
+{
+    // Storage formats and the structure found by AnalyzeStructure
+
+    enum class MatrixFormat
+    {
+        Dense,
+        Diagonal,
+        Banded,
+        Sparse
+    };
+
+    struct MatrixStructure
+    {
+        size_t rows = 0;
+        size_t cols = 0;
+        size_t nonZeroCount = 0;
+        size_t lowerBandwidth = 0;
+        size_t upperBandwidth = 0;
+        bool symmetric = false;
+
+        double Density() const
+        { return this->rows * this->cols == 0 ? 0.0 : double(this->nonZeroCount) / double(this->rows * this->cols); }
+
+        // Elements read by one matrix-vector product in each format, counting a sparse index as
+        // one more element. Formats that cannot hold the matrix cost SIZE_MAX.
+
+        template <typename Type> size_t Cost(MatrixFormat format) const
+        {
+            switch (format)
+            {
+                case MatrixFormat::Diagonal:
+                    if (this->lowerBandwidth != 0 || this->upperBandwidth != 0)
+                        return SIZE_MAX;
+                    return std::min(this->rows, this->cols);
+                case MatrixFormat::Banded:
+                    return (this->lowerBandwidth + this->upperBandwidth + 1) * this->rows;
+                case MatrixFormat::Sparse:
+                    return this->nonZeroCount * (1 + (sizeof(size_t) + sizeof(Type) - 1) / sizeof(Type)) + this->cols + 1;
+                default:
+                    return this->rows * this->cols;
+            }
+        }
+
+        // Cheapest format, preferring the simpler one on ties
+
+        template <typename Type> MatrixFormat Recommended() const
+        {
+            MatrixFormat best = MatrixFormat::Dense;
+
+            for (MatrixFormat format : { MatrixFormat::Diagonal, MatrixFormat::Banded, MatrixFormat::Sparse })
+            {
+                if (this->Cost<Type>(format) < this->Cost<Type>(best))
+                    best = format;
+            }
+
+            return best;
+        }
+    };
+
+    // Structure analysis kernels
+
+    namespace Detail
+    {
+        // Scans a column-major matrix for nonzeros, bandwidth and symmetry. Columns are split
+        // between threads, and the zero count is a branch-free sum that vectorizes.
+
+        template <typename Type>
+        MatrixStructure AnalyzeStructure(size_t rows, size_t cols, const Type *data, size_t ld)
+        {
+            MatrixStructure structure;
+            structure.rows = rows;
+            structure.cols = cols;
+            structure.symmetric = rows == cols;
+
+            std::atomic<bool> symmetric(structure.symmetric);
+            std::mutex mutex;
+
+            ParallelFor(0, cols, 64, [&](size_t colBegin, size_t colEnd)
+            {
+                size_t nonZeroCount = 0;
+                size_t lower = 0;
+                size_t upper = 0;
+
+                for (size_t col = colBegin; col < colEnd; col++)
+                {
+                    const Type *column = data + col * ld;
+                    size_t count = 0;
+
+                    for (size_t row = 0; row < rows; row++)
+                        count += column[row] != Type(0);
+
+                    nonZeroCount += count;
+
+                    if (count == 0)
+                        continue;
+
+                    size_t first = 0;
+                    size_t last = rows - 1;
+
+                    while (column[first] == Type(0))
+                        first++;
+                    while (column[last] == Type(0))
+                        last--;
+
+                    if (first < col)
+                        upper = std::max(upper, col - first);
+                    if (last > col)
+                        lower = std::max(lower, last - col);
+                }
+
+                // Compare the strict lower triangle of these columns with the matching rows
+
+                for (size_t col = colBegin; col < colEnd && symmetric.load(std::memory_order_relaxed); col++)
+                {
+                    bool match = true;
+
+                    for (size_t row = col + 1; row < rows; row++)
+                        match &= data[col * ld + row] == data[row * ld + col];
+
+                    if (!match)
+                        symmetric.store(false, std::memory_order_relaxed);
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                structure.nonZeroCount += nonZeroCount;
+                structure.lowerBandwidth = std::max(structure.lowerBandwidth, lower);
+                structure.upperBandwidth = std::max(structure.upperBandwidth, upper);
+            });
+
+            structure.symmetric = symmetric.load();
+            return structure;
+        }
+    }
+
+    template <typename Type, size_t Rows, size_t Cols>
+    MatrixStructure AnalyzeStructure(const Matrix<Type, Rows, Cols> &mat)
+    { return Detail::AnalyzeStructure(Rows, Cols, mat.data, Rows); }
+
+    // Banded matrix
+    //
+    // Stores the diagonals from -lower to +upper, each indexed by row like the arrays of
+    // SolveTridiagonal: diagonals[(offset + lower) * rows + i] is element (i, i + offset). Elements
+    // outside the matrix are stored as 0. A bandwidth of 0 on both sides is a diagonal matrix.
+
+    template <typename Type> class BandedMatrix
+    {
+        public:
+
+        // Matrix structure and elements
+
+        size_t rows;
+        size_t cols;
+        size_t lower;
+        size_t upper;
+        std::vector<Type> diagonals;
+
+        // Constructors
+
+        BandedMatrix()
+            : rows(0), cols(0), lower(0), upper(0)
+        { }
+
+        BandedMatrix(size_t rows, size_t cols, size_t lower, size_t upper)
+            : rows(rows), cols(cols), lower(lower), upper(upper), diagonals((lower + upper + 1) * rows, Type(0))
+        { }
+
+        // Copies the band of a dense matrix, ignoring elements outside it
+
+        template <size_t Rows, size_t Cols>
+        BandedMatrix(const Matrix<Type, Rows, Cols> &mat, size_t lower, size_t upper)
+            : BandedMatrix(Rows, Cols, lower, upper)
+        {
+            for (size_t d = 0; d <= lower + upper; d++)
+            {
+                for (size_t row = 0; row < Rows; row++)
+                {
+                    const ptrdiff_t col = ptrdiff_t(row) + ptrdiff_t(d) - ptrdiff_t(lower);
+
+                    if (col >= 0 && col < ptrdiff_t(Cols))
+                        this->diagonals[d * Rows + row] = mat.data[col * Rows + row];
+                }
+            }
+        }
+
+        // Element access, returning 0 outside the band
+
+        Type At(size_t row, size_t col) const
+        {
+            if (col + this->lower < row || col > row + this->upper)
+                return Type(0);
+            return this->diagonals[(col + this->lower - row) * this->rows + row];
+        }
+
+        // Matrix-vector product, y = A x. Each diagonal is a unit-stride multiply-add, and rows are
+        // split between threads.
+
+        void Multiply(const Type *x, Type *y) const
+        {
+            ParallelFor(0, this->rows, 4096, [&](size_t rowBegin, size_t rowEnd)
+            {
+                std::fill(y + rowBegin, y + rowEnd, Type(0));
+
+                for (size_t d = 0; d <= this->lower + this->upper; d++)
+                {
+                    // Rows where column row + d - lower is inside the matrix
+
+                    const size_t begin = std::max(rowBegin, this->lower > d ? this->lower - d : 0);
+                    const size_t end = std::min(rowEnd, this->cols + this->lower > d ? this->cols + this->lower - d : 0);
+                    const Type *diagonal = this->diagonals.data() + d * this->rows;
+
+                    for (size_t row = begin; row < end; row++)
+                        y[row] += diagonal[row] * x[row + d - this->lower];
+                }
+            });
+        }
+
+        std::vector<Type> Multiply(const std::vector<Type> &x) const
+        {
+            if (x.size() != this->cols)
+                throw std::runtime_error("BandedMatrix::Multiply: vector size mismatch.");
+
+            std::vector<Type> y(this->rows);
+            this->Multiply(x.data(), y.data());
+            return y;
+        }
+    };
+
+    // Conversions from dense matrices
+
+    template <typename Type, size_t Rows, size_t Cols>
+    SparseMatrix<Type> ToSparse(const Matrix<Type, Rows, Cols> &mat)
+    {
+        SparseMatrix<Type> newMat(Rows, Cols);
+
+        for (size_t col = 0; col < Cols; col++)
+        {
+            for (size_t row = 0; row < Rows; row++)
+            {
+                if (mat.data[col * Rows + row] != Type(0))
+                {
+                    newMat.rowIndices.push_back(row);
+                    newMat.values.push_back(mat.data[col * Rows + row]);
+                }
+            }
+
+            newMat.colOffsets[col + 1] = newMat.rowIndices.size();
+        }
+
+        return newMat;
+    }
+
+    template <typename Type, size_t Rows, size_t Cols>
+    BandedMatrix<Type> ToBanded(const Matrix<Type, Rows, Cols> &mat)
+    {
+        MatrixStructure structure = AnalyzeStructure(mat);
+        return BandedMatrix<Type>(mat, structure.lowerBandwidth, structure.upperBandwidth);
+    }
+
+    // Matrix operator in the format chosen for its structure
+    //
+    // Holds one representation of the matrix and routes products to its kernel, so callers can
+    // keep writing against one type whatever the producer of the matrix stored.
+
+    template <typename Type> class MatrixOperator
+    {
+        public:
+
+        // Chosen format, analyzed structure and the representation in use (the others are empty)
+
+        MatrixFormat format;
+        MatrixStructure structure;
+        std::vector<Type> dense;
+        BandedMatrix<Type> banded;
+        SparseMatrix<Type> sparse;
+
+        // Constructors
+
+        template <size_t Rows, size_t Cols>
+        explicit MatrixOperator(const Matrix<Type, Rows, Cols> &mat)
+            : structure(AnalyzeStructure(mat))
+        { this->Convert(mat, this->structure.template Recommended<Type>()); }
+
+        template <size_t Rows, size_t Cols>
+        MatrixOperator(const Matrix<Type, Rows, Cols> &mat, MatrixFormat format)
+            : structure(AnalyzeStructure(mat))
+        {
+            if (format == MatrixFormat::Diagonal && this->structure.template Cost<Type>(format) == SIZE_MAX)
+                throw std::runtime_error("MatrixOperator: matrix is not diagonal.");
+
+            this->Convert(mat, format);
+        }
+
+        // Dimensions
+
+        size_t Rows() const
+        { return this->structure.rows; }
+
+        size_t Cols() const
+        { return this->structure.cols; }
+
+        // Matrix-vector product, y = A x
+
+        void Multiply(const Type *x, Type *y) const
+        {
+            switch (this->format)
+            {
+                case MatrixFormat::Diagonal:
+                case MatrixFormat::Banded:
+                    this->banded.Multiply(x, y);
+                    break;
+                case MatrixFormat::Sparse:
+                    this->sparse.Multiply(x, y);
+                    break;
+                default:
+                    this->MultiplyDense(x, y);
+                    break;
+            }
+        }
+
+        std::vector<Type> Multiply(const std::vector<Type> &x) const
+        {
+            if (x.size() != this->Cols())
+                throw std::runtime_error("MatrixOperator::Multiply: vector size mismatch.");
+
+            std::vector<Type> y(this->Rows());
+            this->Multiply(x.data(), y.data());
+            return y;
+        }
+
+        // Product with count column-major right-hand sides, Y = A X. Dense matrices use the GEMM
+        // kernel; the other formats apply their kernel to each right-hand side.
+
+        void Multiply(const Type *x, size_t ldx, Type *y, size_t ldy, size_t count) const
+        {
+            if (this->format == MatrixFormat::Dense)
+            {
+                Detail::Gemm<PlusTimes>(this->Rows(), count, this->Cols(), this->dense.data(), this->Rows(), x, ldx, y, ldy, false);
+                return;
+            }
+
+            for (size_t rhs = 0; rhs < count; rhs++)
+                this->Multiply(x + rhs * ldx, y + rhs * ldy);
+        }
+
+        private:
+
+        template <size_t Rows, size_t Cols>
+        void Convert(const Matrix<Type, Rows, Cols> &mat, MatrixFormat format)
+        {
+            this->format = format;
+
+            switch (format)
+            {
+                case MatrixFormat::Diagonal:
+                    this->banded = BandedMatrix<Type>(mat, 0, 0);
+                    break;
+                case MatrixFormat::Banded:
+                    this->banded = BandedMatrix<Type>(mat, this->structure.lowerBandwidth, this->structure.upperBandwidth);
+                    break;
+                case MatrixFormat::Sparse:
+                    this->sparse = ToSparse(mat);
+                    break;
+                default:
+                    this->dense.assign(mat.data, mat.data + Rows * Cols);
+                    break;
+            }
+        }
+
+        // Rows are split between threads, and each thread sweeps the columns over its rows
+
+        void MultiplyDense(const Type *x, Type *y) const
+        {
+            const size_t rows = this->Rows();
+
+            ParallelFor(0, rows, 1024, [&](size_t rowBegin, size_t rowEnd)
+            {
+                std::fill(y + rowBegin, y + rowEnd, Type(0));
+
+                for (size_t col = 0; col < this->Cols(); col++)
+                {
+                    const Type *column = this->dense.data() + col * rows;
+                    const Type value = x[col];
+
+                    for (size_t row = rowBegin; row < rowEnd; row++)
+                        y[row] += column[row] * value;
+                }
+            });
+        }
+    };
+}
@@ -0,0 +1,472 @@
+#pragma once
+
+#include <Math/Matrix.hpp>
+
+#include <atomic>
+
+namespace Scoop::Math
+{
+    namespace Detail
+    {
+        // Tracks per interleaved block, one cache line of each element
+
+        template <typename Type> constexpr size_t KalmanLanes = std::max<size_t>(64 / sizeof(Type), 4);
+    }
+
+    // Batched Kalman filter
+    //
+    // Runs many independent filters that share one linear model. Tracks are stored in blocks of
+    // Lanes interleaved tracks: element i of the states of a block is Lanes consecutive values,
+    // one per track, and covariances are stored the same way element by element (column-major).
+    // Every small-matrix operation is then a loop over the lanes of a block that the compiler
+    // turns into SIMD across tracks, with the shared model broadcast from scalars. Blocks are
+    // split between threads.
+
+    template <typename Type, size_t StateSize, size_t MeasurementSize> class KalmanBatch
+    {
+        public:
+
+        static constexpr size_t Lanes = Detail::KalmanLanes<Type>;
+
+        // Constructors
+
+        explicit KalmanBatch(size_t count)
+            : count(count), blocks((count + Lanes - 1) / Lanes),
+              states(this->blocks * StateSize * Lanes, Type(0)), covariances(this->blocks * StateSize * StateSize * Lanes, Type(0))
+        { }
+
+        size_t Count() const
+        { return this->count; }
+
+        // Per-track access
+
+        void SetState(size_t track, const Vector<Type, StateSize> &state)
+        {
+            for (size_t i = 0; i < StateSize; i++)
+                this->states[this->StateIndex(track, i)] = state.data[i];
+        }
+
+        Vector<Type, StateSize> State(size_t track) const
+        {
+            Vector<Type, StateSize> newVec;
+
+            for (size_t i = 0; i < StateSize; i++)
+                newVec.data[i] = this->states[this->StateIndex(track, i)];
+
+            return newVec;
+        }
+
+        void SetCovariance(size_t track, const Matrix<Type, StateSize, StateSize> &covariance)
+        {
+            for (size_t i = 0; i < StateSize * StateSize; i++)
+                this->covariances[this->CovarianceIndex(track, i)] = covariance.data[i];
+        }
+
+        Matrix<Type, StateSize, StateSize> Covariance(size_t track) const
+        {
+            Matrix<Type, StateSize, StateSize> newMat;
+
+            for (size_t i = 0; i < StateSize * StateSize; i++)
+                newMat.data[i] = this->covariances[this->CovarianceIndex(track, i)];
+
+            return newMat;
+        }
+
+        // Prediction of every track, x = F x and P = F P Fᵀ + Q. Zero elements of F are skipped,
+        // which removes most of the work for the sparse transitions of motion models.
+
+        void Predict(const Matrix<Type, StateSize, StateSize> &transition, const Matrix<Type, StateSize, StateSize> &noise)
+        {
+            constexpr size_t N = StateSize;
+            const Type *f = transition.data;
+
+            ParallelFor(0, this->blocks, 16, [&](size_t blockBegin, size_t blockEnd)
+            {
+                Type newX[N * Lanes];
+                Type fp[N * N * Lanes];
+
+                for (size_t block = blockBegin; block < blockEnd; block++)
+                {
+                    Type *x = this->states.data() + block * N * Lanes;
+                    Type *p = this->covariances.data() + block * N * N * Lanes;
+
+                    std::fill(newX, newX + N * Lanes, Type(0));
+                    std::fill(fp, fp + N * N * Lanes, Type(0));
+
+                    for (size_t k = 0; k < N; k++)
+                    {
+                        for (size_t row = 0; row < N; row++)
+                        {
+                            const Type value = f[k * N + row];
+
+                            if (value == Type(0))
+                                continue;
+
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                                newX[row * Lanes + lane] += value * x[k * Lanes + lane];
+
+                            // FP(row, col) += F(row, k) P(k, col)
+
+                            for (size_t col = 0; col < N; col++)
+                            {
+                                for (size_t lane = 0; lane < Lanes; lane++)
+                                    fp[(col * N + row) * Lanes + lane] += value * p[(col * N + k) * Lanes + lane];
+                            }
+                        }
+                    }
+
+                    std::copy(newX, newX + N * Lanes, x);
+
+                    // P(row, col) = Σ FP(row, k) F(col, k) + Q(row, col), upper triangle mirrored
+
+                    for (size_t col = 0; col < N; col++)
+                    {
+                        for (size_t row = 0; row <= col; row++)
+                        {
+                            Type sum[Lanes];
+                            const Type q = (noise.data[col * N + row] + noise.data[row * N + col]) / 2;
+
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                                sum[lane] = q;
+
+                            for (size_t k = 0; k < N; k++)
+                            {
+                                const Type value = f[k * N + col];
+
+                                if (value == Type(0))
+                                    continue;
+
+                                for (size_t lane = 0; lane < Lanes; lane++)
+                                    sum[lane] += fp[(k * N + row) * Lanes + lane] * value;
+                            }
+
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                            {
+                                p[(col * N + row) * Lanes + lane] = sum[lane];
+                                p[(row * N + col) * Lanes + lane] = sum[lane];
+                            }
+                        }
+                    }
+                }
+            });
+        }
+
+        // Update of every track with its measurement, measurements[track * MeasurementSize + i].
+        // The innovation covariance S = H P Hᵀ + R is factored by Cholesky in each lane, the gain
+        // K = P Hᵀ S⁻¹ comes from two triangular solves, and the covariance is updated in the
+        // symmetric Joseph form P = (I - K H) P (I - K H)ᵀ + K R Kᵀ. Tracks with valid[track]
+        // false, or whose S is not positive definite, are left unchanged. Returns the number of
+        // tracks skipped because S was not positive definite.
+
+        size_t Update(const Matrix<Type, MeasurementSize, StateSize> &observation, const Matrix<Type, MeasurementSize, MeasurementSize> &noise,
+            const Type *measurements, const bool *valid = nullptr)
+        {
+            constexpr size_t N = StateSize;
+            constexpr size_t M = MeasurementSize;
+            const Type *h = observation.data;
+            const Type *r = noise.data;
+            std::atomic<size_t> failures(0);
+
+            ParallelFor(0, this->blocks, 16, [&](size_t blockBegin, size_t blockEnd)
+            {
+                Type innovation[M * Lanes];
+                Type pht[N * M * Lanes];
+                Type s[M * M * Lanes];
+                Type gain[N * M * Lanes];
+                Type a[N * N * Lanes];
+                Type ap[N * N * Lanes];
+                Type kr[N * M * Lanes];
+                bool active[Lanes];
+                size_t blockFailures = 0;
+
+                for (size_t block = blockBegin; block < blockEnd; block++)
+                {
+                    Type *x = this->states.data() + block * N * Lanes;
+                    Type *p = this->covariances.data() + block * N * N * Lanes;
+
+                    // Innovation y = z - H x; lanes past the last track are inactive, and their
+                    // measurements are not read
+
+                    for (size_t lane = 0; lane < Lanes; lane++)
+                    {
+                        const size_t track = block * Lanes + lane;
+                        active[lane] = track < this->count && (valid == nullptr || valid[track]);
+
+                        for (size_t i = 0; i < M; i++)
+                            innovation[i * Lanes + lane] = active[lane] ? measurements[track * M + i] : Type(0);
+                    }
+
+                    for (size_t i = 0; i < M; i++)
+                    {
+                        for (size_t k = 0; k < N; k++)
+                        {
+                            const Type value = h[k * M + i];
+
+                            if (value == Type(0))
+                                continue;
+
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                                innovation[i * Lanes + lane] -= value * x[k * Lanes + lane];
+                        }
+                    }
+
+                    // P Hᵀ (N x M), PHt(row, j) = Σ P(row, k) H(j, k)
+
+                    for (size_t j = 0; j < M; j++)
+                    {
+                        for (size_t row = 0; row < N; row++)
+                        {
+                            Type sum[Lanes] = {};
+
+                            for (size_t k = 0; k < N; k++)
+                            {
+                                const Type value = h[k * M + j];
+
+                                if (value == Type(0))
+                                    continue;
+
+                                for (size_t lane = 0; lane < Lanes; lane++)
+                                    sum[lane] += p[(k * N + row) * Lanes + lane] * value;
+                            }
+
+                            std::copy(sum, sum + Lanes, pht + (j * N + row) * Lanes);
+                        }
+                    }
+
+                    // S = H PHt + R, lower triangle
+
+                    for (size_t col = 0; col < M; col++)
+                    {
+                        for (size_t row = col; row < M; row++)
+                        {
+                            Type sum[Lanes];
+                            const Type rValue = (r[col * M + row] + r[row * M + col]) / 2;
+
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                                sum[lane] = rValue;
+
+                            for (size_t k = 0; k < N; k++)
+                            {
+                                const Type value = h[k * M + row];
+
+                                if (value == Type(0))
+                                    continue;
+
+                                for (size_t lane = 0; lane < Lanes; lane++)
+                                    sum[lane] += value * pht[(col * N + k) * Lanes + lane];
+                            }
+
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                                s[(col * M + row) * Lanes + lane] = sum[lane];
+                        }
+                    }
+
+                    // Cholesky S = L Lᵀ in each lane. A non-positive pivot deactivates the lane and
+                    // is replaced by 1 so the remaining arithmetic stays finite.
+
+                    for (size_t col = 0; col < M; col++)
+                    {
+                        for (size_t k = 0; k < col; k++)
+                        {
+                            for (size_t row = col; row < M; row++)
+                            {
+                                for (size_t lane = 0; lane < Lanes; lane++)
+                                    s[(col * M + row) * Lanes + lane] -= s[(k * M + row) * Lanes + lane] * s[(k * M + col) * Lanes + lane];
+                            }
+                        }
+
+                        Type inverse[Lanes];
+
+                        for (size_t lane = 0; lane < Lanes; lane++)
+                        {
+                            Type &pivot = s[(col * M + col) * Lanes + lane];
+                            const bool positive = pivot > Type(0);
+
+                            blockFailures += active[lane] && !positive;
+                            active[lane] = active[lane] && positive;
+                            pivot = std::sqrt(positive ? pivot : Type(1));
+                            inverse[lane] = 1 / pivot;
+                        }
+
+                        for (size_t row = col + 1; row < M; row++)
+                        {
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                                s[(col * M + row) * Lanes + lane] *= inverse[lane];
+                        }
+                    }
+
+                    // Gain: row r of K solves S k = PHt(r, :) by L w = PHt(r, :) and Lᵀ k = w,
+                    // then inactive lanes get K = 0 so the update leaves them unchanged
+
+                    for (size_t row = 0; row < N; row++)
+                    {
+                        for (size_t j = 0; j < M; j++)
+                        {
+                            Type value[Lanes];
+
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                                value[lane] = pht[(j * N + row) * Lanes + lane];
+
+                            for (size_t k = 0; k < j; k++)
+                            {
+                                for (size_t lane = 0; lane < Lanes; lane++)
+                                    value[lane] -= s[(k * M + j) * Lanes + lane] * gain[(k * N + row) * Lanes + lane];
+                            }
+
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                                gain[(j * N + row) * Lanes + lane] = value[lane] / s[(j * M + j) * Lanes + lane];
+                        }
+
+                        for (size_t j = M; j-- > 0;)
+                        {
+                            Type value[Lanes];
+
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                                value[lane] = gain[(j * N + row) * Lanes + lane];
+
+                            for (size_t k = j + 1; k < M; k++)
+                            {
+                                for (size_t lane = 0; lane < Lanes; lane++)
+                                    value[lane] -= s[(j * M + k) * Lanes + lane] * gain[(k * N + row) * Lanes + lane];
+                            }
+
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                                gain[(j * N + row) * Lanes + lane] = value[lane] / s[(j * M + j) * Lanes + lane];
+                        }
+
+                        for (size_t j = 0; j < M; j++)
+                        {
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                                gain[(j * N + row) * Lanes + lane] = active[lane] ? gain[(j * N + row) * Lanes + lane] : Type(0);
+                        }
+                    }
+
+                    // x += K y
+
+                    for (size_t j = 0; j < M; j++)
+                    {
+                        for (size_t row = 0; row < N; row++)
+                        {
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                                x[row * Lanes + lane] += gain[(j * N + row) * Lanes + lane] * innovation[j * Lanes + lane];
+                        }
+                    }
+
+                    // A = I - K H
+
+                    for (size_t col = 0; col < N; col++)
+                    {
+                        for (size_t row = 0; row < N; row++)
+                        {
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                                a[(col * N + row) * Lanes + lane] = row == col ? Type(1) : Type(0);
+                        }
+
+                        for (size_t j = 0; j < M; j++)
+                        {
+                            const Type value = h[col * M + j];
+
+                            if (value == Type(0))
+                                continue;
+
+                            for (size_t row = 0; row < N; row++)
+                            {
+                                for (size_t lane = 0; lane < Lanes; lane++)
+                                    a[(col * N + row) * Lanes + lane] -= gain[(j * N + row) * Lanes + lane] * value;
+                            }
+                        }
+                    }
+
+                    // AP = A P and KR = K R
+
+                    for (size_t col = 0; col < N; col++)
+                    {
+                        for (size_t row = 0; row < N; row++)
+                        {
+                            Type sum[Lanes] = {};
+
+                            for (size_t k = 0; k < N; k++)
+                            {
+                                for (size_t lane = 0; lane < Lanes; lane++)
+                                    sum[lane] += a[(k * N + row) * Lanes + lane] * p[(col * N + k) * Lanes + lane];
+                            }
+
+                            std::copy(sum, sum + Lanes, ap + (col * N + row) * Lanes);
+                        }
+                    }
+
+                    for (size_t col = 0; col < M; col++)
+                    {
+                        for (size_t row = 0; row < N; row++)
+                        {
+                            Type sum[Lanes] = {};
+
+                            for (size_t k = 0; k < M; k++)
+                            {
+                                const Type value = r[col * M + k];
+
+                                for (size_t lane = 0; lane < Lanes; lane++)
+                                    sum[lane] += gain[(k * N + row) * Lanes + lane] * value;
+                            }
+
+                            std::copy(sum, sum + Lanes, kr + (col * N + row) * Lanes);
+                        }
+                    }
+
+                    // P = AP Aᵀ + KR Kᵀ, upper triangle mirrored
+
+                    for (size_t col = 0; col < N; col++)
+                    {
+                        for (size_t row = 0; row <= col; row++)
+                        {
+                            Type sum[Lanes] = {};
+
+                            for (size_t k = 0; k < N; k++)
+                            {
+                                for (size_t lane = 0; lane < Lanes; lane++)
+                                    sum[lane] += ap[(k * N + row) * Lanes + lane] * a[(k * N + col) * Lanes + lane];
+                            }
+
+                            for (size_t j = 0; j < M; j++)
+                            {
+                                for (size_t lane = 0; lane < Lanes; lane++)
+                                    sum[lane] += kr[(j * N + row) * Lanes + lane] * gain[(j * N + col) * Lanes + lane];
+                            }
+
+                            for (size_t lane = 0; lane < Lanes; lane++)
+                            {
+                                p[(col * N + row) * Lanes + lane] = sum[lane];
+                                p[(row * N + col) * Lanes + lane] = sum[lane];
+                            }
+                        }
+                    }
+                }
+
+                failures += blockFailures;
+            });
+
+            return failures.load();
+        }
+
+        private:
+
+        size_t count;
+        size_t blocks;
+        std::vector<Type> states;
+        std::vector<Type> covariances;
+
+        size_t StateIndex(size_t track, size_t i) const
+        {
+            if (track >= this->count)
+                throw std::runtime_error("KalmanBatch: track index out of range.");
+            return ((track / Lanes) * StateSize + i) * Lanes + track % Lanes;
+        }
+
+        size_t CovarianceIndex(size_t track, size_t i) const
+        {
+            if (track >= this->count)
+                throw std::runtime_error("KalmanBatch: track index out of range.");
+            return ((track / Lanes) * StateSize * StateSize + i) * Lanes + track % Lanes;
+        }
+    };
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <Math/Matrix.hpp>
+
+namespace Scoop::Math
+{
+    // Kronecker product
+
+    template <typename Type, size_t Rows1, size_t Cols1, size_t Rows2, size_t Cols2>
+    void Kronecker(const Matrix<Type, Rows1, Cols1> &a, const Matrix<Type, Rows2, Cols2> &b, Matrix<Type, Rows1 * Rows2, Cols1 * Cols2> &out)
+    {
+        Type *dst = out.data;
+
+        for (size_t col1 = 0; col1 < Cols1; col1++)
+        {
+            for (size_t col2 = 0; col2 < Cols2; col2++)
+            {
+                const Type *bCol = b.data + col2 * Rows2;
+
+                for (size_t row1 = 0; row1 < Rows1; row1++)
+                {
+                    const Type scale = a.data[col1 * Rows1 + row1];
+
+                    for (size_t row2 = 0; row2 < Rows2; row2++)
+                        dst[row2] = scale * bCol[row2];
+
+                    dst += Rows2;
+                }
+            }
+        }
+    }
+
+    template <typename Type, size_t Rows1, size_t Cols1, size_t Rows2, size_t Cols2>
+    Matrix<Type, Rows1 * Rows2, Cols1 * Cols2> Kronecker(const Matrix<Type, Rows1, Cols1> &a, const Matrix<Type, Rows2, Cols2> &b)
+    {
+        Matrix<Type, Rows1 * Rows2, Cols1 * Cols2> newMat;
+        Kronecker(a, b, newMat);
+        return newMat;
+    }
+
+    // Implicit Kronecker product, (A ⊗ B) vec(X) = vec(B X Aᵀ)
+
+    template <typename Type, size_t Rows1, size_t Cols1, size_t Rows2, size_t Cols2>
+    Matrix<Type, Rows2, Rows1> KroneckerMultiply(const Matrix<Type, Rows1, Cols1> &a, const Matrix<Type, Rows2, Cols2> &b, const Matrix<Type, Cols2, Cols1> &x)
+    {
+        Matrix<Type, Rows2, Rows1> newMat;
+
+        // Pick the association with fewer multiplications: (B X) Aᵀ or B (X Aᵀ)
+
+        if (Rows2 * Cols2 * Cols1 + Rows2 * Cols1 * Rows1 <= Cols2 * Cols1 * Rows1 + Rows2 * Cols2 * Rows1)
+        {
+            Matrix<Type, Rows2, Cols1> bx;
+
+            for (size_t col = 0; col < Cols1; col++)
+            {
+                Type *dst = bx.data + col * Rows2;
+
+                for (size_t row = 0; row < Rows2; row++)
+                    dst[row] = 0;
+
+                for (size_t m = 0; m < Cols2; m++)
+                {
+                    const Type scale = x.data[col * Cols2 + m];
+                    const Type *bCol = b.data + m * Rows2;
+
+                    for (size_t row = 0; row < Rows2; row++)
+                        dst[row] += scale * bCol[row];
+                }
+            }
+
+            for (size_t col = 0; col < Rows1; col++)
+            {
+                Type *dst = newMat.data + col * Rows2;
+
+                for (size_t row = 0; row < Rows2; row++)
+                    dst[row] = 0;
+
+                for (size_t m = 0; m < Cols1; m++)
+                {
+                    const Type scale = a.data[m * Rows1 + col];
+                    const Type *bxCol = bx.data + m * Rows2;
+
+                    for (size_t row = 0; row < Rows2; row++)
+                        dst[row] += scale * bxCol[row];
+                }
+            }
+        }
+        else
+        {
+            Matrix<Type, Cols2, Rows1> xa;
+
+            for (size_t col = 0; col < Rows1; col++)
+            {
+                Type *dst = xa.data + col * Cols2;
+
+                for (size_t row = 0; row < Cols2; row++)
+                    dst[row] = 0;
+
+                for (size_t m = 0; m < Cols1; m++)
+                {
+                    const Type scale = a.data[m * Rows1 + col];
+                    const Type *xCol = x.data + m * Cols2;
+
+                    for (size_t row = 0; row < Cols2; row++)
+                        dst[row] += scale * xCol[row];
+                }
+            }
+
+            for (size_t col = 0; col < Rows1; col++)
+            {
+                Type *dst = newMat.data + col * Rows2;
+
+                for (size_t row = 0; row < Rows2; row++)
+                    dst[row] = 0;
+
+                for (size_t m = 0; m < Cols2; m++)
+                {
+                    const Type scale = xa.data[col * Cols2 + m];
+                    const Type *bCol = b.data + m * Rows2;
+
+                    for (size_t row = 0; row < Rows2; row++)
+                        dst[row] += scale * bCol[row];
+                }
+            }
+        }
+
+        return newMat;
+    }
+
+    template <typename Type, size_t Rows1, size_t Cols1, size_t Rows2, size_t Cols2>
+    Vector<Type, Rows1 * Rows2> KroneckerMultiply(const Matrix<Type, Rows1, Cols1> &a, const Matrix<Type, Rows2, Cols2> &b, const Vector<Type, Cols1 * Cols2> &vec)
+    {
+        Matrix<Type, Cols2, Cols1> x;
+        std::copy(vec.data, vec.data + Cols1 * Cols2, x.data);
+
+        Matrix<Type, Rows2, Rows1> product = KroneckerMultiply(a, b, x);
+
+        Vector<Type, Rows1 * Rows2> newVec;
+        std::copy(product.data, product.data + Rows1 * Rows2, newVec.data);
+        return newVec;
+    }
+
+    // Khatri-Rao (column-wise Kronecker) product
+
+    template <typename Type, size_t Rows1, size_t Rows2, size_t Cols>
+    void KhatriRao(const Matrix<Type, Rows1, Cols> &a, const Matrix<Type, Rows2, Cols> &b, Matrix<Type, Rows1 * Rows2, Cols> &out)
+    {
+        for (size_t col = 0; col < Cols; col++)
+        {
+            const Type *aCol = a.data + col * Rows1;
+            const Type *bCol = b.data + col * Rows2;
+            Type *dst = out.data + col * Rows1 * Rows2;
+
+            for (size_t row1 = 0; row1 < Rows1; row1++)
+            {
+                const Type scale = aCol[row1];
+
+                for (size_t row2 = 0; row2 < Rows2; row2++)
+                    dst[row2] = scale * bCol[row2];
+
+                dst += Rows2;
+            }
+        }
+    }
+
+    template <typename Type, size_t Rows1, size_t Rows2, size_t Cols>
+    Matrix<Type, Rows1 * Rows2, Cols> KhatriRao(const Matrix<Type, Rows1, Cols> &a, const Matrix<Type, Rows2, Cols> &b)
+    {
+        Matrix<Type, Rows1 * Rows2, Cols> newMat;
+        KhatriRao(a, b, newMat);
+        return newMat;
+    }
+}
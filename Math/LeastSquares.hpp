@@ -0,0 +1,853 @@
+#pragma once
+
+#include <Math/SparseCholesky.hpp>
+#include <Math/Ordering.hpp>
+
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace Scoop::Math
+{
+    // Nonlinear least squares options and results
+
+    enum class LeastSquaresMethod
+    {
+        GaussNewton,
+        LevenbergMarquardt
+    };
+
+    struct LeastSquaresOptions
+    {
+        LeastSquaresMethod method = LeastSquaresMethod::LevenbergMarquardt;
+        size_t maxIterations = 100;
+        double gradientTolerance = 1e-10;
+        double stepTolerance = 1e-10;
+        double costTolerance = 1e-12;
+        double initialDamping = 1e-4;
+    };
+
+    template <typename Type> struct LeastSquaresResult
+    {
+        std::vector<Type> parameters;
+        Type initialCost = 0;
+        Type cost = 0;
+        size_t iterations = 0;
+        size_t evaluations = 0;
+        bool converged = false;
+    };
+
+    // Nonlinear least squares kernels
+    //
+    // Problems minimize ½‖r(x)‖² over residual blocks evaluated by user callbacks. Each iteration
+    // linearizes the residuals, forms the normal equations JᵀJ h = -Jᵀr without storing Jᵀ, and
+    // solves them by Cholesky.
+
+    namespace Detail
+    {
+        // Reduced camera systems up to this size are factored densely, larger ones by SparseCholesky
+
+        constexpr size_t SchurDenseLimit = 256;
+
+        // Marquardt scaling of the damping by the diagonal of JᵀJ, kept away from 0 and infinity
+
+        template <typename Type>
+        Type LeastSquaresDamping(Type diagonal)
+        { return std::min(std::max(diagonal, Type(1e-6)), Type(1e32)); }
+
+        // C (+)= AᵀB for Rows x ACols a and Rows x BCols b, column-major with leading dimension Rows
+
+        template <size_t Rows, size_t ACols, size_t BCols, typename Type>
+        void SmallInnerProducts(const Type *a, const Type *b, Type *c, bool accumulate)
+        {
+            for (size_t j = 0; j < BCols; j++)
+            {
+                for (size_t i = 0; i < ACols; i++)
+                {
+                    Type sum = accumulate ? c[j * ACols + i] : Type(0);
+
+                    for (size_t row = 0; row < Rows; row++)
+                        sum += a[i * Rows + row] * b[j * Rows + row];
+
+                    c[j * ACols + i] = sum;
+                }
+            }
+        }
+
+        // Damped Gauss-Newton iterations on a model that provides
+        //
+        //     Type Linearize(const Type *x, Type *gradient)   cost at x, with gradient Jᵀr and JᵀJ formed
+        //     bool Solve(Type lambda, const Type *gradient, Type *step)   (JᵀJ + λD) h = -Jᵀr
+        //     Type Cost(const Type *x)
+        //     const std::vector<Type> &Damping() const   the diagonal D
+        //
+        // Levenberg-Marquardt steps are accepted when they reduce the cost, and the damping follows
+        // the gain ratio against the decrease predicted by the linear model. Gauss-Newton runs
+        // undamped and stops at the first step that fails.
+
+        template <typename Type, typename Model>
+        LeastSquaresResult<Type> LevenbergMarquardt(Model &model, std::vector<Type> x, const LeastSquaresOptions &options)
+        {
+            const size_t n = x.size();
+            const bool damped = options.method == LeastSquaresMethod::LevenbergMarquardt;
+            std::vector<Type> gradient(n), step(n), trial(n);
+            LeastSquaresResult<Type> result;
+
+            Type cost = model.Linearize(x.data(), gradient.data());
+            Type lambda = damped ? Type(options.initialDamping) : Type(0);
+            Type growth = 2;
+
+            result.initialCost = cost;
+            result.evaluations = 1;
+
+            auto increaseDamping = [&]()
+            {
+                lambda = std::max(lambda, std::numeric_limits<Type>::epsilon()) * growth;
+                growth *= 2;
+            };
+
+            while (result.iterations < options.maxIterations)
+            {
+                Type gradientNorm = 0;
+
+                for (size_t i = 0; i < n; i++)
+                    gradientNorm = std::max(gradientNorm, std::abs(gradient[i]));
+
+                if (gradientNorm <= Type(options.gradientTolerance))
+                {
+                    result.converged = true;
+                    break;
+                }
+
+                result.iterations++;
+
+                if (!model.Solve(lambda, gradient.data(), step.data()))
+                {
+                    if (!damped)
+                        break;
+
+                    increaseDamping();
+                    continue;
+                }
+
+                Type stepNorm = 0;
+                Type norm = 0;
+
+                for (size_t i = 0; i < n; i++)
+                {
+                    stepNorm += step[i] * step[i];
+                    norm += x[i] * x[i];
+                    trial[i] = x[i] + step[i];
+                }
+
+                if (std::sqrt(stepNorm) <= Type(options.stepTolerance) * (std::sqrt(norm) + Type(options.stepTolerance)))
+                {
+                    result.converged = true;
+                    break;
+                }
+
+                const Type newCost = model.Cost(trial.data());
+                result.evaluations++;
+
+                if (!(newCost < cost))
+                {
+                    if (!damped)
+                        break;
+
+                    increaseDamping();
+                    continue;
+                }
+
+                // Predicted decrease ½ hᵀ(λDh - Jᵀr)
+
+                const std::vector<Type> &damping = model.Damping();
+                Type predicted = 0;
+
+                for (size_t i = 0; i < n; i++)
+                    predicted += step[i] * (lambda * damping[i] * step[i] - gradient[i]);
+
+                predicted /= 2;
+
+                const Type ratio = predicted > Type(0) ? (cost - newCost) / predicted : Type(1);
+                const Type decrease = (cost - newCost) / cost;
+
+                x.swap(trial);
+                cost = model.Linearize(x.data(), gradient.data());
+                result.evaluations++;
+
+                if (damped)
+                {
+                    const Type t = 2 * ratio - 1;
+                    lambda *= std::max(Type(1) / 3, 1 - t * t * t);
+                    growth = 2;
+                }
+
+                if (decrease <= Type(options.costTolerance))
+                {
+                    result.converged = true;
+                    break;
+                }
+            }
+
+            result.parameters = std::move(x);
+            result.cost = cost;
+            return result;
+        }
+
+        // Dense problems: blocks residual blocks of blockResiduals rows, each depending on all n
+        // parameters. The Jacobian rows of a chunk of blocks are evaluated into a tall panel of at
+        // most GemmSkinnyTile rows, and the upper triangle of JᵀJ and Jᵀr are reduced from the
+        // panel while it is in cache. Chunks are split between threads and their partial sums added.
+
+        template <typename Type, typename Function> class DenseLeastSquares
+        {
+            public:
+
+            DenseLeastSquares(size_t n, size_t blocks, size_t blockResiduals, const Function &evaluate)
+                : n(n), blocks(blocks), blockResiduals(blockResiduals), batch(std::max<size_t>(1, GemmSkinnyTile / std::max<size_t>(blockResiduals, 1))),
+                  evaluate(evaluate), normal(n * n), damping(n), factor(n * n)
+            { }
+
+            Type Linearize(const Type *x, Type *gradient)
+            {
+                const size_t m = this->blockResiduals;
+                const size_t ld = this->batch * m;
+                std::mutex mutex;
+                Type cost = 0;
+
+                std::fill(this->normal.begin(), this->normal.end(), Type(0));
+                std::fill(gradient, gradient + this->n, Type(0));
+
+                ParallelFor(0, this->blocks, this->batch, [&](size_t blockBegin, size_t blockEnd)
+                {
+                    std::vector<Type> panel(ld * this->n), residuals(ld);
+                    std::vector<Type> partialNormal(this->n * this->n, Type(0)), partialGradient(this->n, Type(0));
+                    Type partialCost = 0;
+
+                    for (size_t first = blockBegin; first < blockEnd; first += this->batch)
+                    {
+                        const size_t count = std::min(this->batch, blockEnd - first);
+                        const size_t rows = count * m;
+
+                        for (size_t k = 0; k < count; k++)
+                            this->evaluate(first + k, x, residuals.data() + k * m, panel.data() + k * m, ld);
+
+                        partialCost += Dot(residuals.data(), residuals.data(), rows);
+
+                        for (size_t col = 0; col < this->n; col++)
+                        {
+                            const Type *jCol = panel.data() + col * ld;
+                            partialGradient[col] += Dot(jCol, residuals.data(), rows);
+
+                            for (size_t row = 0; row <= col; row++)
+                                partialNormal[col * this->n + row] += Dot(panel.data() + row * ld, jCol, rows);
+                        }
+                    }
+
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    cost += partialCost;
+
+                    for (size_t i = 0; i < this->n; i++)
+                        gradient[i] += partialGradient[i];
+                    for (size_t i = 0; i < this->n * this->n; i++)
+                        this->normal[i] += partialNormal[i];
+                });
+
+                for (size_t col = 0; col < this->n; col++)
+                {
+                    for (size_t row = 0; row < col; row++)
+                        this->normal[row * this->n + col] = this->normal[col * this->n + row];
+
+                    this->damping[col] = LeastSquaresDamping(this->normal[col * this->n + col]);
+                }
+
+                return cost / 2;
+            }
+
+            bool Solve(Type lambda, const Type *gradient, Type *step)
+            {
+                std::copy(this->normal.begin(), this->normal.end(), this->factor.begin());
+
+                for (size_t i = 0; i < this->n; i++)
+                    this->factor[i * this->n + i] += lambda * this->damping[i];
+
+                if (!CholeskyFactor(this->n, this->factor.data(), this->n))
+                    return false;
+
+                for (size_t i = 0; i < this->n; i++)
+                    step[i] = -gradient[i];
+
+                CholeskySolve(this->n, this->factor.data(), this->n, step, this->n, 1);
+                return true;
+            }
+
+            Type Cost(const Type *x)
+            {
+                const size_t m = this->blockResiduals;
+                std::mutex mutex;
+                Type cost = 0;
+
+                ParallelFor(0, this->blocks, this->batch, [&](size_t blockBegin, size_t blockEnd)
+                {
+                    std::vector<Type> residuals(m);
+                    Type partialCost = 0;
+
+                    for (size_t block = blockBegin; block < blockEnd; block++)
+                    {
+                        this->evaluate(block, x, residuals.data(), nullptr, 0);
+                        partialCost += Dot(residuals.data(), residuals.data(), m);
+                    }
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    cost += partialCost;
+                });
+
+                return cost / 2;
+            }
+
+            const std::vector<Type> &Damping() const
+            { return this->damping; }
+
+            private:
+
+            size_t n;
+            size_t blocks;
+            size_t blockResiduals;
+            size_t batch;
+            const Function &evaluate;
+            std::vector<Type> normal;
+            std::vector<Type> damping;
+            std::vector<Type> factor;
+        };
+
+        // Bundle-adjustment-shaped problems: each observation is a block of ResidualSize residuals
+        // that depends on one camera (CameraSize parameters) and one point (PointSize parameters).
+        // The point blocks V of JᵀJ are block diagonal, so they are eliminated: the reduced camera
+        // system S = U - W V⁻¹ Wᵀ is solved for the camera step, and each point step follows from
+        // its own small system. S has a block for each pair of cameras that share a point; the
+        // products that contribute to each block are listed once, so blocks are formed in parallel
+        // without conflicts. Small reduced systems are factored densely, larger ones by
+        // SparseCholesky, whose symbolic analysis is kept across iterations.
+
+        template <typename Type, size_t ResidualSize, size_t CameraSize, size_t PointSize, typename Function> class SchurLeastSquares
+        {
+            public:
+
+            static constexpr size_t R = ResidualSize;
+            static constexpr size_t C = CameraSize;
+            static constexpr size_t P = PointSize;
+
+            SchurLeastSquares(size_t cameraCount, size_t pointCount, const std::vector<std::pair<size_t, size_t>> &observations, const Function &evaluate)
+                : cameraCount(cameraCount), pointCount(pointCount), observations(observations), evaluate(evaluate)
+            {
+                const size_t count = observations.size();
+                const size_t none = size_t(-1);
+
+                // Observations of each camera and of each point
+
+                this->cameraOffsets.assign(cameraCount + 1, 0);
+                this->pointOffsets.assign(pointCount + 1, 0);
+
+                for (const std::pair<size_t, size_t> &observation : observations)
+                {
+                    this->cameraOffsets[observation.first + 1]++;
+                    this->pointOffsets[observation.second + 1]++;
+                }
+
+                for (size_t i = 0; i < cameraCount; i++)
+                    this->cameraOffsets[i + 1] += this->cameraOffsets[i];
+                for (size_t j = 0; j < pointCount; j++)
+                    this->pointOffsets[j + 1] += this->pointOffsets[j];
+
+                this->cameraObservations.resize(count);
+                this->pointObservations.resize(count);
+
+                std::vector<size_t> cameraFill(this->cameraOffsets.begin(), this->cameraOffsets.end() - 1);
+                std::vector<size_t> pointFill(this->pointOffsets.begin(), this->pointOffsets.end() - 1);
+
+                for (size_t a = 0; a < count; a++)
+                {
+                    this->cameraObservations[cameraFill[observations[a].first]++] = a;
+                    this->pointObservations[pointFill[observations[a].second]++] = a;
+                }
+
+                // Blocks (i, k), i ≥ k, of the lower triangle of S, with the observation pairs
+                // (a, b) of a shared point that contribute -Y_a W_bᵀ to them
+
+                std::vector<std::tuple<size_t, size_t, size_t, size_t>> terms;
+
+                for (size_t i = 0; i < cameraCount; i++)
+                    terms.emplace_back(i, i, none, none);
+
+                for (size_t j = 0; j < pointCount; j++)
+                {
+                    for (size_t s = this->pointOffsets[j]; s < this->pointOffsets[j + 1]; s++)
+                    {
+                        for (size_t t = this->pointOffsets[j]; t < this->pointOffsets[j + 1]; t++)
+                        {
+                            const size_t a = this->pointObservations[s];
+                            const size_t b = this->pointObservations[t];
+
+                            if (observations[a].first >= observations[b].first)
+                                terms.emplace_back(observations[a].first, observations[b].first, a, b);
+                        }
+                    }
+                }
+
+                std::sort(terms.begin(), terms.end());
+
+                this->termOffsets.push_back(0);
+
+                for (size_t t = 0; t < terms.size(); t++)
+                {
+                    const size_t i = std::get<0>(terms[t]);
+                    const size_t k = std::get<1>(terms[t]);
+
+                    if (t == 0 || i != std::get<0>(terms[t - 1]) || k != std::get<1>(terms[t - 1]))
+                    {
+                        if (t > 0)
+                            this->termOffsets.push_back(this->termA.size());
+
+                        this->blockRows.push_back(i);
+                        this->blockCols.push_back(k);
+                    }
+
+                    if (std::get<2>(terms[t]) != none)
+                    {
+                        this->termA.push_back(std::get<2>(terms[t]));
+                        this->termB.push_back(std::get<3>(terms[t]));
+                    }
+                }
+
+                this->termOffsets.push_back(this->termA.size());
+
+                const size_t reducedSize = cameraCount * C;
+                const size_t n = reducedSize + pointCount * P;
+
+                this->residuals.resize(count * R);
+                this->trialResiduals.resize(count * R);
+                this->cameraJacobians.resize(count * R * C);
+                this->pointJacobians.resize(count * R * P);
+                this->u.resize(cameraCount * C * C);
+                this->v.resize(pointCount * P * P);
+                this->w.resize(count * C * P);
+                this->pointFactors.resize(pointCount * P * P);
+                this->yt.resize(count * P * C);
+                this->blocks.resize(this->blockRows.size() * C * C);
+                this->damping.resize(n);
+
+                if (reducedSize <= SchurDenseLimit)
+                    this->reduced.resize(reducedSize * reducedSize);
+            }
+
+            Type Linearize(const Type *x, Type *gradient)
+            {
+                const size_t count = this->observations.size();
+                const size_t reducedSize = this->cameraCount * C;
+                const Type *points = x + reducedSize;
+
+                ParallelFor(0, count, 64, [&](size_t begin, size_t end)
+                {
+                    for (size_t a = begin; a < end; a++)
+                    {
+                        this->evaluate(a, x + this->observations[a].first * C, points + this->observations[a].second * P,
+                            this->residuals.data() + a * R, this->cameraJacobians.data() + a * R * C, this->pointJacobians.data() + a * R * P);
+                    }
+                });
+
+                // U, V and Jᵀr per camera and point, and W per observation
+
+                ParallelFor(0, this->cameraCount, 16, [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        Type *ui = this->u.data() + i * C * C;
+                        Type *gi = gradient + i * C;
+
+                        std::fill(ui, ui + C * C, Type(0));
+                        std::fill(gi, gi + C, Type(0));
+
+                        for (size_t s = this->cameraOffsets[i]; s < this->cameraOffsets[i + 1]; s++)
+                        {
+                            const size_t a = this->cameraObservations[s];
+                            const Type *jc = this->cameraJacobians.data() + a * R * C;
+
+                            SmallInnerProducts<R, C, C>(jc, jc, ui, true);
+                            SmallInnerProducts<R, C, 1>(jc, this->residuals.data() + a * R, gi, true);
+                        }
+                    }
+                });
+
+                ParallelFor(0, this->pointCount, 16, [&](size_t begin, size_t end)
+                {
+                    for (size_t j = begin; j < end; j++)
+                    {
+                        Type *vj = this->v.data() + j * P * P;
+                        Type *gj = gradient + reducedSize + j * P;
+
+                        std::fill(vj, vj + P * P, Type(0));
+                        std::fill(gj, gj + P, Type(0));
+
+                        for (size_t s = this->pointOffsets[j]; s < this->pointOffsets[j + 1]; s++)
+                        {
+                            const size_t a = this->pointObservations[s];
+                            const Type *jp = this->pointJacobians.data() + a * R * P;
+
+                            SmallInnerProducts<R, P, P>(jp, jp, vj, true);
+                            SmallInnerProducts<R, P, 1>(jp, this->residuals.data() + a * R, gj, true);
+                        }
+                    }
+                });
+
+                ParallelFor(0, count, 64, [&](size_t begin, size_t end)
+                {
+                    for (size_t a = begin; a < end; a++)
+                        SmallInnerProducts<R, C, P>(this->cameraJacobians.data() + a * R * C, this->pointJacobians.data() + a * R * P, this->w.data() + a * C * P, false);
+                });
+
+                for (size_t i = 0; i < this->cameraCount; i++)
+                {
+                    for (size_t c = 0; c < C; c++)
+                        this->damping[i * C + c] = LeastSquaresDamping(this->u[(i * C + c) * C + c]);
+                }
+
+                for (size_t j = 0; j < this->pointCount; j++)
+                {
+                    for (size_t p = 0; p < P; p++)
+                        this->damping[reducedSize + j * P + p] = LeastSquaresDamping(this->v[(j * P + p) * P + p]);
+                }
+
+                return Dot(this->residuals.data(), this->residuals.data(), count * R) / 2;
+            }
+
+            bool Solve(Type lambda, const Type *gradient, Type *step)
+            {
+                const size_t reducedSize = this->cameraCount * C;
+                const Type *pointGradient = gradient + reducedSize;
+                std::atomic<bool> failed(false);
+
+                // Damped point blocks, factored, and Yᵀ = V⁻¹ Wᵀ for their observations
+
+                ParallelFor(0, this->pointCount, 16, [&](size_t begin, size_t end)
+                {
+                    for (size_t j = begin; j < end; j++)
+                    {
+                        Type *factor = this->pointFactors.data() + j * P * P;
+
+                        std::copy(this->v.data() + j * P * P, this->v.data() + (j + 1) * P * P, factor);
+
+                        for (size_t p = 0; p < P; p++)
+                            factor[p * P + p] += lambda * this->damping[reducedSize + j * P + p];
+
+                        if (!CholeskyFactorUnblocked(P, factor, P))
+                        {
+                            failed = true;
+                            continue;
+                        }
+
+                        for (size_t s = this->pointOffsets[j]; s < this->pointOffsets[j + 1]; s++)
+                        {
+                            const size_t a = this->pointObservations[s];
+                            const Type *wa = this->w.data() + a * C * P;
+                            Type *ya = this->yt.data() + a * P * C;
+
+                            for (size_t c = 0; c < C; c++)
+                            {
+                                for (size_t p = 0; p < P; p++)
+                                    ya[c * P + p] = wa[p * C + c];
+                            }
+
+                            CholeskySolve(P, factor, P, ya, P, C);
+                        }
+                    }
+                });
+
+                if (failed)
+                    return false;
+
+                // Blocks of S = U + λD - Σ Y_a W_bᵀ
+
+                ParallelFor(0, this->blockRows.size(), 64, [&](size_t begin, size_t end)
+                {
+                    for (size_t block = begin; block < end; block++)
+                    {
+                        Type *sBlock = this->blocks.data() + block * C * C;
+                        const size_t i = this->blockRows[block];
+
+                        if (i == this->blockCols[block])
+                        {
+                            std::copy(this->u.data() + i * C * C, this->u.data() + (i + 1) * C * C, sBlock);
+
+                            for (size_t c = 0; c < C; c++)
+                                sBlock[c * C + c] += lambda * this->damping[i * C + c];
+                        }
+                        else
+                        {
+                            std::fill(sBlock, sBlock + C * C, Type(0));
+                        }
+
+                        for (size_t t = this->termOffsets[block]; t < this->termOffsets[block + 1]; t++)
+                        {
+                            const Type *ya = this->yt.data() + this->termA[t] * P * C;
+                            const Type *wb = this->w.data() + this->termB[t] * C * P;
+
+                            for (size_t col = 0; col < C; col++)
+                            {
+                                for (size_t row = 0; row < C; row++)
+                                {
+                                    Type sum = 0;
+
+                                    for (size_t p = 0; p < P; p++)
+                                        sum += ya[row * P + p] * wb[p * C + col];
+
+                                    sBlock[col * C + row] -= sum;
+                                }
+                            }
+                        }
+                    }
+                });
+
+                // Right-hand side -g_c + Σ Y_a g_p, solved in place into the camera step
+
+                ParallelFor(0, this->cameraCount, 16, [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        Type *rhs = step + i * C;
+
+                        for (size_t c = 0; c < C; c++)
+                            rhs[c] = -gradient[i * C + c];
+
+                        for (size_t s = this->cameraOffsets[i]; s < this->cameraOffsets[i + 1]; s++)
+                        {
+                            const size_t a = this->cameraObservations[s];
+                            const Type *ya = this->yt.data() + a * P * C;
+                            const Type *gp = pointGradient + this->observations[a].second * P;
+
+                            for (size_t c = 0; c < C; c++)
+                                rhs[c] += Dot(ya + c * P, gp, P);
+                        }
+                    }
+                });
+
+                if (!this->SolveReduced(step))
+                    return false;
+
+                // Point steps V⁻¹(-g_p - Σ W_aᵀ δc)
+
+                ParallelFor(0, this->pointCount, 16, [&](size_t begin, size_t end)
+                {
+                    for (size_t j = begin; j < end; j++)
+                    {
+                        Type *pointStep = step + reducedSize + j * P;
+
+                        for (size_t p = 0; p < P; p++)
+                            pointStep[p] = -pointGradient[j * P + p];
+
+                        for (size_t s = this->pointOffsets[j]; s < this->pointOffsets[j + 1]; s++)
+                        {
+                            const size_t a = this->pointObservations[s];
+                            const Type *wa = this->w.data() + a * C * P;
+                            const Type *cameraStep = step + this->observations[a].first * C;
+
+                            for (size_t p = 0; p < P; p++)
+                                pointStep[p] -= Dot(wa + p * C, cameraStep, C);
+                        }
+
+                        CholeskySolve(P, this->pointFactors.data() + j * P * P, P, pointStep, P, 1);
+                    }
+                });
+
+                return true;
+            }
+
+            Type Cost(const Type *x)
+            {
+                const size_t count = this->observations.size();
+                const Type *points = x + this->cameraCount * C;
+
+                ParallelFor(0, count, 64, [&](size_t begin, size_t end)
+                {
+                    for (size_t a = begin; a < end; a++)
+                    {
+                        this->evaluate(a, x + this->observations[a].first * C, points + this->observations[a].second * P,
+                            this->trialResiduals.data() + a * R, nullptr, nullptr);
+                    }
+                });
+
+                return Dot(this->trialResiduals.data(), this->trialResiduals.data(), count * R) / 2;
+            }
+
+            const std::vector<Type> &Damping() const
+            { return this->damping; }
+
+            private:
+
+            size_t cameraCount;
+            size_t pointCount;
+            const std::vector<std::pair<size_t, size_t>> &observations;
+            const Function &evaluate;
+
+            std::vector<size_t> cameraOffsets;
+            std::vector<size_t> cameraObservations;
+            std::vector<size_t> pointOffsets;
+            std::vector<size_t> pointObservations;
+
+            // Block b of S is at (blockRows[b], blockCols[b]), with the observation pairs
+            // termA[t], termB[t] for t from termOffsets[b] to termOffsets[b + 1] - 1
+
+            std::vector<size_t> blockRows;
+            std::vector<size_t> blockCols;
+            std::vector<size_t> termOffsets;
+            std::vector<size_t> termA;
+            std::vector<size_t> termB;
+
+            std::vector<Type> residuals;
+            std::vector<Type> trialResiduals;
+            std::vector<Type> cameraJacobians;
+            std::vector<Type> pointJacobians;
+            std::vector<Type> u;
+            std::vector<Type> v;
+            std::vector<Type> w;
+            std::vector<Type> pointFactors;
+            std::vector<Type> yt;
+            std::vector<Type> blocks;
+            std::vector<Type> damping;
+            std::vector<Type> reduced;
+            std::unique_ptr<SparseCholesky<Type>> sparse;
+
+            bool SolveReduced(Type *rhs)
+            {
+                const size_t reducedSize = this->cameraCount * C;
+
+                if (reducedSize <= SchurDenseLimit)
+                {
+                    std::fill(this->reduced.begin(), this->reduced.end(), Type(0));
+
+                    for (size_t block = 0; block < this->blockRows.size(); block++)
+                    {
+                        const Type *sBlock = this->blocks.data() + block * C * C;
+                        Type *dst = this->reduced.data() + this->blockCols[block] * C * reducedSize + this->blockRows[block] * C;
+
+                        for (size_t col = 0; col < C; col++)
+                            std::copy(sBlock + col * C, sBlock + (col + 1) * C, dst + col * reducedSize);
+                    }
+
+                    if (!CholeskyFactor(reducedSize, this->reduced.data(), reducedSize))
+                        return false;
+
+                    CholeskySolve(reducedSize, this->reduced.data(), reducedSize, rhs, reducedSize, 1);
+                    return true;
+                }
+
+                // Lower triangle of S, in the same order every iteration so the pattern is unchanged
+
+                std::vector<Triplet<Type>> triplets;
+                triplets.reserve(this->blockRows.size() * C * C);
+
+                for (size_t block = 0; block < this->blockRows.size(); block++)
+                {
+                    const Type *sBlock = this->blocks.data() + block * C * C;
+                    const bool diagonal = this->blockRows[block] == this->blockCols[block];
+
+                    for (size_t col = 0; col < C; col++)
+                    {
+                        for (size_t row = diagonal ? col : 0; row < C; row++)
+                            triplets.push_back({ this->blockRows[block] * C + row, this->blockCols[block] * C + col, sBlock[col * C + row] });
+                    }
+                }
+
+                const SparseMatrix<Type> mat(reducedSize, reducedSize, triplets);
+
+                if (!this->sparse)
+                    this->sparse = std::make_unique<SparseCholesky<Type>>(mat, MinimumDegreeOrdering(mat));
+                else
+                    this->sparse->Factorize(mat);
+
+                if (!this->sparse->positiveDefinite)
+                    return false;
+
+                this->sparse->Solve(rhs, reducedSize, 1);
+                return true;
+            }
+        };
+    }
+
+    // Dense nonlinear least squares
+    //
+    // Minimizes ½‖r(x)‖² over blocks residual blocks of blockResiduals rows, starting from initial.
+    // evaluate(block, x, residuals, jacobian, ldj) must set the residuals of the block and, unless
+    // jacobian is nullptr, every element of its blockResiduals x n column-major Jacobian with
+    // leading dimension ldj. Blocks are evaluated in parallel, so evaluate must be thread-safe.
+
+    template <typename Type, typename Function>
+    LeastSquaresResult<Type> SolveLeastSquares(const std::vector<Type> &initial, size_t blocks, size_t blockResiduals, const Function &evaluate,
+        const LeastSquaresOptions &options = LeastSquaresOptions())
+    {
+        Detail::DenseLeastSquares<Type, Function> model(initial.size(), blocks, blockResiduals, evaluate);
+        return Detail::LevenbergMarquardt(model, initial, options);
+    }
+
+    // Same with Vector parameters and blocks of Residuals residuals, as
+    // evaluate(block, x, residual, jacobian) with jacobian a Matrix<Type, Residuals, Parameters> * that
+    // is nullptr when only the residual is needed
+
+    template <typename Type, size_t Parameters, size_t Residuals, typename Function>
+    LeastSquaresResult<Type> SolveLeastSquares(const Vector<Type, Parameters> &initial, size_t blocks, const Function &evaluate,
+        const LeastSquaresOptions &options = LeastSquaresOptions())
+    {
+        auto evaluateBlock = [&](size_t block, const Type *x, Type *residuals, Type *jacobian, size_t ldj)
+        {
+            Vector<Type, Parameters> newVec;
+            Vector<Type, Residuals> residual;
+            Matrix<Type, Residuals, Parameters> newMat;
+
+            std::copy(x, x + Parameters, newVec.data);
+            evaluate(block, newVec, residual, jacobian != nullptr ? &newMat : nullptr);
+            std::copy(residual.data, residual.data + Residuals, residuals);
+
+            if (jacobian == nullptr)
+                return;
+
+            for (size_t col = 0; col < Parameters; col++)
+                std::copy(newMat.data + col * Residuals, newMat.data + (col + 1) * Residuals, jacobian + col * ldj);
+        };
+
+        return SolveLeastSquares(std::vector<Type>(initial.data, initial.data + Parameters), blocks, Residuals, evaluateBlock, options);
+    }
+
+    // Bundle-adjustment-shaped nonlinear least squares
+    //
+    // Observation a = (camera, point) depends on one camera of CameraSize parameters and one point
+    // of PointSize parameters. evaluate(a, camera, point, residual, cameraJacobian, pointJacobian)
+    // must set the ResidualSize residuals and, unless the Jacobian pointers are nullptr, the
+    // ResidualSize x CameraSize and ResidualSize x PointSize column-major Jacobians. The points are
+    // eliminated by the Schur complement each iteration. The result holds the cameras, then the
+    // points.
+
+    template <typename Type, size_t ResidualSize, size_t CameraSize, size_t PointSize, typename Function>
+    LeastSquaresResult<Type> SolveBundleLeastSquares(const std::vector<Type> &cameras, const std::vector<Type> &points,
+        const std::vector<std::pair<size_t, size_t>> &observations, const Function &evaluate, const LeastSquaresOptions &options = LeastSquaresOptions())
+    {
+        if (cameras.size() % CameraSize != 0 || points.size() % PointSize != 0)
+            throw std::runtime_error("SolveBundleLeastSquares: parameter size mismatch.");
+
+        const size_t cameraCount = cameras.size() / CameraSize;
+        const size_t pointCount = points.size() / PointSize;
+
+        for (const std::pair<size_t, size_t> &observation : observations)
+        {
+            if (observation.first >= cameraCount || observation.second >= pointCount)
+                throw std::runtime_error("SolveBundleLeastSquares: observation index out of range.");
+        }
+
+        std::vector<Type> initial(cameras);
+        initial.insert(initial.end(), points.begin(), points.end());
+
+        Detail::SchurLeastSquares<Type, ResidualSize, CameraSize, PointSize, Function> model(cameraCount, pointCount, observations, evaluate);
+        return Detail::LevenbergMarquardt(model, std::move(initial), options);
+    }
+}
@@ -0,0 +1,458 @@
+#pragma once
+
+#include <Math/Decomposition.hpp>
+
+#include <random>
+
+namespace Scoop::Math
+{
+    // Low-rank factorization kernels
+    //
+    // Factors are column-major: u is rows x rank and v is cols x rank, for A = UVᵀ. Singular values
+    // are folded into u.
+
+    namespace Detail
+    {
+        // Rank kept from descending singular values: those above tolerance times the largest (or
+        // times scale, if that is larger), at most maxRank
+
+        template <typename Type>
+        size_t LowRankCut(const Type *s, size_t count, Type tolerance, Type scale, size_t maxRank)
+        {
+            const Type threshold = tolerance * std::max(count > 0 ? s[0] : Type(0), scale);
+            size_t rank = 0;
+
+            while (rank < std::min(count, maxRank) && s[rank] > Type(0) && s[rank] > threshold)
+                rank++;
+
+            return rank;
+        }
+
+        // Frobenius norm of UVᵀ, from trace((UᵀU)(VᵀV))
+
+        template <typename Type>
+        Type LowRankNorm(size_t rows, size_t cols, size_t rank, const Type *u, const Type *v)
+        {
+            std::vector<Type> gramU(rank * rank), gramV(rank * rank);
+
+            InnerProducts(rows, rank, rank, u, rows, u, rows, gramU.data(), rank);
+            InnerProducts(cols, rank, rank, v, cols, v, cols, gramV.data(), rank);
+
+            Type sum = 0;
+
+            for (size_t i = 0; i < rank * rank; i++)
+                sum += gramU[i] * gramV[i];
+
+            return std::sqrt(std::max(sum, Type(0)));
+        }
+
+        // Truncated SVD of a dense matrix, decomposing the transpose when it is wide
+
+        template <typename Type>
+        size_t LowRankFromDense(size_t rows, size_t cols, const Type *a, size_t lda, Type tolerance, Type scale, size_t maxRank, std::vector<Type> &u, std::vector<Type> &v)
+        {
+            const bool wide = rows < cols;
+            const size_t tall = wide ? cols : rows;
+            const size_t narrow = wide ? rows : cols;
+
+            std::vector<Type> left(tall * narrow), right(narrow * narrow), s(narrow);
+
+            for (size_t col = 0; col < cols; col++)
+            {
+                for (size_t row = 0; row < rows; row++)
+                {
+                    if (wide)
+                        left[row * tall + col] = a[col * lda + row];
+                    else
+                        left[col * tall + row] = a[col * lda + row];
+                }
+            }
+
+            if (!JacobiSVD(tall, narrow, left.data(), tall, s.data(), right.data(), narrow))
+                throw std::runtime_error("LowRankMatrix: singular value decomposition did not converge.");
+
+            const size_t rank = LowRankCut(s.data(), narrow, tolerance, scale, maxRank);
+            const std::vector<Type> &uSource = wide ? right : left;
+            const std::vector<Type> &vSource = wide ? left : right;
+
+            u.resize(rows * rank);
+            v.resize(cols * rank);
+
+            for (size_t k = 0; k < rank; k++)
+            {
+                for (size_t row = 0; row < rows; row++)
+                    u[k * rows + row] = uSource[k * rows + row] * s[k];
+
+                std::copy(vSource.begin() + k * cols, vSource.begin() + (k + 1) * cols, v.begin() + k * cols);
+            }
+
+            return rank;
+        }
+
+        // Recompresses UVᵀ: with U = QuRu and V = QvRv, the SVD of the small RuRvᵀ = XΣYᵀ gives
+        // UVᵀ = (QuXΣ)(QvY)ᵀ. Factors with more columns than rows are multiplied out instead.
+
+        template <typename Type>
+        size_t LowRankTruncate(size_t rows, size_t cols, size_t rank, std::vector<Type> &u, std::vector<Type> &v, Type tolerance, Type scale, size_t maxRank)
+        {
+            if (rank == 0)
+                return 0;
+
+            if (rank > rows || rank > cols)
+            {
+                std::vector<Type> vt(rank * cols), dense(rows * cols);
+
+                for (size_t k = 0; k < rank; k++)
+                {
+                    for (size_t col = 0; col < cols; col++)
+                        vt[col * rank + k] = v[k * cols + col];
+                }
+
+                Gemm<PlusTimes>(rows, cols, rank, u.data(), rows, vt.data(), rank, dense.data(), rows, false);
+                return LowRankFromDense(rows, cols, dense.data(), rows, tolerance, scale, maxRank, u, v);
+            }
+
+            std::vector<Type> tauU(rank), tauV(rank), ru(rank * rank, Type(0)), rv(rank * rank, Type(0)), core(rank * rank);
+
+            QRFactor(rows, rank, u.data(), rows, tauU.data());
+            QRFactor(cols, rank, v.data(), cols, tauV.data());
+
+            for (size_t col = 0; col < rank; col++)
+            {
+                for (size_t row = 0; row <= col; row++)
+                {
+                    ru[col * rank + row] = u[col * rows + row];
+                    rv[col * rank + row] = v[col * cols + row];
+                }
+            }
+
+            QRFormQ(rows, rank, u.data(), rows, tauU.data());
+            QRFormQ(cols, rank, v.data(), cols, tauV.data());
+
+            // core = Ru Rvᵀ
+
+            for (size_t col = 0; col < rank; col++)
+            {
+                for (size_t row = 0; row < rank; row++)
+                {
+                    Type sum = 0;
+
+                    for (size_t k = std::max(row, col); k < rank; k++)
+                        sum += ru[k * rank + row] * rv[k * rank + col];
+
+                    core[col * rank + row] = sum;
+                }
+            }
+
+            std::vector<Type> y(rank * rank), s(rank);
+
+            if (!JacobiSVD(rank, rank, core.data(), rank, s.data(), y.data(), rank))
+                throw std::runtime_error("LowRankMatrix: singular value decomposition did not converge.");
+
+            const size_t newRank = LowRankCut(s.data(), rank, tolerance, scale, maxRank);
+
+            for (size_t k = 0; k < newRank; k++)
+            {
+                for (size_t row = 0; row < rank; row++)
+                    core[k * rank + row] *= s[k];
+            }
+
+            std::vector<Type> newU(rows * newRank), newV(cols * newRank);
+
+            Gemm<PlusTimes>(rows, newRank, rank, u.data(), rows, core.data(), rank, newU.data(), rows, false);
+            Gemm<PlusTimes>(cols, newRank, rank, v.data(), cols, y.data(), rank, newV.data(), cols, false);
+
+            u.swap(newU);
+            v.swap(newV);
+            return newRank;
+        }
+
+        // Orthonormal basis of the columns of a (rows >= cols), in place
+
+        template <typename Type>
+        void LowRankOrthonormalize(size_t rows, size_t cols, Type *a)
+        {
+            std::vector<Type> tau(cols);
+            QRFactor(rows, cols, a, rows, tau.data());
+            QRFormQ(rows, cols, a, rows, tau.data());
+        }
+    }
+
+    // Low-rank matrix, A = UVᵀ
+    //
+    // Stores the rows x rank factor u and the cols x rank factor v, column-major, so products cost
+    // O((rows + cols) rank) instead of O(rows cols).
+
+    template <typename Type> class LowRankMatrix
+    {
+        public:
+
+        // Matrix dimensions and factors
+
+        size_t rows;
+        size_t cols;
+        size_t rank;
+        std::vector<Type> u;
+        std::vector<Type> v;
+
+        // Constructors
+
+        LowRankMatrix()
+            : rows(0), cols(0), rank(0)
+        { }
+
+        LowRankMatrix(size_t rows, size_t cols)
+            : rows(rows), cols(cols), rank(0)
+        { }
+
+        LowRankMatrix(size_t rows, size_t cols, size_t rank, const std::vector<Type> &u, const std::vector<Type> &v)
+            : rows(rows), cols(cols), rank(rank), u(u), v(v)
+        {
+            if (u.size() != rows * rank || v.size() != cols * rank)
+                throw std::runtime_error("LowRankMatrix: factor size mismatch.");
+        }
+
+        // Matrix-vector products, y = A x = U(Vᵀx) and y = Aᵀx = V(Uᵀx)
+
+        void Multiply(const Type *x, Type *y) const
+        { this->Multiply(x, this->cols, y, this->rows, 1); }
+
+        std::vector<Type> Multiply(const std::vector<Type> &x) const
+        {
+            if (x.size() != this->cols)
+                throw std::runtime_error("LowRankMatrix::Multiply: vector size mismatch.");
+
+            std::vector<Type> y(this->rows);
+            this->Multiply(x.data(), y.data());
+            return y;
+        }
+
+        void MultiplyTranspose(const Type *x, Type *y) const
+        {
+            std::vector<Type> projected(this->rank);
+
+            Detail::InnerProducts(this->rows, this->rank, 1, this->u.data(), this->rows, x, this->rows, projected.data(), this->rank);
+            Detail::Gemm<PlusTimes>(this->cols, 1, this->rank, this->v.data(), this->cols, projected.data(), this->rank, y, this->cols, false);
+        }
+
+        std::vector<Type> MultiplyTranspose(const std::vector<Type> &x) const
+        {
+            if (x.size() != this->rows)
+                throw std::runtime_error("LowRankMatrix::MultiplyTranspose: vector size mismatch.");
+
+            std::vector<Type> y(this->cols);
+            this->MultiplyTranspose(x.data(), y.data());
+            return y;
+        }
+
+        // Product with count column-major right-hand sides, Y = U(VᵀX)
+
+        void Multiply(const Type *x, size_t ldx, Type *y, size_t ldy, size_t count) const
+        {
+            if (this->rank == 0)
+            {
+                for (size_t rhs = 0; rhs < count; rhs++)
+                    std::fill(y + rhs * ldy, y + rhs * ldy + this->rows, Type(0));
+                return;
+            }
+
+            std::vector<Type> projected(this->rank * count);
+
+            Detail::InnerProducts(this->cols, this->rank, count, this->v.data(), this->cols, x, ldx, projected.data(), this->rank);
+            Detail::Gemm<PlusTimes>(this->rows, count, this->rank, this->u.data(), this->rows, projected.data(), this->rank, y, ldy, false);
+        }
+
+        // Products with dense matrices stay low rank: (UVᵀ)B = U(BᵀV)ᵀ and B(UVᵀ) = (BU)Vᵀ
+
+        template <size_t Inner, size_t Cols2>
+        LowRankMatrix<Type> Multiply(const Matrix<Type, Inner, Cols2> &mat) const
+        {
+            if (Inner != this->cols)
+                throw std::runtime_error("LowRankMatrix::Multiply: matrix size mismatch.");
+
+            LowRankMatrix<Type> newMat(this->rows, Cols2);
+            newMat.rank = this->rank;
+            newMat.u = this->u;
+            newMat.v.resize(Cols2 * this->rank);
+
+            Detail::InnerProducts(Inner, Cols2, this->rank, mat.data, Inner, this->v.data(), this->cols, newMat.v.data(), Cols2);
+            return newMat;
+        }
+
+        template <size_t Rows2, size_t Inner>
+        LowRankMatrix<Type> LeftMultiply(const Matrix<Type, Rows2, Inner> &mat) const
+        {
+            if (Inner != this->rows)
+                throw std::runtime_error("LowRankMatrix::LeftMultiply: matrix size mismatch.");
+
+            LowRankMatrix<Type> newMat(Rows2, this->cols);
+            newMat.rank = this->rank;
+            newMat.u.resize(Rows2 * this->rank);
+            newMat.v = this->v;
+
+            Detail::Gemm<PlusTimes>(Rows2, this->rank, Inner, mat.data, Rows2, this->u.data(), this->rows, newMat.u.data(), Rows2, false);
+            return newMat;
+        }
+
+        // Sums concatenate the factors and are recompressed to the singular values above
+        // tolerance times the larger norm of the terms, keeping at most maxRank. A negative
+        // tolerance, the default, uses machine epsilon times √(rows·cols), above the rounding
+        // left by the recompression, so cancellation leaves no rank behind.
+
+        LowRankMatrix<Type> Add(const LowRankMatrix<Type> &mat, Type tolerance = Type(-1), size_t maxRank = SIZE_MAX) const
+        {
+            LowRankMatrix<Type> newMat(*this);
+            newMat.AddInPlace(mat, tolerance, maxRank);
+            return newMat;
+        }
+
+        LowRankMatrix<Type> Subtract(const LowRankMatrix<Type> &mat, Type tolerance = Type(-1), size_t maxRank = SIZE_MAX) const
+        { return this->Add(mat.Scale(Type(-1)), tolerance, maxRank); }
+
+        void AddInPlace(const LowRankMatrix<Type> &mat, Type tolerance = Type(-1), size_t maxRank = SIZE_MAX)
+        {
+            if (mat.rows != this->rows || mat.cols != this->cols)
+                throw std::runtime_error("LowRankMatrix::AddInPlace: matrix size mismatch.");
+
+            const Type scale = std::max(this->Norm(), mat.Norm());
+
+            if (tolerance < Type(0))
+                tolerance = std::numeric_limits<Type>::epsilon() * std::sqrt(Type(this->rows) * Type(this->cols));
+
+            this->u.insert(this->u.end(), mat.u.begin(), mat.u.end());
+            this->v.insert(this->v.end(), mat.v.begin(), mat.v.end());
+            this->rank += mat.rank;
+            this->rank = Detail::LowRankTruncate(this->rows, this->cols, this->rank, this->u, this->v, tolerance, scale, maxRank);
+        }
+
+        LowRankMatrix<Type> Scale(Type scalar) const
+        {
+            LowRankMatrix<Type> newMat(*this);
+            newMat.ScaleInPlace(scalar);
+            return newMat;
+        }
+
+        void ScaleInPlace(Type scalar)
+        {
+            for (Type &value : this->u)
+                value *= scalar;
+        }
+
+        // Recompresses the factors to the smallest rank meeting the tolerance
+
+        void Truncate(Type tolerance, size_t maxRank = SIZE_MAX)
+        { this->rank = Detail::LowRankTruncate(this->rows, this->cols, this->rank, this->u, this->v, tolerance, Type(0), maxRank); }
+
+        // Frobenius norm
+
+        Type Norm() const
+        { return Detail::LowRankNorm(this->rows, this->cols, this->rank, this->u.data(), this->v.data()); }
+
+        // Dense conversion
+
+        void ToDense(Type *out, size_t ld) const
+        {
+            if (this->rank == 0)
+            {
+                for (size_t col = 0; col < this->cols; col++)
+                    std::fill(out + col * ld, out + col * ld + this->rows, Type(0));
+                return;
+            }
+
+            std::vector<Type> vt(this->rank * this->cols);
+
+            for (size_t k = 0; k < this->rank; k++)
+            {
+                for (size_t col = 0; col < this->cols; col++)
+                    vt[col * this->rank + k] = this->v[k * this->cols + col];
+            }
+
+            Detail::Gemm<PlusTimes>(this->rows, this->cols, this->rank, this->u.data(), this->rows, vt.data(), this->rank, out, ld, false);
+        }
+
+        template <size_t Rows, size_t Cols> Matrix<Type, Rows, Cols> ToMatrix() const
+        {
+            if (Rows != this->rows || Cols != this->cols)
+                throw std::runtime_error("LowRankMatrix::ToMatrix: matrix size mismatch.");
+
+            Matrix<Type, Rows, Cols> newMat;
+            this->ToDense(newMat.data, Rows);
+            return newMat;
+        }
+    };
+
+    // Low-rank approximation by truncated SVD, keeping the singular values above tolerance times
+    // the largest (at most maxRank). Exact, at the cost of a full SVD.
+
+    template <typename Type>
+    LowRankMatrix<Type> TruncatedLowRank(size_t rows, size_t cols, const Type *data, size_t ld, Type tolerance, size_t maxRank = SIZE_MAX)
+    {
+        LowRankMatrix<Type> newMat(rows, cols);
+        newMat.rank = Detail::LowRankFromDense(rows, cols, data, ld, tolerance, Type(0), maxRank, newMat.u, newMat.v);
+        return newMat;
+    }
+
+    template <typename Type, size_t Rows, size_t Cols>
+    LowRankMatrix<Type> TruncatedLowRank(const Matrix<Type, Rows, Cols> &mat, Type tolerance, size_t maxRank = SIZE_MAX)
+    { return TruncatedLowRank(Rows, Cols, mat.data, Rows, tolerance, maxRank); }
+
+    // Rank-k approximation by randomized SVD
+    //
+    // Samples the range of A with k + oversampling Gaussian vectors, sharpens it with power
+    // iterations (re-orthonormalized each time), and takes the SVD of the projection QᵀA. Every
+    // pass over A is one GEMM or InnerProducts call, so the cost is O(rows cols k).
+
+    template <typename Type>
+    LowRankMatrix<Type> RandomizedLowRank(size_t rows, size_t cols, const Type *data, size_t ld, size_t rank, size_t oversampling = 10, size_t powerIterations = 2)
+    {
+        const size_t samples = std::min(rank + oversampling, std::min(rows, cols));
+
+        if (samples == 0)
+            return LowRankMatrix<Type>(rows, cols);
+
+        std::mt19937_64 random(5489);
+        std::normal_distribution<double> normal;
+        std::vector<Type> omega(cols * samples), range(rows * samples), coRange(cols * samples);
+
+        for (Type &value : omega)
+            value = Type(normal(random));
+
+        Detail::Gemm<PlusTimes>(rows, samples, cols, data, ld, omega.data(), cols, range.data(), rows, false);
+        Detail::LowRankOrthonormalize(rows, samples, range.data());
+
+        for (size_t iteration = 0; iteration < powerIterations; iteration++)
+        {
+            Detail::InnerProducts(rows, cols, samples, data, ld, range.data(), rows, coRange.data(), cols);
+            Detail::LowRankOrthonormalize(cols, samples, coRange.data());
+            Detail::Gemm<PlusTimes>(rows, samples, cols, data, ld, coRange.data(), cols, range.data(), rows, false);
+            Detail::LowRankOrthonormalize(rows, samples, range.data());
+        }
+
+        // (QᵀA)ᵀ = AᵀQ = UbΣVbᵀ, so A ≈ (QVbΣ)Ubᵀ
+
+        std::vector<Type> vb(samples * samples), s(samples);
+
+        Detail::InnerProducts(rows, cols, samples, data, ld, range.data(), rows, coRange.data(), cols);
+
+        if (!Detail::JacobiSVD(cols, samples, coRange.data(), cols, s.data(), vb.data(), samples))
+            throw std::runtime_error("RandomizedLowRank: singular value decomposition did not converge.");
+
+        LowRankMatrix<Type> newMat(rows, cols);
+        newMat.rank = Detail::LowRankCut(s.data(), samples, Type(0), Type(0), rank);
+        newMat.u.resize(rows * newMat.rank);
+        newMat.v.assign(coRange.begin(), coRange.begin() + cols * newMat.rank);
+
+        for (size_t k = 0; k < newMat.rank; k++)
+        {
+            for (size_t row = 0; row < samples; row++)
+                vb[k * samples + row] *= s[k];
+        }
+
+        Detail::Gemm<PlusTimes>(rows, newMat.rank, samples, range.data(), rows, vb.data(), samples, newMat.u.data(), rows, false);
+        return newMat;
+    }
+
+    template <typename Type, size_t Rows, size_t Cols>
+    LowRankMatrix<Type> RandomizedLowRank(const Matrix<Type, Rows, Cols> &mat, size_t rank, size_t oversampling = 10, size_t powerIterations = 2)
+    { return RandomizedLowRank(Rows, Cols, mat.data, Rows, rank, oversampling, powerIterations); }
+}
@@ -1,4 +1,29 @@
 #pragma once
 
 #include <Math/Vector.hpp>
-#include <Math/Matrix.hpp>
\ No newline at end of file
+#include <Math/Matrix.hpp>
+#include <Math/Kronecker.hpp>
+#include <Math/BitMatrix.hpp>
+#include <Math/Modular.hpp>
+#include <Math/Decomposition.hpp>
+#include <Math/Tridiagonal.hpp>
+#include <Math/Multigrid.hpp>
+#include <Math/Stencil.hpp>
+#include <Math/BlockSparse.hpp>
+#include <Math/Sparse.hpp>
+#include <Math/SparseCholesky.hpp>
+#include <Math/Ordering.hpp>
+#include <Math/Eigensolver.hpp>
+#include <Math/Format.hpp>
+#include <Math/LowRank.hpp>
+#include <Math/Transform.hpp>
+#include <Math/Toeplitz.hpp>
+#include <Math/Permutation.hpp>
+#include <Math/MatrixFunction.hpp>
+#include <Math/Sylvester.hpp>
+#include <Math/Kalman.hpp>
+#include <Math/LeastSquares.hpp>
+#include <Math/Dual.hpp>
+#include <Math/Accurate.hpp>
+#include <Math/MixedPrecision.hpp>
+#include <Math/Packed.hpp>
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Math/Vector.hpp>
+#include <Math/Semiring.hpp>
 
 namespace Scoop::Math
 {
@@ -26,17 +27,14 @@ namespace Scoop::Math
 
         void Assign(Type diagonal)
         {
-            size_t i = 0;
-
-            for (size_t row = 0; row < Rows; row++)
+            for (size_t col = 0; col < Cols; col++)
             {
-                for (size_t col = 0; col < Cols; col++)
+                for (size_t row = 0; row < Rows; row++)
                 {
                     if (row == col)
-                        this->data[i] = diagonal;
+                        this->data[col * Rows + row] = diagonal;
                     else
-                        this->data[i] = 0;
-                    i++;
+                        this->data[col * Rows + row] = 0;
                 }
             }
         }
@@ -45,7 +43,9 @@ namespace Scoop::Math
         {
             if (values.size() != Rows * Cols)
                 throw std::runtime_error("Matrix::Assign: vector size mismatch.");
-            std::memcpy(this->data, data, sizeof(Type) * Rows * Cols);
+
+            for (size_t i = 0; i < Rows * Cols; i++)
+                this->data[i] = values[i];
         }
 
         // Indexing
@@ -78,19 +78,25 @@ namespace Scoop::Math
         {
             if (Cols != 1)
                 throw std::runtime_error("Matrix::AsVector: matrix must have 1 column to be interpreted as a vector.");
-            return Vector<Type, Rows>(this->data);
+
+            Vector<Type, Rows> newVec;
+
+            for (size_t row = 0; row < Rows; row++)
+                newVec.data[row] = this->data[row];
+
+            return newVec;
         }
 
         // Matrix properties
 
         Matrix<Type, Cols, Rows> Transpose() const
         {
-            Matrix<Type, Cols, Rows> newMat(Cols, Rows);
+            Matrix<Type, Cols, Rows> newMat;
 
-            for (size_t row = 0; row < Rows; row++)
+            for (size_t col = 0; col < Cols; col++)
             {
-                for (size_t col = 0; col < Cols; col++)
-                    newMat.At(col, row) = this->At(row, col);
+                for (size_t row = 0; row < Rows; row++)
+                    newMat.data[row * Cols + col] = this->data[col * Rows + row];
             }
 
             return newMat;
@@ -181,37 +187,28 @@ namespace Scoop::Math
         }
 
         template <size_t Cols2> Matrix<Type, Rows, Cols2> Multiply(const Matrix<Type, Cols, Cols2> &mat) const
+        { return this->template Multiply<PlusTimes>(mat); }
+
+        template <typename Semiring, size_t Cols2> Matrix<Type, Rows, Cols2> Multiply(const Matrix<Type, Cols, Cols2> &mat) const
         {
             Matrix<Type, Rows, Cols2> newMat;
-
-            for (size_t row = 0; row < Rows; row++)
-            {
-                for (size_t col = 0; col < Cols2; col++)
-                {
-                    Type dot = 0;
-
-                    for (size_t m = 0; m < Cols; m++)
-                        dot += this->At(row, m) * mat.At(m, col);
-
-                    newMat.At(row, col) = dot;
-                }
-            }
-            
+            Detail::Gemm<Semiring>(Rows, Cols2, Cols, this->data, Rows, mat.data, Cols, newMat.data, Rows, false);
             return newMat;
         }
 
-        Vector<Type, Rows> Multiply(const Vector<Type, Rows> &vec) const
+        Vector<Type, Rows> Multiply(const Vector<Type, Cols> &vec) const
         {
             Vector<Type, Rows> newVec;
 
             for (size_t row = 0; row < Rows; row++)
+                newVec.data[row] = 0;
+
+            for (size_t col = 0; col < Cols; col++)
             {
-                Type dot = 0;
-                
-                for (size_t col = 0; col < Cols; col++)
-                    dot += this->At(row, col) * vec.data[col];
+                const Type value = vec.data[col];
 
-                newVec.data[row] = dot;
+                for (size_t row = 0; row < Rows; row++)
+                    newVec.data[row] += this->data[col * Rows + row] * value;
             }
 
             return newVec;
@@ -238,23 +235,30 @@ namespace Scoop::Math
         }
 
         void MultiplyInPlace(const Matrix<Type, Rows, Cols> &mat)
+        { *this = this->template Multiply<PlusTimes>(mat); }
+
+        template <typename Semiring> void MultiplyInPlace(const Matrix<Type, Rows, Cols> &mat)
+        { *this = this->template Multiply<Semiring>(mat); }
+
+        // Semiring accumulation, this = this ⊕ (a ⊗ b)
+
+        template <typename Semiring, size_t Inner> void MultiplyAccumulate(const Matrix<Type, Rows, Inner> &a, const Matrix<Type, Inner, Cols> &b)
+        { Detail::Gemm<Semiring>(Rows, Cols, Inner, a.data, Rows, b.data, Inner, this->data, Rows, true); }
+
+        // Semiring closure, I ⊕ A ⊕ A² ⊕ ... (shortest paths for MinPlus, reachability for OrAnd)
+
+        template <typename Semiring, size_t R = Rows, size_t C = Cols, typename std::enable_if<R == C, int>::type = 0>
+        Matrix<Type, Rows, Cols> Closure() const
         {
-            Matrix<Type, Rows, Cols> newMat(Rows, Cols);
+            Matrix<Type, Rows, Cols> closure(*this);
 
-            for (size_t row = 0; row < Rows; row++)
-            {
-                for (size_t col = 0; col < Cols; col++)
-                {
-                    Type dot = 0;
+            for (size_t i = 0; i < Rows; i++)
+                closure.data[i * Rows + i] = Semiring::Add(closure.data[i * Rows + i], Semiring::template One<Type>());
 
-                    for (size_t m = 0; m < Cols; m++)
-                        dot += this->At(row, m) * mat.At(m, col);
+            for (size_t length = 1; length + 1 < Rows; length *= 2)
+                closure.template MultiplyInPlace<Semiring>(closure);
 
-                    newMat.At(row, col) = dot;
-                }
-            }
-            
-            *this = newMat;
+            return closure;
         }
 
         // Scalar arithmetic operators
@@ -274,7 +278,7 @@ namespace Scoop::Math
         inline Matrix<Type, Rows, Cols> operator+(const Matrix<Type, Rows, Cols> &mat) const { return Add(mat); }
         inline Matrix<Type, Rows, Cols> operator-(const Matrix<Type, Rows, Cols> &mat) const { return Subtract(mat); }
         template <size_t Cols2> inline Matrix<Type, Rows, Cols2> operator*(const Matrix<Type, Cols, Cols2> &mat) const { return Multiply(mat); }
-        inline Vector<Type, Rows> operator*(const Vector<Type, Rows> &vec) const { return Multiply(vec); }
+        inline Vector<Type, Rows> operator*(const Vector<Type, Cols> &vec) const { return Multiply(vec); }
 
         inline Matrix<Type, Rows, Cols> &operator+=(const Matrix<Type, Rows, Cols> &mat) { this->AddInPlace(mat); return *this; }
         inline Matrix<Type, Rows, Cols> &operator-=(const Matrix<Type, Rows, Cols> &mat) { this->SubtractInPlace(mat); return *this; }
@@ -312,6 +316,37 @@ namespace Scoop::Math
         }
     };
     
+    // General matrix product with scaling, C = αAB + βC, or (α ⊗ A ⊗ B) ⊕ (β ⊗ C) over Semiring.
+    // α and β are applied by the kernel as each tile of C is written, so no temporary product or
+    // separate pass over C is needed. When β is zero, C is not read. C must not overlap A or B.
+
+    template <typename Semiring = PlusTimes, typename Type>
+    void Gemm(size_t rows, size_t cols, size_t inner, Type alpha, const Type *a, size_t lda, const Type *b, size_t ldb,
+        Type beta, Type *c, size_t ldc)
+    { Detail::Gemm<Semiring>(rows, cols, inner, alpha, a, lda, b, ldb, beta, c, ldc); }
+
+    // The scalars take the element type of the matrices (std::common_type_t<Type> is not deduced)
+
+    template <typename Semiring = PlusTimes, typename Type, size_t Rows, size_t Inner, size_t Cols>
+    void Gemm(std::common_type_t<Type> alpha, const Matrix<Type, Rows, Inner> &a, const Matrix<Type, Inner, Cols> &b,
+        std::common_type_t<Type> beta, Matrix<Type, Rows, Cols> &c)
+    {
+        if (static_cast<const void *>(c.data) == a.data || static_cast<const void *>(c.data) == b.data)
+            throw std::runtime_error("Gemm: destination matrix is also an operand.");
+
+        Detail::Gemm<Semiring>(Rows, Cols, Inner, alpha, a.data, Rows, b.data, Inner, beta, c.data, Rows);
+    }
+
+    template <typename Semiring = PlusTimes, typename Type, size_t Rows, size_t Cols>
+    void Gemm(std::common_type_t<Type> alpha, const Matrix<Type, Rows, Cols> &a, const Vector<Type, Cols> &vec,
+        std::common_type_t<Type> beta, Vector<Type, Rows> &y)
+    {
+        if (static_cast<const void *>(y.data) == vec.data)
+            throw std::runtime_error("Gemm: destination vector is also an operand.");
+
+        Detail::Gemm<Semiring>(Rows, 1, Cols, alpha, a.data, Rows, vec.data, Cols, beta, y.data, Rows);
+    }
+
     // Typed matrix aliases
 
     #define __TYPED_MAT_ALIAS(type, name) template <size_t Rows, size_t Cols> using name = Matrix<type, Rows, Cols>
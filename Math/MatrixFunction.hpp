@@ -0,0 +1,592 @@
+#pragma once
+
+#include <Math/Decomposition.hpp>
+
+#include <limits>
+
+namespace Scoop::Math
+{
+    // Matrix function kernels
+    //
+    // All matrices are n x n and column-major with leading dimension n. The general paths only use
+    // the GEMM and LU kernels; symmetric positive definite matrices go through SymmetricEigen.
+
+    namespace Detail
+    {
+        template <typename Type>
+        void SetIdentity(size_t n, Type *a, Type diagonal = Type(1))
+        {
+            std::fill(a, a + n * n, Type(0));
+
+            for (size_t i = 0; i < n; i++)
+                a[i * n + i] = diagonal;
+        }
+
+        // Frobenius norm of A - I, an upper bound on the 2-norm used by the convergence tests
+
+        template <typename Type>
+        Type DistanceFromIdentity(size_t n, const Type *a)
+        {
+            Type sum = 0;
+
+            for (size_t col = 0; col < n; col++)
+            {
+                for (size_t row = 0; row < n; row++)
+                {
+                    const Type value = a[col * n + row] - (row == col ? Type(1) : Type(0));
+                    sum += value * value;
+                }
+            }
+
+            return std::sqrt(sum);
+        }
+
+        // True if A equals Aᵀ to a few ulps of its largest element
+
+        template <typename Type>
+        bool IsNearlySymmetric(size_t n, const Type *a)
+        {
+            Type scale = 0;
+
+            for (size_t i = 0; i < n * n; i++)
+                scale = std::max(scale, std::abs(a[i]));
+
+            const Type tolerance = 16 * std::numeric_limits<Type>::epsilon() * scale;
+
+            for (size_t col = 0; col < n; col++)
+            {
+                for (size_t row = col + 1; row < n; row++)
+                {
+                    if (std::abs(a[col * n + row] - a[row * n + col]) > tolerance)
+                        return false;
+                }
+            }
+
+            return true;
+        }
+
+        // f(A) = V f(Λ) Vᵀ for a symmetric matrix. Returns false, leaving out unchanged, unless
+        // every eigenvalue is positive.
+
+        template <typename Type, typename Function>
+        bool SymmetricFunction(size_t n, const Type *a, Type *out, const Function &function)
+        {
+            std::vector<Type> vectors(n * n), values(n), scaled(n * n);
+
+            for (size_t col = 0; col < n; col++)
+            {
+                for (size_t row = 0; row < n; row++)
+                    vectors[col * n + row] = (a[col * n + row] + a[row * n + col]) / 2;
+            }
+
+            if (!SymmetricEigen(n, vectors.data(), n, values.data()) || !(values[0] > Type(0)))
+                return false;
+
+            for (size_t col = 0; col < n; col++)
+            {
+                const Type value = function(values[col]);
+
+                for (size_t row = 0; row < n; row++)
+                    scaled[col * n + row] = vectors[col * n + row] * value;
+            }
+
+            // V f(Λ) Vᵀ, with the transpose applied by indexing
+
+            for (size_t col = 0; col < n; col++)
+            {
+                for (size_t row = 0; row < n; row++)
+                {
+                    Type sum = 0;
+
+                    for (size_t k = 0; k < n; k++)
+                        sum += scaled[k * n + row] * vectors[k * n + col];
+
+                    out[col * n + row] = sum;
+                }
+            }
+
+            return true;
+        }
+
+        // Inverse by LU, returning false if A is singular. lu and pivots are scratch; the log of
+        // |det A| is returned in logDeterminant.
+
+        template <typename Type>
+        bool InvertLU(size_t n, const Type *a, Type *inverse, Type *lu, size_t *pivots, Type &logDeterminant)
+        {
+            std::copy(a, a + n * n, lu);
+
+            if (!LUFactor(n, lu, n, pivots))
+                return false;
+
+            logDeterminant = 0;
+
+            for (size_t i = 0; i < n; i++)
+                logDeterminant += std::log(std::abs(lu[i * n + i]));
+
+            SetIdentity(n, inverse);
+            LUSolve(n, lu, n, pivots, inverse, n, n);
+            return true;
+        }
+
+        // Principal square root by the scaled product form of the Denman-Beavers iteration,
+        //   Yₖ₊₁ = μₖ/2 Yₖ (I + μₖ⁻² Mₖ⁻¹),  Mₖ₊₁ = (I + (μₖ² Mₖ + μₖ⁻² Mₖ⁻¹)/2)/2,
+        // starting from Y₀ = M₀ = A, so Yₖ → A^½ and Mₖ → I. The determinant scaling
+        // μₖ = |det Mₖ|^(-1/2n) shortens the slow initial phase and is dropped near convergence.
+        // Each step is one LU inverse and one GEMM. Returns false if A is singular or the
+        // iteration does not converge, as for eigenvalues on the closed negative real axis.
+
+        template <typename Type>
+        bool SqrtDenmanBeavers(size_t n, const Type *a, Type *y)
+        {
+            std::vector<Type> m(a, a + n * n), inverse(n * n), lu(n * n), factor(n * n), newY(n * n);
+            std::vector<size_t> pivots(n);
+            const Type tolerance = 16 * Type(n) * std::numeric_limits<Type>::epsilon();
+            bool scaling = true;
+
+            std::copy(a, a + n * n, y);
+
+            for (size_t iteration = 0; iteration < 100; iteration++)
+            {
+                Type logDeterminant;
+
+                if (!InvertLU(n, m.data(), inverse.data(), lu.data(), pivots.data(), logDeterminant))
+                    return false;
+
+                const Type mu = scaling ? std::exp(-logDeterminant / Type(2 * n)) : Type(1);
+                const Type muSquared = mu * mu;
+
+                for (size_t i = 0; i < n * n; i++)
+                    factor[i] = inverse[i] / muSquared;
+                for (size_t i = 0; i < n; i++)
+                    factor[i * n + i] += 1;
+
+                Gemm<PlusTimes>(n, n, n, y, n, factor.data(), n, newY.data(), n, false);
+
+                for (size_t i = 0; i < n * n; i++)
+                {
+                    y[i] = newY[i] * (mu / 2);
+                    m[i] = (muSquared * m[i] + inverse[i] / muSquared) / 4;
+                }
+
+                for (size_t i = 0; i < n; i++)
+                    m[i * n + i] += Type(0.5);
+
+                const Type distance = DistanceFromIdentity(n, m.data());
+
+                if (!std::isfinite(distance))
+                    return false;
+                if (distance <= tolerance)
+                    return true;
+                if (distance < Type(0.01))
+                    scaling = false;
+            }
+
+            return false;
+        }
+
+        // Principal logarithm by inverse scaling and squaring. Square roots are taken until
+        // ‖A^(1/2ˢ) - I‖ ≤ 1/4, where the [8/8] Padé approximant of log(I + X), evaluated in its
+        // partial fraction form Σ wⱼ X (I + tⱼX)⁻¹ at the Gauss-Legendre nodes on [0, 1], is
+        // accurate to double precision. Returns false if a square root fails.
+
+        template <typename Type>
+        bool LogInverseScalingSquaring(size_t n, const Type *a, Type *out)
+        {
+            static const double nodes[8] = { 0.0198550717512319, 0.1016667612931866, 0.2372337950418355, 0.4082826787521751,
+                0.5917173212478249, 0.7627662049581645, 0.8983332387068134, 0.9801449282487681 };
+            static const double weights[8] = { 0.0506142681451881, 0.1111905172266872, 0.1568533229389436, 0.1813418916891810,
+                0.1813418916891810, 0.1568533229389436, 0.1111905172266872, 0.0506142681451881 };
+
+            std::vector<Type> x(a, a + n * n), root(n * n), lu(n * n), term(n * n);
+            std::vector<size_t> pivots(n);
+            size_t squarings = 0;
+
+            while (DistanceFromIdentity(n, x.data()) > Type(0.25))
+            {
+                if (squarings == 64 || !SqrtDenmanBeavers(n, x.data(), root.data()))
+                    return false;
+
+                std::swap(x, root);
+                squarings++;
+            }
+
+            for (size_t i = 0; i < n; i++)
+                x[i * n + i] -= 1;
+
+            std::fill(out, out + n * n, Type(0));
+
+            for (size_t j = 0; j < 8; j++)
+            {
+                for (size_t i = 0; i < n * n; i++)
+                    lu[i] = Type(nodes[j]) * x[i];
+                for (size_t i = 0; i < n; i++)
+                    lu[i * n + i] += 1;
+
+                if (!LUFactor(n, lu.data(), n, pivots.data()))
+                    return false;
+
+                // X and (I + tX)⁻¹ commute, so the term is a solve with X as right-hand side
+
+                std::copy(x.begin(), x.end(), term.begin());
+                LUSolve(n, lu.data(), n, pivots.data(), term.data(), n, n);
+
+                for (size_t i = 0; i < n * n; i++)
+                    out[i] += Type(weights[j]) * term[i];
+            }
+
+            const Type scale = std::ldexp(Type(1), int(squarings));
+
+            for (size_t i = 0; i < n * n; i++)
+                out[i] *= scale;
+
+            return true;
+        }
+
+        // Exponential by scaling and squaring with the [6/6] Padé approximant, scaling until
+        // ‖A/2ˢ‖ ≤ 1/2 where the approximant is accurate to double precision
+
+        template <typename Type>
+        bool ExpScalingSquaring(size_t n, const Type *a, Type *out)
+        {
+            static const double c[7] = { 1.0, 0.5, 5.0 / 44.0, 1.0 / 66.0, 1.0 / 792.0, 1.0 / 15840.0, 1.0 / 665280.0 };
+
+            Type norm = 0;
+
+            for (size_t i = 0; i < n * n; i++)
+                norm += a[i] * a[i];
+
+            norm = std::sqrt(norm);
+
+            if (!std::isfinite(norm))
+                return false;
+
+            int squarings = 0;
+
+            if (norm > Type(0.5))
+                squarings = std::max(0, int(std::ceil(std::log2(norm / Type(0.5)))));
+
+            const Type scale = std::ldexp(Type(1), -squarings);
+            std::vector<Type> x(n * n), x2(n * n), x4(n * n), x6(n * n), odd(n * n), u(n * n), v(n * n), lu(n * n);
+            std::vector<size_t> pivots(n);
+
+            for (size_t i = 0; i < n * n; i++)
+                x[i] = a[i] * scale;
+
+            Gemm<PlusTimes>(n, n, n, x.data(), n, x.data(), n, x2.data(), n, false);
+            Gemm<PlusTimes>(n, n, n, x2.data(), n, x2.data(), n, x4.data(), n, false);
+            Gemm<PlusTimes>(n, n, n, x2.data(), n, x4.data(), n, x6.data(), n, false);
+
+            // U = X (c₁ + c₃X² + c₅X⁴), V = c₀ + c₂X² + c₄X⁴ + c₆X⁶, and e^X ≈ (V - U)⁻¹(V + U)
+
+            for (size_t i = 0; i < n * n; i++)
+            {
+                odd[i] = Type(c[3]) * x2[i] + Type(c[5]) * x4[i];
+                v[i] = Type(c[2]) * x2[i] + Type(c[4]) * x4[i] + Type(c[6]) * x6[i];
+            }
+
+            for (size_t i = 0; i < n; i++)
+            {
+                odd[i * n + i] += Type(c[1]);
+                v[i * n + i] += Type(c[0]);
+            }
+
+            Gemm<PlusTimes>(n, n, n, x.data(), n, odd.data(), n, u.data(), n, false);
+
+            for (size_t i = 0; i < n * n; i++)
+            {
+                lu[i] = v[i] - u[i];
+                out[i] = v[i] + u[i];
+            }
+
+            if (!LUFactor(n, lu.data(), n, pivots.data()))
+                return false;
+
+            LUSolve(n, lu.data(), n, pivots.data(), out, n, n);
+
+            for (int i = 0; i < squarings; i++)
+            {
+                Gemm<PlusTimes>(n, n, n, out, n, out, n, x.data(), n, false);
+                std::copy(x.begin(), x.end(), out);
+            }
+
+            return true;
+        }
+
+        // Aᵏ by binary powering, with A⁻¹ for negative k. Returns false if A is singular.
+
+        template <typename Type>
+        bool IntegerPower(size_t n, const Type *a, long long exponent, Type *out)
+        {
+            std::vector<Type> base(a, a + n * n), product(n * n), lu(n * n);
+            std::vector<size_t> pivots(n);
+
+            if (exponent < 0)
+            {
+                Type logDeterminant;
+
+                if (!InvertLU(n, a, base.data(), lu.data(), pivots.data(), logDeterminant))
+                    return false;
+
+                exponent = -exponent;
+            }
+
+            SetIdentity(n, out);
+
+            while (exponent > 0)
+            {
+                if (exponent & 1)
+                {
+                    Gemm<PlusTimes>(n, n, n, out, n, base.data(), n, product.data(), n, false);
+                    std::copy(product.begin(), product.end(), out);
+                }
+
+                exponent >>= 1;
+
+                if (exponent > 0)
+                {
+                    Gemm<PlusTimes>(n, n, n, base.data(), n, base.data(), n, product.data(), n, false);
+                    std::swap(base, product);
+                }
+            }
+
+            return true;
+        }
+    }
+
+    // 3 x 3 rotations
+    //
+    // Closed forms by the Rodrigues formula, R = I + sin θ K + (1 - cos θ) K² for the unit skew
+    // matrix K of the rotation axis
+
+    // True if R is orthogonal with determinant +1, to a tolerance relative to the precision
+
+    template <typename Type>
+    bool IsRotation(const Matrix<Type, 3, 3> &rot)
+    {
+        const Type tolerance = 64 * std::numeric_limits<Type>::epsilon();
+        Type error = 0;
+
+        for (size_t i = 0; i < 3; i++)
+        {
+            for (size_t j = 0; j < 3; j++)
+            {
+                Type dot = 0;
+
+                for (size_t k = 0; k < 3; k++)
+                    dot += rot.data[i * 3 + k] * rot.data[j * 3 + k];
+
+                error = std::max(error, std::abs(dot - (i == j ? Type(1) : Type(0))));
+            }
+        }
+
+        const Type *r = rot.data;
+        const Type determinant = r[0] * (r[4] * r[8] - r[7] * r[5]) - r[3] * (r[1] * r[8] - r[7] * r[2]) + r[6] * (r[1] * r[5] - r[4] * r[2]);
+
+        return error <= tolerance && determinant > 0;
+    }
+
+    // Skew-symmetric generator θK of a rotation, with |θ| ≤ π
+
+    template <typename Type>
+    Matrix<Type, 3, 3> RotationLog(const Matrix<Type, 3, 3> &rot)
+    {
+        const Type *r = rot.data;
+
+        // Axis times sin θ from the skew part, (R - Rᵀ)/2 = sin θ K, and θ from atan2, which
+        // stays accurate near 0 and π where acos of the trace does not
+
+        Type axis[3] = { (r[5] - r[7]) / 2, (r[6] - r[2]) / 2, (r[1] - r[3]) / 2 };
+        const Type sine = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        const Type cosine = (r[0] + r[4] + r[8] - 1) / 2;
+        const Type angle = std::atan2(sine, cosine);
+
+        if (cosine > Type(-0.5))
+        {
+            // θ / sin θ, by its series near 0
+
+            const Type factor = sine < Type(1e-4) ? 1 + angle * angle / 6 : angle / sine;
+
+            for (Type &value : axis)
+                value *= factor;
+        }
+        else
+        {
+            // Near π the skew part vanishes, so the axis is read from the symmetric part,
+            // (R + Rᵀ)/2 = cos θ I + (1 - cos θ) aaᵀ, using its largest diagonal for accuracy
+
+            size_t k = 0;
+
+            for (size_t i = 1; i < 3; i++)
+            {
+                if (r[i * 4] > r[k * 4])
+                    k = i;
+            }
+
+            Type unit[3];
+            const Type denominator = 1 - cosine;
+            unit[k] = std::sqrt(std::max(Type(0), (r[k * 4] - cosine) / denominator));
+
+            for (size_t i = 0; i < 3; i++)
+            {
+                if (i != k)
+                    unit[i] = (r[k * 3 + i] + r[i * 3 + k]) / (2 * denominator * unit[k]);
+            }
+
+            // The sign of the axis follows the skew part, which is still reliable away from π
+
+            const Type sign = unit[0] * axis[0] + unit[1] * axis[1] + unit[2] * axis[2] < 0 ? Type(-1) : Type(1);
+
+            for (size_t i = 0; i < 3; i++)
+                axis[i] = sign * angle * unit[i];
+        }
+
+        Matrix<Type, 3, 3> newMat;
+        const Type elements[9] =
+        {
+            0, axis[2], -axis[1],
+            -axis[2], 0, axis[0],
+            axis[1], -axis[0], 0,
+        };
+
+        std::copy(elements, elements + 9, newMat.data);
+        return newMat;
+    }
+
+    // Rotation generated by a skew-symmetric matrix, the inverse of RotationLog
+
+    template <typename Type>
+    Matrix<Type, 3, 3> RotationExp(const Matrix<Type, 3, 3> &skew)
+    {
+        const Type x = skew.data[5];
+        const Type y = skew.data[6];
+        const Type z = skew.data[1];
+        const Type angle2 = x * x + y * y + z * z;
+        const Type angle = std::sqrt(angle2);
+
+        // sin θ / θ and (1 - cos θ) / θ², by their series near 0
+
+        Type a, b;
+
+        if (angle < Type(1e-4))
+        {
+            a = 1 - angle2 / 6;
+            b = Type(0.5) - angle2 / 24;
+        }
+        else
+        {
+            a = std::sin(angle) / angle;
+            b = (1 - std::cos(angle)) / angle2;
+        }
+
+        Matrix<Type, 3, 3> newMat;
+        const Type elements[9] =
+        {
+            1 - b * (y * y + z * z), a * z + b * x * y, -a * y + b * x * z,
+            -a * z + b * x * y, 1 - b * (x * x + z * z), a * x + b * y * z,
+            a * y + b * x * z, -a * x + b * y * z, 1 - b * (x * x + y * y),
+        };
+
+        std::copy(elements, elements + 9, newMat.data);
+        return newMat;
+    }
+
+    // Matrix functions
+    //
+    // Principal square root, logarithm and real powers of a square matrix. Symmetric positive
+    // definite matrices are mapped through their eigendecomposition and 3 x 3 rotations use the
+    // Rodrigues closed form; other matrices use the iterative kernels above. A matrix without a
+    // real principal root or logarithm (an eigenvalue on the closed negative real axis) throws.
+
+    template <typename Type, size_t Size>
+    Matrix<Type, Size, Size> MatrixSqrt(const Matrix<Type, Size, Size> &mat)
+    {
+        Matrix<Type, Size, Size> newMat;
+
+        if constexpr (Size == 3)
+        {
+            if (IsRotation(mat))
+                return RotationExp(RotationLog(mat).Scale(Type(0.5)));
+        }
+
+        if (Detail::IsNearlySymmetric(Size, mat.data) && Detail::SymmetricFunction(Size, mat.data, newMat.data, [](Type value) { return std::sqrt(value); }))
+            return newMat;
+
+        if (!Detail::SqrtDenmanBeavers(Size, mat.data, newMat.data))
+            throw std::runtime_error("MatrixSqrt: matrix has no real principal square root.");
+
+        return newMat;
+    }
+
+    template <typename Type, size_t Size>
+    Matrix<Type, Size, Size> MatrixLog(const Matrix<Type, Size, Size> &mat)
+    {
+        Matrix<Type, Size, Size> newMat;
+
+        if constexpr (Size == 3)
+        {
+            if (IsRotation(mat))
+                return RotationLog(mat);
+        }
+
+        if (Detail::IsNearlySymmetric(Size, mat.data) && Detail::SymmetricFunction(Size, mat.data, newMat.data, [](Type value) { return std::log(value); }))
+            return newMat;
+
+        if (!Detail::LogInverseScalingSquaring(Size, mat.data, newMat.data))
+            throw std::runtime_error("MatrixLog: matrix has no real principal logarithm.");
+
+        return newMat;
+    }
+
+    template <typename Type, size_t Size>
+    Matrix<Type, Size, Size> MatrixExp(const Matrix<Type, Size, Size> &mat)
+    {
+        Matrix<Type, Size, Size> newMat;
+
+        if (!Detail::ExpScalingSquaring(Size, mat.data, newMat.data))
+            throw std::runtime_error("MatrixExp: matrix is not finite.");
+
+        return newMat;
+    }
+
+    // A^t. Integer exponents use binary powering (and the inverse when negative); other exponents
+    // are exp(t log A), or t log Λ through the eigendecomposition or the rotation closed form.
+
+    template <typename Type, size_t Size>
+    Matrix<Type, Size, Size> MatrixPower(const Matrix<Type, Size, Size> &mat, Type exponent)
+    {
+        Matrix<Type, Size, Size> newMat;
+
+        if (std::floor(exponent) == exponent && std::abs(exponent) < Type(1e9))
+        {
+            if (!Detail::IntegerPower(Size, mat.data, (long long)exponent, newMat.data))
+                throw std::runtime_error("MatrixPower: matrix is singular.");
+
+            return newMat;
+        }
+
+        if constexpr (Size == 3)
+        {
+            if (IsRotation(mat))
+                return RotationExp(RotationLog(mat).Scale(exponent));
+        }
+
+        if (Detail::IsNearlySymmetric(Size, mat.data) && Detail::SymmetricFunction(Size, mat.data, newMat.data, [&](Type value) { return std::pow(value, exponent); }))
+            return newMat;
+
+        if (exponent == Type(0.5))
+        {
+            if (!Detail::SqrtDenmanBeavers(Size, mat.data, newMat.data))
+                throw std::runtime_error("MatrixPower: matrix has no real principal power.");
+
+            return newMat;
+        }
+
+        Matrix<Type, Size, Size> log;
+
+        if (!Detail::LogInverseScalingSquaring(Size, mat.data, log.data))
+            throw std::runtime_error("MatrixPower: matrix has no real principal power.");
+
+        return MatrixExp(log.Scale(exponent));
+    }
+}
@@ -0,0 +1,286 @@
+#pragma once
+
+#include <Math/Decomposition.hpp>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace Scoop::Math
+{
+    // Mixed-precision linear solver
+    //
+    // Factors the matrix in a lower precision (float by default), where the LU and Cholesky
+    // kernels move half the data, and recovers full accuracy by iterative refinement: each step
+    // computes the residual r = b - Ax in full precision and corrects x by the low-precision
+    // solution of Ad = r. A column has converged when its residual is within the backward error of
+    // a full-precision solve, ‖r‖∞ ≤ ‖x‖∞ ‖A‖∞ ε √n. Right-hand sides and residuals are scaled to a
+    // largest magnitude of one before they are rounded, so they never overflow or underflow there.
+    //
+    // When the matrix does not fit the normal range of the lower precision, the low-precision
+    // factorization fails, or refinement stops improving (for matrices too ill-conditioned for the
+    // lower precision, or whose solutions overflow it), the matrix is factored in full precision
+    // instead, once, and used for all later solves.
+
+    enum class MixedPrecisionMethod
+    {
+        LU,
+        Cholesky
+    };
+
+    template <typename Type, typename LowType = float> class MixedPrecisionSolver
+    {
+        public:
+
+        size_t size;
+        MixedPrecisionMethod method;
+        size_t maxIterations;
+
+        // False once the solver has fallen back to a full-precision factorization
+
+        bool lowPrecision;
+
+        // Refinement steps of the last solve
+
+        size_t iterations;
+
+        // Constructors
+
+        MixedPrecisionSolver(size_t size, const Type *a, size_t lda, MixedPrecisionMethod method = MixedPrecisionMethod::LU, size_t maxIterations = 30)
+            : size(size), method(method), maxIterations(maxIterations), lowPrecision(true), iterations(0), matrix(size * size), norm(0)
+        {
+            const Type lowMax = Type(std::numeric_limits<LowType>::max());
+            const Type lowMin = Type(std::numeric_limits<LowType>::min());
+            bool fits = true;
+
+            for (size_t col = 0; col < size; col++)
+                std::copy(a + col * lda, a + col * lda + size, this->matrix.begin() + col * size);
+
+            // ‖A‖∞, the largest row sum
+
+            std::vector<Type> rowSums(size, Type(0));
+
+            for (size_t col = 0; col < size; col++)
+            {
+                for (size_t row = 0; row < size; row++)
+                {
+                    const Type magnitude = std::abs(this->matrix[col * size + row]);
+                    rowSums[row] += magnitude;
+                    fits = fits && magnitude <= lowMax && (magnitude >= lowMin || magnitude == Type(0));
+                }
+            }
+
+            for (size_t row = 0; row < size; row++)
+                this->norm = std::max(this->norm, rowSums[row]);
+
+            if (fits)
+            {
+                this->lowFactor.assign(this->matrix.begin(), this->matrix.end());
+                this->pivots.resize(size);
+
+                if (method == MixedPrecisionMethod::LU)
+                    fits = Detail::LUFactor(size, this->lowFactor.data(), size, this->pivots.data());
+                else
+                    fits = Detail::CholeskyFactor(size, this->lowFactor.data(), size);
+            }
+
+            if (!fits)
+                this->FallBack();
+        }
+
+        template <size_t Size>
+        explicit MixedPrecisionSolver(const Matrix<Type, Size, Size> &mat, MixedPrecisionMethod method = MixedPrecisionMethod::LU, size_t maxIterations = 30)
+            : MixedPrecisionSolver(Size, mat.data, Size, method, maxIterations)
+        { }
+
+        // Solving, in place for count column-major right-hand sides with leading dimension ldb
+
+        void Solve(Type *b, size_t ldb, size_t count)
+        {
+            const size_t n = this->size;
+
+            this->iterations = 0;
+
+            if (!this->lowPrecision)
+            {
+                this->HighSolve(b, ldb, count);
+                return;
+            }
+
+            std::vector<Type> x(n * count), residuals(n * count);
+            std::vector<LowType> work(n * count);
+            std::vector<Type> previous(count, std::numeric_limits<Type>::infinity());
+            std::vector<bool> converged(count, false);
+            std::vector<Type> scales(count);
+            const Type tolerance = this->norm * std::numeric_limits<Type>::epsilon() * std::sqrt(Type(n));
+
+            // Initial low-precision solution
+
+            for (size_t col = 0; col < count; col++)
+                scales[col] = this->Round(b + col * ldb, work.data() + col * n);
+
+            this->LowSolve(work.data(), count);
+
+            for (size_t i = 0; i < n * count; i++)
+                x[i] = Type(work[i]) * scales[i / n];
+
+            for (;;)
+            {
+                // R = B - AX in full precision, subtracted as the product is written
+
+                for (size_t col = 0; col < count; col++)
+                    std::copy(b + col * ldb, b + col * ldb + n, residuals.begin() + col * n);
+
+                Detail::Gemm<PlusTimes>(n, count, n, Type(-1), this->matrix.data(), n, x.data(), n, Type(1), residuals.data(), n);
+
+                bool done = true;
+                bool stalled = false;
+
+                for (size_t col = 0; col < count; col++)
+                {
+                    const Type *r = residuals.data() + col * n;
+                    const Type *xCol = x.data() + col * n;
+                    Type residualNorm = 0;
+                    Type solutionNorm = 0;
+                    bool finite = true;
+
+                    for (size_t row = 0; row < n; row++)
+                    {
+                        residualNorm = std::max(residualNorm, std::abs(r[row]));
+                        solutionNorm = std::max(solutionNorm, std::abs(xCol[row]));
+                        finite = finite && std::isfinite(r[row]) && std::isfinite(xCol[row]);
+                    }
+
+                    converged[col] = finite && residualNorm <= solutionNorm * tolerance;
+                    done = done && converged[col];
+
+                    // Refinement that no longer halves the residual will not reach full accuracy,
+                    // and one that overflowed will not recover
+
+                    if (!converged[col] && (!finite || !(residualNorm <= previous[col] / 2)))
+                        stalled = true;
+
+                    previous[col] = residualNorm;
+                }
+
+                if (done)
+                    break;
+
+                if (stalled || this->iterations == this->maxIterations)
+                {
+                    this->FallBack();
+                    this->HighSolve(b, ldb, count);
+                    return;
+                }
+
+                // X += A⁻¹R for the columns that have not converged
+
+                for (size_t col = 0; col < count; col++)
+                    scales[col] = this->Round(residuals.data() + col * n, work.data() + col * n);
+
+                this->LowSolve(work.data(), count);
+                this->iterations++;
+
+                for (size_t col = 0; col < count; col++)
+                {
+                    if (converged[col])
+                        continue;
+
+                    for (size_t row = 0; row < n; row++)
+                        x[col * n + row] += Type(work[col * n + row]) * scales[col];
+                }
+            }
+
+            for (size_t col = 0; col < count; col++)
+                std::copy(x.begin() + col * n, x.begin() + (col + 1) * n, b + col * ldb);
+        }
+
+        std::vector<Type> Solve(const std::vector<Type> &b)
+        {
+            if (b.size() != this->size)
+                throw std::runtime_error("MixedPrecisionSolver::Solve: vector size mismatch.");
+
+            std::vector<Type> x(b);
+            this->Solve(x.data(), this->size, 1);
+            return x;
+        }
+
+        template <size_t Size> Vector<Type, Size> Solve(const Vector<Type, Size> &vec)
+        {
+            if (Size != this->size)
+                throw std::runtime_error("MixedPrecisionSolver::Solve: vector size mismatch.");
+
+            Vector<Type, Size> newVec(vec);
+            this->Solve(newVec.data, Size, 1);
+            return newVec;
+        }
+
+        private:
+
+        std::vector<Type> matrix;
+        Type norm;
+        std::vector<LowType> lowFactor;
+        std::vector<Type> highFactor;
+        std::vector<size_t> pivots;
+        bool singular = false;
+
+        // Rounds a column to LowType after dividing it by its largest magnitude, which is returned
+        // (or one for a zero column)
+
+        Type Round(const Type *source, LowType *target) const
+        {
+            Type scale = 0;
+
+            for (size_t row = 0; row < this->size; row++)
+                scale = std::max(scale, std::abs(source[row]));
+
+            if (scale == Type(0))
+                scale = Type(1);
+
+            for (size_t row = 0; row < this->size; row++)
+                target[row] = LowType(source[row] / scale);
+
+            return scale;
+        }
+
+        void LowSolve(LowType *b, size_t count) const
+        {
+            if (this->method == MixedPrecisionMethod::LU)
+                Detail::LUSolve(this->size, this->lowFactor.data(), this->size, this->pivots.data(), b, this->size, count);
+            else
+                Detail::CholeskySolve(this->size, this->lowFactor.data(), this->size, b, this->size, count);
+        }
+
+        void HighSolve(Type *b, size_t ldb, size_t count) const
+        {
+            if (this->singular)
+            {
+                if (this->method == MixedPrecisionMethod::LU)
+                    throw std::runtime_error("MixedPrecisionSolver::Solve: matrix is singular.");
+                else
+                    throw std::runtime_error("MixedPrecisionSolver::Solve: matrix is not positive definite.");
+            }
+
+            if (this->method == MixedPrecisionMethod::LU)
+                Detail::LUSolve(this->size, this->highFactor.data(), this->size, this->pivots.data(), b, ldb, count);
+            else
+                Detail::CholeskySolve(this->size, this->highFactor.data(), this->size, b, ldb, count);
+        }
+
+        // Replaces the low-precision factors by full-precision ones
+
+        void FallBack()
+        {
+            this->lowPrecision = false;
+            this->lowFactor.clear();
+            this->lowFactor.shrink_to_fit();
+            this->highFactor = this->matrix;
+            this->pivots.resize(this->size);
+
+            if (this->method == MixedPrecisionMethod::LU)
+                this->singular = !Detail::LUFactor(this->size, this->highFactor.data(), this->size, this->pivots.data());
+            else
+                this->singular = !Detail::CholeskyFactor(this->size, this->highFactor.data(), this->size);
+        }
+    };
+}
@@ -0,0 +1,331 @@
+#pragma once
+
+#include <Math/Matrix.hpp>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+#endif
+
+namespace Scoop::Math
+{
+    // Modular GEMM kernels
+    //
+    // Operands are reduced once up front. For moduli below 2^32 the reduced values fit in 32 bits,
+    // so their products are summed in 64-bit accumulators and only reduced after as many terms as
+    // can be added without overflowing. When that allows only a few terms, the high and low 32-bit
+    // halves of each product are summed separately instead, which never needs a reduction inside
+    // the loop. Larger moduli accumulate in 128 bits where the compiler supports it, and otherwise
+    // reduce every term.
+
+    namespace Detail
+    {
+        constexpr size_t GemmModMC = 256;
+        constexpr size_t GemmModNB = 4;
+        constexpr size_t GemmModSplitLimit = 64;
+
+        // 128-bit products where the compiler has them, marked as an extension so -Wpedantic
+        // accepts them
+
+        #if defined(__SIZEOF_INT128__)
+            __extension__ typedef unsigned __int128 UInt128;
+        #endif
+
+        inline uint64_t MulMod64(uint64_t a, uint64_t b, uint64_t modulus)
+        {
+            #if defined(__SIZEOF_INT128__)
+                return (uint64_t)((UInt128)a * b % modulus);
+            #elif defined(_MSC_VER) && defined(_M_X64) && _MSC_VER >= 1920
+                uint64_t high;
+                uint64_t low = _umul128(a, b, &high);
+                uint64_t remainder;
+                _udiv128(high, low, modulus, &remainder);
+                return remainder;
+            #else
+                uint64_t result = 0;
+                a %= modulus;
+
+                while (b != 0)
+                {
+                    if (b & 1)
+                        result = (result >= modulus - a) ? result - (modulus - a) : result + a;
+                    a = (a >= modulus - a) ? a - (modulus - a) : a + a;
+                    b >>= 1;
+                }
+
+                return result;
+            #endif
+        }
+
+        template <typename Type>
+        void GemmMod32(size_t rows, size_t cols, size_t inner, const Type *a, const Type *b, Type *c, uint64_t modulus)
+        {
+            const uint64_t maxTerm = (modulus - 1) * (modulus - 1);
+            const size_t limit = maxTerm == 0 ? inner + 1 : (size_t)std::min<uint64_t>((UINT64_MAX - (modulus - 1)) / maxTerm, inner + 1);
+
+            std::vector<uint32_t> reducedA(rows * inner);
+
+            for (size_t i = 0; i < rows * inner; i++)
+                reducedA[i] = (uint32_t)(uint64_t(a[i]) % modulus);
+
+            const bool split = limit < GemmModSplitLimit && limit <= inner;
+            const uint64_t highScale = (uint64_t(1) << 32) % modulus;
+            const size_t blocks = (cols + GemmModNB - 1) / GemmModNB;
+
+            ParallelFor(0, blocks, 4, [&](size_t blockBegin, size_t blockEnd)
+            {
+                const size_t mcMax = std::min(GemmModMC, rows);
+                std::vector<uint64_t> acc(GemmModNB * mcMax);
+                std::vector<uint64_t> accHigh(split ? acc.size() : 0);
+                std::vector<uint32_t> reducedB(GemmModNB * inner);
+
+                for (size_t block = blockBegin; block < blockEnd; block++)
+                {
+                    const size_t col = block * GemmModNB;
+                    const size_t nb = std::min(GemmModNB, cols - col);
+
+                    for (size_t j = 0; j < nb; j++)
+                    {
+                        for (size_t m = 0; m < inner; m++)
+                            reducedB[m * GemmModNB + j] = (uint32_t)(uint64_t(b[(col + j) * inner + m]) % modulus);
+                    }
+
+                    // Each column of a tile of A is loaded once for the nb columns of the block
+
+                    for (size_t ic = 0; ic < rows; ic += GemmModMC)
+                    {
+                        const size_t mc = std::min(GemmModMC, rows - ic);
+
+                        std::fill(acc.begin(), acc.end(), uint64_t(0));
+
+                        if (split)
+                        {
+                            std::fill(accHigh.begin(), accHigh.end(), uint64_t(0));
+
+                            for (size_t m = 0; m < inner; m++)
+                            {
+                                const uint32_t *aCol = reducedA.data() + m * rows + ic;
+
+                                for (size_t j = 0; j < nb; j++)
+                                {
+                                    const uint32_t scale = reducedB[m * GemmModNB + j];
+                                    uint64_t *accData = acc.data() + j * mcMax;
+                                    uint64_t *accHighData = accHigh.data() + j * mcMax;
+
+                                    for (size_t i = 0; i < mc; i++)
+                                    {
+                                        uint64_t product = uint64_t(aCol[i]) * uint64_t(scale);
+                                        accData[i] += product & UINT32_MAX;
+                                        accHighData[i] += product >> 32;
+                                    }
+                                }
+                            }
+
+                            for (size_t j = 0; j < nb; j++)
+                            {
+                                const uint64_t *accData = acc.data() + j * mcMax;
+                                const uint64_t *accHighData = accHigh.data() + j * mcMax;
+                                Type *cCol = c + (col + j) * rows + ic;
+
+                                for (size_t i = 0; i < mc; i++)
+                                    cCol[i] = (Type)(((accHighData[i] % modulus) * highScale + accData[i] % modulus) % modulus);
+                            }
+
+                            continue;
+                        }
+
+                        size_t terms = 0;
+
+                        for (size_t m = 0; m < inner; m++)
+                        {
+                            const uint32_t *scales = reducedB.data() + m * GemmModNB;
+                            const uint32_t *aCol = reducedA.data() + m * rows + ic;
+                            bool zero = true;
+
+                            for (size_t j = 0; j < nb; j++)
+                                zero = zero && scales[j] == 0;
+
+                            if (zero)
+                                continue;
+
+                            for (size_t j = 0; j < nb; j++)
+                            {
+                                const uint32_t scale = scales[j];
+                                uint64_t *accData = acc.data() + j * mcMax;
+
+                                for (size_t i = 0; i < mc; i++)
+                                    accData[i] += uint64_t(aCol[i]) * uint64_t(scale);
+                            }
+
+                            if (++terms == limit)
+                            {
+                                for (size_t i = 0; i < nb * mcMax; i++)
+                                    acc[i] %= modulus;
+                                terms = 0;
+                            }
+                        }
+
+                        for (size_t j = 0; j < nb; j++)
+                        {
+                            const uint64_t *accData = acc.data() + j * mcMax;
+                            Type *cCol = c + (col + j) * rows + ic;
+
+                            for (size_t i = 0; i < mc; i++)
+                                cCol[i] = (Type)(accData[i] % modulus);
+                        }
+                    }
+                }
+            });
+        }
+
+        template <typename Type>
+        void GemmMod64(size_t rows, size_t cols, size_t inner, const Type *a, const Type *b, Type *c, uint64_t modulus)
+        {
+            std::vector<uint64_t> reducedA(rows * inner);
+
+            for (size_t i = 0; i < rows * inner; i++)
+                reducedA[i] = uint64_t(a[i]) % modulus;
+
+            #if defined(__SIZEOF_INT128__)
+                typedef UInt128 Wide;
+
+                const Wide maxTerm = Wide(modulus - 1) * (modulus - 1);
+                const Wide wideLimit = (~Wide(0) - (modulus - 1)) / maxTerm;
+                const size_t limit = wideLimit > inner ? inner + 1 : (size_t)wideLimit;
+            #else
+                typedef uint64_t Wide;
+            #endif
+
+            const size_t blocks = (cols + GemmModNB - 1) / GemmModNB;
+
+            ParallelFor(0, blocks, 4, [&](size_t blockBegin, size_t blockEnd)
+            {
+                const size_t mcMax = std::min(GemmModMC, rows);
+                std::vector<Wide> acc(GemmModNB * mcMax);
+                std::vector<uint64_t> reducedB(GemmModNB * inner);
+
+                for (size_t block = blockBegin; block < blockEnd; block++)
+                {
+                    const size_t col = block * GemmModNB;
+                    const size_t nb = std::min(GemmModNB, cols - col);
+
+                    for (size_t j = 0; j < nb; j++)
+                    {
+                        for (size_t m = 0; m < inner; m++)
+                            reducedB[m * GemmModNB + j] = uint64_t(b[(col + j) * inner + m]) % modulus;
+                    }
+
+                    for (size_t ic = 0; ic < rows; ic += GemmModMC)
+                    {
+                        const size_t mc = std::min(GemmModMC, rows - ic);
+
+                        std::fill(acc.begin(), acc.end(), Wide(0));
+
+                        #if defined(__SIZEOF_INT128__)
+                            size_t terms = 0;
+                        #endif
+
+                        for (size_t m = 0; m < inner; m++)
+                        {
+                            const uint64_t *scales = reducedB.data() + m * GemmModNB;
+                            const uint64_t *aCol = reducedA.data() + m * rows + ic;
+
+                            for (size_t j = 0; j < nb; j++)
+                            {
+                                const uint64_t scale = scales[j];
+                                Wide *accData = acc.data() + j * mcMax;
+
+                                #if defined(__SIZEOF_INT128__)
+                                    for (size_t i = 0; i < mc; i++)
+                                        accData[i] += Wide(aCol[i]) * scale;
+                                #else
+                                    for (size_t i = 0; i < mc; i++)
+                                    {
+                                        uint64_t term = MulMod64(aCol[i], scale, modulus);
+                                        accData[i] = (accData[i] >= modulus - term) ? accData[i] - (modulus - term) : accData[i] + term;
+                                    }
+                                #endif
+                            }
+
+                            #if defined(__SIZEOF_INT128__)
+                                if (++terms == limit)
+                                {
+                                    for (size_t i = 0; i < nb * mcMax; i++)
+                                        acc[i] %= modulus;
+                                    terms = 0;
+                                }
+                            #endif
+                        }
+
+                        for (size_t j = 0; j < nb; j++)
+                        {
+                            const Wide *accData = acc.data() + j * mcMax;
+                            Type *cCol = c + (col + j) * rows + ic;
+
+                            for (size_t i = 0; i < mc; i++)
+                                cCol[i] = (Type)(uint64_t)(accData[i] % modulus);
+                        }
+                    }
+                }
+            });
+        }
+
+        template <typename Type>
+        void GemmMod(size_t rows, size_t cols, size_t inner, const Type *a, const Type *b, Type *c, uint64_t modulus)
+        {
+            static_assert(std::is_integral<Type>::value && std::is_unsigned<Type>::value, "Modular multiplication requires an unsigned integer type.");
+
+            if (modulus == 0)
+                throw std::runtime_error("MultiplyMod: modulus must be non-zero.");
+            if (modulus - 1 > std::numeric_limits<Type>::max())
+                throw std::runtime_error("MultiplyMod: residues do not fit in the element type.");
+
+            if (modulus - 1 <= UINT32_MAX)
+                GemmMod32(rows, cols, inner, a, b, c, modulus);
+            else
+                GemmMod64(rows, cols, inner, a, b, c, modulus);
+        }
+    }
+
+    // Modular matrix products
+
+    template <typename Type, size_t Rows, size_t Inner, size_t Cols>
+    Matrix<Type, Rows, Cols> MultiplyMod(const Matrix<Type, Rows, Inner> &a, const Matrix<Type, Inner, Cols> &b, uint64_t modulus)
+    {
+        Matrix<Type, Rows, Cols> newMat;
+        Detail::GemmMod(Rows, Cols, Inner, a.data, b.data, newMat.data, modulus);
+        return newMat;
+    }
+
+    template <typename Type, size_t Rows, size_t Cols>
+    Vector<Type, Rows> MultiplyMod(const Matrix<Type, Rows, Cols> &mat, const Vector<Type, Cols> &vec, uint64_t modulus)
+    {
+        Vector<Type, Rows> newVec;
+        Detail::GemmMod(Rows, 1, Cols, mat.data, vec.data, newVec.data, modulus);
+        return newVec;
+    }
+
+    // Modular matrix power, evaluated by repeated squaring
+
+    template <typename Type, size_t Size>
+    Matrix<Type, Size, Size> PowerMod(const Matrix<Type, Size, Size> &mat, uint64_t exponent, uint64_t modulus)
+    {
+        if (modulus == 0)
+            throw std::runtime_error("PowerMod: modulus must be non-zero.");
+
+        Matrix<Type, Size, Size> result(Type(1 % modulus));
+        Matrix<Type, Size, Size> base(mat);
+
+        while (exponent != 0)
+        {
+            if (exponent & 1)
+                result = MultiplyMod(result, base, modulus);
+
+            exponent >>= 1;
+
+            if (exponent != 0)
+                base = MultiplyMod(base, base, modulus);
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,460 @@
+#pragma once
+
+#include <Math/Matrix.hpp>
+
+namespace Scoop::Math
+{
+    // Multigrid options and results
+
+    enum class MultigridCycle
+    {
+        V,
+        W
+    };
+
+    struct MultigridOptions
+    {
+        MultigridCycle cycle = MultigridCycle::V;
+        size_t maxCycles = 50;
+        size_t preSmoothing = 2;
+        size_t postSmoothing = 2;
+        size_t coarsestSmoothing = 50;
+        double tolerance = 1e-8;
+    };
+
+    struct MultigridResult
+    {
+        size_t cycles = 0;
+        double residual = 0;
+        bool converged = false;
+    };
+
+    // Geometric multigrid for the 2-D Poisson equation
+    //
+    // Solves -∇²u = f on a rows x cols grid with spacing h, discretized with the 5-point stencil.
+    // The first and last row and column of u are Dirichlet boundary values and are left untouched.
+    // Grids are stored column-major like Matrix, and the grid hierarchy is allocated once so
+    // repeated solves do not allocate.
+    //
+    // Each coarser level keeps every other node of each dimension that still has interior points
+    // to remove, plus that dimension's last node, so every level covers exactly the same domain
+    // whatever the grid size. Levels are discretized with the symmetric finite-volume form of the
+    // 5-point stencil on their (possibly non-uniform) nodes, corrections are interpolated
+    // bilinearly, and residuals are restricted with the transpose of the interpolation.
+
+    template <typename Type> class PoissonMultigrid
+    {
+        public:
+
+        // Constructors
+
+        PoissonMultigrid(size_t rows, size_t cols, Type spacing, const MultigridOptions &options = MultigridOptions())
+            : options(options)
+        {
+            if (rows < 3 || cols < 3)
+                throw std::runtime_error("PoissonMultigrid: grid must have at least one interior point.");
+
+            std::vector<Type> rowNodes(rows), colNodes(cols);
+
+            for (size_t i = 0; i < rows; i++)
+                rowNodes[i] = Type(i) * spacing;
+            for (size_t i = 0; i < cols; i++)
+                colNodes[i] = Type(i) * spacing;
+
+            while (true)
+            {
+                Level level;
+                level.rows = Axis(rowNodes);
+                level.cols = Axis(colNodes);
+                level.u.assign(rowNodes.size() * colNodes.size(), Type(0));
+                level.b.assign(rowNodes.size() * colNodes.size(), Type(0));
+                level.r.assign(rowNodes.size() * colNodes.size(), Type(0));
+                this->levels.push_back(std::move(level));
+
+                if (rowNodes.size() <= 3 && colNodes.size() <= 3)
+                    break;
+
+                rowNodes = Coarsen(rowNodes);
+                colNodes = Coarsen(colNodes);
+            }
+
+            for (size_t i = 0; i + 1 < this->levels.size(); i++)
+            {
+                this->levels[i].rows.Link(this->levels[i + 1].rows);
+                this->levels[i].cols.Link(this->levels[i + 1].cols);
+            }
+        }
+
+        // Solving
+
+        MultigridResult Solve(Type *u, const Type *f)
+        {
+            Level &fine = this->levels[0];
+            const size_t rows = fine.rows.size;
+            const size_t cols = fine.cols.size;
+
+            std::copy(u, u + rows * cols, fine.u.begin());
+
+            for (size_t col = 0; col < cols; col++)
+            {
+                for (size_t row = 0; row < rows; row++)
+                    fine.b[col * rows + row] = f[col * rows + row] * fine.rows.volume[row] * fine.cols.volume[col];
+            }
+
+            MultigridResult result;
+            double initial = this->Residual();
+            result.residual = initial;
+
+            // Stops early once rounding error keeps the residual from decreasing
+
+            while (result.residual > this->options.tolerance * initial && result.cycles < this->options.maxCycles)
+            {
+                this->Cycle(0);
+                result.cycles++;
+
+                double residual = this->Residual();
+                bool stalled = !(residual < result.residual);
+                result.residual = residual;
+
+                if (stalled)
+                    break;
+            }
+
+            result.converged = result.residual <= this->options.tolerance * initial;
+            std::copy(fine.u.begin(), fine.u.end(), u);
+            return result;
+        }
+
+        template <size_t Rows, size_t Cols>
+        MultigridResult Solve(Matrix<Type, Rows, Cols> &u, const Matrix<Type, Rows, Cols> &f)
+        {
+            if (Rows != this->levels[0].rows.size || Cols != this->levels[0].cols.size)
+                throw std::runtime_error("PoissonMultigrid::Solve: grid size mismatch.");
+            return this->Solve(u.data, f.data);
+        }
+
+        size_t LevelCount() const
+        { return this->levels.size(); }
+
+        private:
+
+        // Per-dimension geometry of a level: inverse spacings to each neighbour, control volume
+        // widths, and the interpolation from the next coarser level
+
+        struct Axis
+        {
+            size_t size = 0;
+            std::vector<Type> nodes;
+            std::vector<Type> left;
+            std::vector<Type> right;
+            std::vector<Type> volume;
+
+            std::vector<size_t> coarse0;
+            std::vector<size_t> coarse1;
+            std::vector<Type> weight0;
+            std::vector<Type> weight1;
+            std::vector<size_t> fineOfCoarse;
+
+            Axis() = default;
+
+            explicit Axis(const std::vector<Type> &nodes)
+                : size(nodes.size()), nodes(nodes), left(nodes.size(), Type(0)), right(nodes.size(), Type(0)), volume(nodes.size(), Type(0))
+            {
+                for (size_t i = 1; i + 1 < this->size; i++)
+                {
+                    this->left[i] = Type(1) / (nodes[i] - nodes[i - 1]);
+                    this->right[i] = Type(1) / (nodes[i + 1] - nodes[i]);
+                    this->volume[i] = (nodes[i + 1] - nodes[i - 1]) / 2;
+                }
+            }
+
+            void Link(const Axis &coarse)
+            {
+                this->coarse0.assign(this->size, 0);
+                this->coarse1.assign(this->size, 0);
+                this->weight0.assign(this->size, Type(0));
+                this->weight1.assign(this->size, Type(0));
+                this->fineOfCoarse.assign(coarse.size, 0);
+
+                size_t c = 0;
+
+                for (size_t i = 0; i < this->size; i++)
+                {
+                    while (c + 1 < coarse.size && coarse.nodes[c + 1] <= this->nodes[i])
+                        c++;
+
+                    if (coarse.nodes[c] == this->nodes[i])
+                    {
+                        this->coarse0[i] = this->coarse1[i] = c;
+                        this->weight0[i] = Type(1);
+                        this->fineOfCoarse[c] = i;
+                    }
+                    else
+                    {
+                        const Type width = coarse.nodes[c + 1] - coarse.nodes[c];
+                        this->coarse0[i] = c;
+                        this->coarse1[i] = c + 1;
+                        this->weight0[i] = (coarse.nodes[c + 1] - this->nodes[i]) / width;
+                        this->weight1[i] = (this->nodes[i] - coarse.nodes[c]) / width;
+                    }
+                }
+            }
+
+            // Weight of coarse node c in the interpolation to fine node i
+
+            Type Weight(size_t i, size_t c) const
+            {
+                if (this->coarse0[i] == c)
+                    return this->weight0[i];
+                if (this->coarse1[i] == c)
+                    return this->weight1[i];
+                return Type(0);
+            }
+        };
+
+        struct Level
+        {
+            Axis rows;
+            Axis cols;
+            std::vector<Type> u;
+            std::vector<Type> b;
+            std::vector<Type> r;
+        };
+
+        MultigridOptions options;
+        std::vector<Level> levels;
+
+        static constexpr size_t ParallelColumns = 64;
+
+        static std::vector<Type> Coarsen(const std::vector<Type> &nodes)
+        {
+            if (nodes.size() <= 3)
+                return nodes;
+
+            std::vector<Type> coarse;
+
+            for (size_t i = 0; i < nodes.size(); i += 2)
+                coarse.push_back(nodes[i]);
+
+            if ((nodes.size() - 1) % 2 != 0)
+                coarse.push_back(nodes.back());
+
+            return coarse;
+        }
+
+        void Cycle(size_t index)
+        {
+            Level &level = this->levels[index];
+
+            if (index + 1 == this->levels.size())
+            {
+                this->Smooth(level, this->options.coarsestSmoothing);
+                return;
+            }
+
+            Level &coarse = this->levels[index + 1];
+
+            this->Smooth(level, this->options.preSmoothing);
+            this->ComputeResidual(level);
+            this->Restrict(level, coarse);
+
+            std::fill(coarse.u.begin(), coarse.u.end(), Type(0));
+
+            size_t visits = this->options.cycle == MultigridCycle::W ? 2 : 1;
+
+            for (size_t visit = 0; visit < visits; visit++)
+                this->Cycle(index + 1);
+
+            this->ProlongateAdd(coarse, level);
+            this->Smooth(level, this->options.postSmoothing);
+        }
+
+        // Red-black Gauss-Seidel. Points of one colour only depend on the other colour, so the
+        // columns of each half-sweep are independent and split between threads.
+
+        void Smooth(Level &level, size_t sweeps)
+        {
+            const size_t rows = level.rows.size;
+            const size_t cols = level.cols.size;
+            const Type *rowLeft = level.rows.left.data();
+            const Type *rowRight = level.rows.right.data();
+            const Type *rowVolume = level.rows.volume.data();
+            Type *u = level.u.data();
+            const Type *b = level.b.data();
+
+            for (size_t sweep = 0; sweep < sweeps; sweep++)
+            {
+                for (size_t color = 0; color < 2; color++)
+                {
+                    ParallelFor(1, cols - 1, ParallelColumns, [&](size_t colBegin, size_t colEnd)
+                    {
+                        for (size_t col = colBegin; col < colEnd; col++)
+                        {
+                            const Type colLeft = level.cols.left[col];
+                            const Type colRight = level.cols.right[col];
+                            const Type colVolume = level.cols.volume[col];
+                            Type *uCol = u + col * rows;
+                            const Type *left = uCol - rows;
+                            const Type *right = uCol + rows;
+                            const Type *bCol = b + col * rows;
+
+                            for (size_t row = 1 + ((col + color + 1) & 1); row < rows - 1; row += 2)
+                            {
+                                const Type diagonal = colVolume * (rowLeft[row] + rowRight[row]) + rowVolume[row] * (colLeft + colRight);
+                                const Type sum = bCol[row] + colVolume * (rowLeft[row] * uCol[row - 1] + rowRight[row] * uCol[row + 1])
+                                    + rowVolume[row] * (colLeft * left[row] + colRight * right[row]);
+
+                                uCol[row] = sum / diagonal;
+                            }
+                        }
+                    });
+                }
+            }
+        }
+
+        void ComputeResidual(Level &level)
+        {
+            const size_t rows = level.rows.size;
+            const size_t cols = level.cols.size;
+            const Type *rowLeft = level.rows.left.data();
+            const Type *rowRight = level.rows.right.data();
+            const Type *rowVolume = level.rows.volume.data();
+            const Type *u = level.u.data();
+            const Type *b = level.b.data();
+            Type *r = level.r.data();
+
+            std::fill(r, r + rows, Type(0));
+            std::fill(r + (cols - 1) * rows, r + cols * rows, Type(0));
+
+            ParallelFor(1, cols - 1, ParallelColumns, [&](size_t colBegin, size_t colEnd)
+            {
+                for (size_t col = colBegin; col < colEnd; col++)
+                {
+                    const Type colLeft = level.cols.left[col];
+                    const Type colRight = level.cols.right[col];
+                    const Type colVolume = level.cols.volume[col];
+                    const Type *uCol = u + col * rows;
+                    const Type *left = uCol - rows;
+                    const Type *right = uCol + rows;
+                    const Type *bCol = b + col * rows;
+                    Type *rCol = r + col * rows;
+
+                    rCol[0] = 0;
+                    rCol[rows - 1] = 0;
+
+                    for (size_t row = 1; row < rows - 1; row++)
+                    {
+                        const Type diagonal = colVolume * (rowLeft[row] + rowRight[row]) + rowVolume[row] * (colLeft + colRight);
+
+                        rCol[row] = bCol[row] - diagonal * uCol[row]
+                            + colVolume * (rowLeft[row] * uCol[row - 1] + rowRight[row] * uCol[row + 1])
+                            + rowVolume[row] * (colLeft * left[row] + colRight * right[row]);
+                    }
+                }
+            });
+        }
+
+        // Norm of f + ∇²u on the finest level, undoing the control volume scaling
+
+        double Residual()
+        {
+            Level &level = this->levels[0];
+            this->ComputeResidual(level);
+
+            const size_t rows = level.rows.size;
+            const size_t cols = level.cols.size;
+            double sum = 0;
+
+            for (size_t col = 1; col + 1 < cols; col++)
+            {
+                for (size_t row = 1; row + 1 < rows; row++)
+                {
+                    double value = double(level.r[col * rows + row]) / (double(level.rows.volume[row]) * double(level.cols.volume[col]));
+                    sum += value * value;
+                }
+            }
+
+            return std::sqrt(sum);
+        }
+
+        // Restriction with the transpose of the bilinear interpolation. The fine nodes that
+        // interpolate from a coarse node lie strictly between its two coarse neighbours.
+
+        void Restrict(const Level &fine, Level &coarse)
+        {
+            const size_t fineRows = fine.rows.size;
+            const size_t coarseRows = coarse.rows.size;
+            const Type *r = fine.r.data();
+            Type *b = coarse.b.data();
+
+            std::fill(coarse.b.begin(), coarse.b.end(), Type(0));
+
+            ParallelFor(1, coarse.cols.size - 1, ParallelColumns, [&](size_t colBegin, size_t colEnd)
+            {
+                for (size_t col = colBegin; col < colEnd; col++)
+                {
+                    const size_t fineColBegin = fine.cols.fineOfCoarse[col - 1] + 1;
+                    const size_t fineColEnd = fine.cols.fineOfCoarse[col + 1];
+                    Type *bCol = b + col * coarseRows;
+
+                    for (size_t row = 1; row < coarseRows - 1; row++)
+                    {
+                        const size_t fineRowBegin = fine.rows.fineOfCoarse[row - 1] + 1;
+                        const size_t fineRowEnd = fine.rows.fineOfCoarse[row + 1];
+                        Type sum = 0;
+
+                        for (size_t fineCol = fineColBegin; fineCol < fineColEnd; fineCol++)
+                        {
+                            const Type colWeight = fine.cols.Weight(fineCol, col);
+                            const Type *rCol = r + fineCol * fineRows;
+
+                            for (size_t fineRow = fineRowBegin; fineRow < fineRowEnd; fineRow++)
+                                sum += colWeight * fine.rows.Weight(fineRow, row) * rCol[fineRow];
+                        }
+
+                        bCol[row] = sum;
+                    }
+                }
+            });
+        }
+
+        // Bilinear interpolation of the coarse correction, added to the fine interior
+
+        void ProlongateAdd(const Level &coarse, Level &fine)
+        {
+            const size_t fineRows = fine.rows.size;
+            const size_t coarseRows = coarse.rows.size;
+            const Type *c = coarse.u.data();
+            Type *u = fine.u.data();
+
+            ParallelFor(1, fine.cols.size - 1, ParallelColumns, [&](size_t colBegin, size_t colEnd)
+            {
+                for (size_t col = colBegin; col < colEnd; col++)
+                {
+                    const Type *c0 = c + fine.cols.coarse0[col] * coarseRows;
+                    const Type *c1 = c + fine.cols.coarse1[col] * coarseRows;
+                    const Type w0 = fine.cols.weight0[col];
+                    const Type w1 = fine.cols.weight1[col];
+                    Type *uCol = u + col * fineRows;
+
+                    for (size_t row = 1; row < fineRows - 1; row++)
+                    {
+                        const size_t row0 = fine.rows.coarse0[row];
+                        const size_t row1 = fine.rows.coarse1[row];
+                        const Type v0 = fine.rows.weight0[row];
+                        const Type v1 = fine.rows.weight1[row];
+
+                        uCol[row] += w0 * (v0 * c0[row0] + v1 * c0[row1]) + w1 * (v0 * c1[row0] + v1 * c1[row1]);
+                    }
+                }
+            });
+        }
+    };
+
+    template <typename Type, size_t Rows, size_t Cols>
+    MultigridResult SolvePoisson(Matrix<Type, Rows, Cols> &u, const Matrix<Type, Rows, Cols> &f, Type spacing, const MultigridOptions &options = MultigridOptions())
+    {
+        PoissonMultigrid<Type> multigrid(Rows, Cols, spacing, options);
+        return multigrid.Solve(u, f);
+    }
+}
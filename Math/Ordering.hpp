@@ -0,0 +1,710 @@
+#pragma once
+
+#include <Math/Sparse.hpp>
+
+namespace Scoop::Math
+{
+    // Sparse matrix orderings
+    //
+    // An ordering is a permutation where permutation[i] is the row (and column) of the original
+    // matrix that becomes row i of the reordered matrix, as used by SparseCholesky. Orderings are
+    // computed on the symmetric pattern of A + Aᵀ, ignoring the diagonal.
+
+    namespace Detail
+    {
+        constexpr size_t NestedDissectionLeaf = 64;
+
+        // Graph in compressed form: the neighbours of vertex v are neighbours[offsets[v]] to
+        // neighbours[offsets[v + 1] - 1]
+
+        struct OrderingGraph
+        {
+            std::vector<size_t> offsets;
+            std::vector<size_t> neighbours;
+
+            size_t Size() const
+            { return this->offsets.size() - 1; }
+
+            size_t Degree(size_t v) const
+            { return this->offsets[v + 1] - this->offsets[v]; }
+        };
+
+        template <typename Type>
+        OrderingGraph SymmetricGraph(const SparseMatrix<Type> &mat)
+        {
+            if (mat.rows != mat.cols)
+                throw std::runtime_error("Ordering: matrix must be square.");
+
+            const size_t n = mat.rows;
+            std::vector<size_t> counts(n + 1, 0);
+
+            for (size_t col = 0; col < n; col++)
+            {
+                for (size_t i = mat.colOffsets[col]; i < mat.colOffsets[col + 1]; i++)
+                {
+                    if (mat.rowIndices[i] != col)
+                    {
+                        counts[mat.rowIndices[i] + 1]++;
+                        counts[col + 1]++;
+                    }
+                }
+            }
+
+            for (size_t v = 0; v < n; v++)
+                counts[v + 1] += counts[v];
+
+            std::vector<size_t> all(counts[n]);
+            std::vector<size_t> fill(counts.begin(), counts.end() - 1);
+
+            for (size_t col = 0; col < n; col++)
+            {
+                for (size_t i = mat.colOffsets[col]; i < mat.colOffsets[col + 1]; i++)
+                {
+                    const size_t row = mat.rowIndices[i];
+
+                    if (row != col)
+                    {
+                        all[fill[row]++] = col;
+                        all[fill[col]++] = row;
+                    }
+                }
+            }
+
+            // Sort and remove the duplicates of entries stored in both triangles
+
+            OrderingGraph graph;
+            graph.offsets.assign(n + 1, 0);
+            graph.neighbours.reserve(all.size());
+
+            for (size_t v = 0; v < n; v++)
+            {
+                std::sort(all.begin() + counts[v], all.begin() + counts[v + 1]);
+                auto end = std::unique(all.begin() + counts[v], all.begin() + counts[v + 1]);
+                graph.neighbours.insert(graph.neighbours.end(), all.begin() + counts[v], end);
+                graph.offsets[v + 1] = graph.neighbours.size();
+            }
+
+            return graph;
+        }
+
+        // Breadth-first level structure over the vertices with active[v] == stamp, returning the
+        // vertices in visiting order and filling level[v]
+
+        inline std::vector<size_t> LevelStructure(const OrderingGraph &graph, size_t root, const std::vector<size_t> &active, size_t stamp,
+            std::vector<size_t> &level, std::vector<size_t> &visited, size_t visit)
+        {
+            std::vector<size_t> order(1, root);
+            visited[root] = visit;
+            level[root] = 0;
+
+            for (size_t head = 0; head < order.size(); head++)
+            {
+                const size_t v = order[head];
+
+                for (size_t p = graph.offsets[v]; p < graph.offsets[v + 1]; p++)
+                {
+                    const size_t w = graph.neighbours[p];
+
+                    if (active[w] == stamp && visited[w] != visit)
+                    {
+                        visited[w] = visit;
+                        level[w] = level[v] + 1;
+                        order.push_back(w);
+                    }
+                }
+            }
+
+            return order;
+        }
+
+        // Pseudo-peripheral vertex (George and Liu): repeatedly restarts from a vertex of minimum
+        // degree in the last level while the number of levels grows
+
+        inline size_t PseudoPeripheral(const OrderingGraph &graph, size_t start, const std::vector<size_t> &active, size_t stamp,
+            std::vector<size_t> &level, std::vector<size_t> &visited, size_t &visit)
+        {
+            size_t root = start;
+            size_t depth = 0;
+
+            while (true)
+            {
+                std::vector<size_t> order = LevelStructure(graph, root, active, stamp, level, visited, ++visit);
+                const size_t last = level[order.back()];
+
+                if (last <= depth)
+                    return root;
+
+                size_t candidate = order.back();
+
+                for (size_t i = order.size(); i-- > 0 && level[order[i]] == last;)
+                {
+                    if (graph.Degree(order[i]) < graph.Degree(candidate))
+                        candidate = order[i];
+                }
+
+                depth = last;
+                root = candidate;
+            }
+        }
+
+        // Approximate minimum degree on a quotient graph. Eliminating a variable turns it into an
+        // element whose members are its remaining neighbours; elements adjacent to the pivot are
+        // absorbed into it. Degrees are updated with the approximate external degree bound of
+        // Amestoy, Davis and Duff rather than recomputed exactly. Variables with identical
+        // neighbourhoods are merged into weighted supervariables and eliminated together.
+
+        inline std::vector<size_t> MinimumDegree(const OrderingGraph &graph)
+        {
+            const size_t n = graph.Size();
+            const size_t none = size_t(-1);
+
+            std::vector<std::vector<size_t>> variables(n), elements(n), members(n);
+            std::vector<size_t> degree(n), head(n + 1, none), next(n, none), previous(n, none);
+            std::vector<size_t> weight(n, 1), elementSize(n, 0), elementWeight(n, 0);
+            std::vector<size_t> mark(n, 0), elementStamp(n, 0), compareStamp(n, 0);
+            std::vector<size_t> chainNext(n, none), chainTail(n);
+            std::vector<bool> eliminated(n, false), absorbed(n, false);
+            std::vector<std::pair<size_t, size_t>> hashes;
+            std::vector<size_t> order;
+            order.reserve(n);
+            size_t stamp = 0;
+
+            auto insert = [&](size_t v)
+            {
+                next[v] = head[degree[v]];
+                previous[v] = none;
+                if (head[degree[v]] != none)
+                    previous[head[degree[v]]] = v;
+                head[degree[v]] = v;
+            };
+
+            auto remove = [&](size_t v)
+            {
+                if (previous[v] != none)
+                    next[previous[v]] = next[v];
+                else
+                    head[degree[v]] = next[v];
+                if (next[v] != none)
+                    previous[next[v]] = previous[v];
+            };
+
+            auto principal = [&](size_t v)
+            { return weight[v] != 0 && !eliminated[v]; };
+
+            for (size_t v = 0; v < n; v++)
+            {
+                variables[v].assign(graph.neighbours.begin() + graph.offsets[v], graph.neighbours.begin() + graph.offsets[v + 1]);
+                degree[v] = variables[v].size();
+                chainTail[v] = v;
+                insert(v);
+            }
+
+            size_t minimum = 0;
+            size_t done = 0;
+
+            while (done < n)
+            {
+                while (head[minimum] == none)
+                    minimum++;
+
+                const size_t p = head[minimum];
+                remove(p);
+                eliminated[p] = true;
+                done += weight[p];
+
+                for (size_t v = p; v != none; v = chainNext[v])
+                    order.push_back(v);
+
+                // Members of the new element p: its variable neighbours and the members of its elements
+
+                std::vector<size_t> &pMembers = members[p];
+                stamp++;
+                mark[p] = stamp;
+
+                for (size_t v : variables[p])
+                {
+                    if (principal(v) && mark[v] != stamp)
+                    {
+                        mark[v] = stamp;
+                        pMembers.push_back(v);
+                    }
+                }
+
+                for (size_t e : elements[p])
+                {
+                    if (absorbed[e])
+                        continue;
+
+                    for (size_t v : members[e])
+                    {
+                        if (principal(v) && mark[v] != stamp)
+                        {
+                            mark[v] = stamp;
+                            pMembers.push_back(v);
+                        }
+                    }
+
+                    absorbed[e] = true;
+                    std::vector<size_t>().swap(members[e]);
+                }
+
+                std::vector<size_t>().swap(variables[p]);
+                std::vector<size_t>().swap(elements[p]);
+
+                size_t pSize = 0;
+
+                for (size_t i : pMembers)
+                    pSize += weight[i];
+
+                elementSize[p] = pSize;
+
+                // Weighted |L_e \ L_p| for every element adjacent to a member of p
+
+                for (size_t i : pMembers)
+                {
+                    for (size_t e : elements[i])
+                    {
+                        if (absorbed[e])
+                            continue;
+
+                        if (elementStamp[e] != stamp)
+                        {
+                            elementStamp[e] = stamp;
+                            elementWeight[e] = elementSize[e];
+                        }
+
+                        elementWeight[e] -= weight[i];
+                    }
+                }
+
+                const size_t remaining = n - done;
+                hashes.clear();
+
+                for (size_t i : pMembers)
+                {
+                    remove(i);
+
+                    // Prune the variable list of everything now reachable through p
+
+                    std::vector<size_t> &iVariables = variables[i];
+                    size_t variableDegree = 0;
+                    size_t kept = 0;
+                    size_t hash = p;
+
+                    for (size_t v : iVariables)
+                    {
+                        if (principal(v) && mark[v] != stamp)
+                        {
+                            iVariables[kept++] = v;
+                            variableDegree += weight[v];
+                            hash += v;
+                        }
+                    }
+
+                    iVariables.resize(kept);
+
+                    // Drop absorbed elements, and absorb elements whose members all belong to p
+
+                    std::vector<size_t> &iElements = elements[i];
+                    size_t elementDegree = 0;
+                    kept = 0;
+
+                    for (size_t e : iElements)
+                    {
+                        if (absorbed[e])
+                            continue;
+
+                        if (elementWeight[e] == 0)
+                        {
+                            absorbed[e] = true;
+                            std::vector<size_t>().swap(members[e]);
+                            continue;
+                        }
+
+                        elementDegree += elementWeight[e];
+                        iElements[kept++] = e;
+                        hash += e;
+                    }
+
+                    iElements.resize(kept);
+                    iElements.push_back(p);
+
+                    const size_t external = pSize - weight[i];
+                    const size_t bound = variableDegree + external + elementDegree;
+                    degree[i] = std::min({ remaining - weight[i], degree[i] + external, bound });
+                    hashes.emplace_back(hash, i);
+                }
+
+                // Supervariables: members of p with the same elements and variable neighbours
+
+                std::sort(hashes.begin(), hashes.end());
+
+                for (size_t a = 0; a < hashes.size(); a++)
+                {
+                    const size_t i = hashes[a].second;
+
+                    if (weight[i] == 0)
+                        continue;
+
+                    bool marked = false;
+
+                    for (size_t b = a + 1; b < hashes.size() && hashes[b].first == hashes[a].first; b++)
+                    {
+                        const size_t j = hashes[b].second;
+
+                        if (weight[j] == 0 || variables[i].size() != variables[j].size() || elements[i].size() != elements[j].size())
+                            continue;
+
+                        if (!marked)
+                        {
+                            for (size_t v : variables[i])
+                                compareStamp[v] = i + 1;
+                            for (size_t e : elements[i])
+                                compareStamp[e] = i + 1;
+                            marked = true;
+                        }
+
+                        bool same = true;
+
+                        for (size_t v : variables[j])
+                            same = same && compareStamp[v] == i + 1;
+                        for (size_t e : elements[j])
+                            same = same && compareStamp[e] == i + 1;
+
+                        if (!same)
+                            continue;
+
+                        degree[i] = degree[i] > weight[j] ? degree[i] - weight[j] : 0;
+                        weight[i] += weight[j];
+                        weight[j] = 0;
+                        chainNext[chainTail[i]] = j;
+                        chainTail[i] = chainTail[j];
+                        std::vector<size_t>().swap(variables[j]);
+                        std::vector<size_t>().swap(elements[j]);
+                    }
+                }
+
+                for (size_t i : pMembers)
+                {
+                    if (weight[i] == 0)
+                        continue;
+
+                    insert(i);
+                    minimum = std::min(minimum, degree[i]);
+                }
+            }
+
+            return order;
+        }
+    }
+
+    // Reverse Cuthill-McKee ordering, which reduces the bandwidth and profile. Each connected
+    // component is visited breadth first from a pseudo-peripheral vertex, neighbours in order of
+    // increasing degree, and the visiting order is reversed.
+
+    template <typename Type>
+    std::vector<size_t> ReverseCuthillMcKee(const SparseMatrix<Type> &mat)
+    {
+        const Detail::OrderingGraph graph = Detail::SymmetricGraph(mat);
+        const size_t n = graph.Size();
+
+        std::vector<size_t> active(n, 1), level(n), visited(n, 0), order;
+        std::vector<bool> placed(n, false);
+        std::vector<size_t> neighbours;
+        size_t visit = 0;
+        order.reserve(n);
+
+        for (size_t start = 0; start < n; start++)
+        {
+            if (placed[start])
+                continue;
+
+            const size_t root = Detail::PseudoPeripheral(graph, start, active, 1, level, visited, visit);
+            size_t head = order.size();
+            order.push_back(root);
+            placed[root] = true;
+
+            for (; head < order.size(); head++)
+            {
+                const size_t v = order[head];
+                neighbours.clear();
+
+                for (size_t p = graph.offsets[v]; p < graph.offsets[v + 1]; p++)
+                {
+                    if (!placed[graph.neighbours[p]])
+                    {
+                        placed[graph.neighbours[p]] = true;
+                        neighbours.push_back(graph.neighbours[p]);
+                    }
+                }
+
+                std::sort(neighbours.begin(), neighbours.end(), [&](size_t a, size_t b) { return graph.Degree(a) < graph.Degree(b); });
+                order.insert(order.end(), neighbours.begin(), neighbours.end());
+            }
+        }
+
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+
+    // Approximate minimum degree ordering, which reduces the fill of sparse Cholesky factors
+
+    template <typename Type>
+    std::vector<size_t> MinimumDegreeOrdering(const SparseMatrix<Type> &mat)
+    { return Detail::MinimumDegree(Detail::SymmetricGraph(mat)); }
+
+    // Nested dissection ordering
+    //
+    // Splits the graph with a vertex separator taken from the middle level of a breadth-first
+    // level structure, orders both halves recursively and the separator last. Parts of at most
+    // leafSize vertices are ordered by minimum degree. A single vertex cannot be split, so a leaf
+    // size of zero is taken as one.
+
+    template <typename Type>
+    std::vector<size_t> NestedDissection(const SparseMatrix<Type> &mat, size_t leafSize = Detail::NestedDissectionLeaf)
+    {
+        leafSize = std::max<size_t>(leafSize, 1);
+
+        const Detail::OrderingGraph graph = Detail::SymmetricGraph(mat);
+        const size_t n = graph.Size();
+
+        std::vector<size_t> order(n);
+        std::vector<size_t> active(n, 0), level(n), visited(n, 0), local(n);
+        size_t visit = 0;
+        size_t stamp = 0;
+
+        // Each part is a set of vertices that fills positions [begin, begin + size) of the order
+
+        struct Part
+        {
+            std::vector<size_t> vertices;
+            size_t begin;
+        };
+
+        std::vector<Part> stack;
+        std::vector<size_t> all(n);
+
+        for (size_t v = 0; v < n; v++)
+            all[v] = v;
+
+        stack.push_back({ std::move(all), 0 });
+
+        while (!stack.empty())
+        {
+            Part part = std::move(stack.back());
+            stack.pop_back();
+
+            const std::vector<size_t> &vertices = part.vertices;
+
+            if (vertices.empty())
+                continue;
+
+            stamp++;
+
+            for (size_t v : vertices)
+                active[v] = stamp;
+
+            if (vertices.size() <= leafSize)
+            {
+                // Minimum degree on the induced subgraph
+
+                Detail::OrderingGraph sub;
+                sub.offsets.assign(1, 0);
+
+                for (size_t i = 0; i < vertices.size(); i++)
+                    local[vertices[i]] = i;
+
+                for (size_t v : vertices)
+                {
+                    for (size_t p = graph.offsets[v]; p < graph.offsets[v + 1]; p++)
+                    {
+                        if (active[graph.neighbours[p]] == stamp)
+                            sub.neighbours.push_back(local[graph.neighbours[p]]);
+                    }
+
+                    sub.offsets.push_back(sub.neighbours.size());
+                }
+
+                std::vector<size_t> subOrder = Detail::MinimumDegree(sub);
+
+                for (size_t i = 0; i < subOrder.size(); i++)
+                    order[part.begin + i] = vertices[subOrder[i]];
+                continue;
+            }
+
+            const size_t root = Detail::PseudoPeripheral(graph, vertices[0], active, stamp, level, visited, visit);
+            std::vector<size_t> reached = Detail::LevelStructure(graph, root, active, stamp, level, visited, ++visit);
+
+            if (reached.size() < vertices.size())
+            {
+                // Disconnected: the reached component and the rest are independent
+
+                std::vector<size_t> rest;
+                rest.reserve(vertices.size() - reached.size());
+
+                for (size_t v : vertices)
+                {
+                    if (visited[v] != visit)
+                        rest.push_back(v);
+                }
+
+                const size_t begin = part.begin;
+                const size_t reachedSize = reached.size();
+                stack.push_back({ std::move(reached), begin });
+                stack.push_back({ std::move(rest), begin + reachedSize });
+                continue;
+            }
+
+            // Separator: the level where the visiting order passes half of the vertices, short of
+            // the last level. Separator vertices without neighbours in the next level move to the
+            // first half.
+
+            const size_t middle = std::min(level[reached[reached.size() / 2]], level[reached.back()] - 1);
+            std::vector<size_t> first, second, separator;
+
+            for (size_t v : reached)
+            {
+                if (level[v] < middle)
+                {
+                    first.push_back(v);
+                }
+                else if (level[v] > middle)
+                {
+                    second.push_back(v);
+                }
+                else
+                {
+                    bool touchesSecond = false;
+
+                    for (size_t p = graph.offsets[v]; p < graph.offsets[v + 1] && !touchesSecond; p++)
+                    {
+                        const size_t w = graph.neighbours[p];
+                        touchesSecond = active[w] == stamp && level[w] == middle + 1;
+                    }
+
+                    if (touchesSecond)
+                        separator.push_back(v);
+                    else
+                        first.push_back(v);
+                }
+            }
+
+            const size_t separatorBegin = part.begin + first.size() + second.size();
+
+            for (size_t i = 0; i < separator.size(); i++)
+                order[separatorBegin + i] = separator[i];
+
+            const size_t begin = part.begin;
+            const size_t firstSize = first.size();
+            stack.push_back({ std::move(first), begin });
+            stack.push_back({ std::move(second), begin + firstSize });
+        }
+
+        return order;
+    }
+
+    // Permutations
+
+    inline std::vector<size_t> InvertPermutation(const std::vector<size_t> &permutation)
+    {
+        std::vector<size_t> inverse(permutation.size());
+
+        for (size_t i = 0; i < permutation.size(); i++)
+            inverse[permutation[i]] = i;
+
+        return inverse;
+    }
+
+    // Returns y with y[i] = x[permutation[i]]
+
+    template <typename Type>
+    std::vector<Type> Permute(const std::vector<Type> &x, const std::vector<size_t> &permutation)
+    {
+        if (x.size() != permutation.size())
+            throw std::runtime_error("Permute: permutation size mismatch.");
+
+        std::vector<Type> y(x.size());
+
+        for (size_t i = 0; i < permutation.size(); i++)
+            y[i] = x[permutation[i]];
+
+        return y;
+    }
+
+    // Returns y with y[permutation[i]] = x[i], undoing Permute
+
+    template <typename Type>
+    std::vector<Type> InversePermute(const std::vector<Type> &x, const std::vector<size_t> &permutation)
+    {
+        if (x.size() != permutation.size())
+            throw std::runtime_error("InversePermute: permutation size mismatch.");
+
+        std::vector<Type> y(x.size());
+
+        for (size_t i = 0; i < permutation.size(); i++)
+            y[permutation[i]] = x[i];
+
+        return y;
+    }
+
+    // Returns B with B(i, j) = A(rowPermutation[i], colPermutation[j])
+
+    template <typename Type>
+    SparseMatrix<Type> Permute(const SparseMatrix<Type> &mat, const std::vector<size_t> &rowPermutation, const std::vector<size_t> &colPermutation)
+    {
+        if (rowPermutation.size() != mat.rows || colPermutation.size() != mat.cols)
+            throw std::runtime_error("Permute: permutation size mismatch.");
+
+        const std::vector<size_t> inverseRows = InvertPermutation(rowPermutation);
+        SparseMatrix<Type> newMat(mat.rows, mat.cols);
+
+        newMat.rowIndices.reserve(mat.NonZeroCount());
+        newMat.values.reserve(mat.NonZeroCount());
+
+        std::vector<std::pair<size_t, Type>> column;
+
+        for (size_t col = 0; col < mat.cols; col++)
+        {
+            const size_t source = colPermutation[col];
+            column.clear();
+
+            for (size_t i = mat.colOffsets[source]; i < mat.colOffsets[source + 1]; i++)
+                column.emplace_back(inverseRows[mat.rowIndices[i]], mat.values[i]);
+
+            std::sort(column.begin(), column.end(), [](const std::pair<size_t, Type> &a, const std::pair<size_t, Type> &b) { return a.first < b.first; });
+
+            for (const std::pair<size_t, Type> &entry : column)
+            {
+                newMat.rowIndices.push_back(entry.first);
+                newMat.values.push_back(entry.second);
+            }
+
+            newMat.colOffsets[col + 1] = newMat.rowIndices.size();
+        }
+
+        return newMat;
+    }
+
+    template <typename Type>
+    SparseMatrix<Type> PermuteSymmetric(const SparseMatrix<Type> &mat, const std::vector<size_t> &permutation)
+    { return Permute(mat, permutation, permutation); }
+
+    // Largest distance of a stored element from the diagonal
+
+    template <typename Type>
+    size_t Bandwidth(const SparseMatrix<Type> &mat)
+    {
+        size_t bandwidth = 0;
+
+        for (size_t col = 0; col < mat.cols; col++)
+        {
+            for (size_t i = mat.colOffsets[col]; i < mat.colOffsets[col + 1]; i++)
+            {
+                const size_t row = mat.rowIndices[i];
+                bandwidth = std::max(bandwidth, row > col ? row - col : col - row);
+            }
+        }
+
+        return bandwidth;
+    }
+}
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <Math/Matrix.hpp>
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace Scoop::Math
+{
+    // Pre-packed matrix
+    //
+    // Stores the left operand of a product in the order the GEMM micro-kernel reads it: slivers of
+    // GemmMR rows, each stored column by column over the whole inner dimension, so any block of
+    // GemmKC columns of a sliver is one contiguous panel. The matrix is packed once, and repeated
+    // products with it (such as weights applied to a new input on every call) only pack the
+    // right-hand side. With an integer StorageType the elements are also quantized symmetrically,
+    // with one scale per row, and each panel is converted back just before the kernel reads it.
+
+    // As in the GEMM micro-kernel, lane loops are kept rolled so they are vectorized across lanes
+
+    #if defined(__clang__)
+        #define __PACKED_LANE_LOOP _Pragma("clang loop unroll(disable)")
+    #elif defined(__GNUC__)
+        #define __PACKED_LANE_LOOP _Pragma("GCC unroll 1")
+    #else
+        #define __PACKED_LANE_LOOP
+    #endif
+
+    namespace Detail
+    {
+        // One sliver of y = A x for a single column x, from a packed sliver a of inner columns. Four
+        // accumulators take alternate columns of A, so consecutive multiply-adds are independent.
+
+        template <typename Type>
+        void PackedVectorKernel(size_t inner, const Type *a, const Type *x, Type *y, size_t mr)
+        {
+            constexpr size_t MR = GemmMR<Type>;
+            Type acc[4][MR];
+            const size_t unrolled = inner - inner % 4;
+            size_t m = 0;
+
+            for (size_t u = 0; u < 4; u++)
+            {
+                for (size_t i = 0; i < MR; i++)
+                    acc[u][i] = Type(0);
+            }
+
+            for (; m < unrolled; m += 4)
+            {
+                for (size_t u = 0; u < 4; u++)
+                {
+                    const Type scale = x[m + u];
+                    const Type *aCol = a + (m + u) * MR;
+
+                    __PACKED_LANE_LOOP
+                    for (size_t i = 0; i < MR; i++)
+                        acc[u][i] += aCol[i] * scale;
+                }
+            }
+
+            for (; m < inner; m++)
+            {
+                const Type scale = x[m];
+                const Type *aCol = a + m * MR;
+
+                __PACKED_LANE_LOOP
+                for (size_t i = 0; i < MR; i++)
+                    acc[0][i] += aCol[i] * scale;
+            }
+
+            for (size_t i = 0; i < mr; i++)
+                y[i] = (acc[0][i] + acc[1][i]) + (acc[2][i] + acc[3][i]);
+        }
+    }
+
+    template <typename Type, size_t Rows, size_t Cols, typename StorageType = Type> class PackedMatrix
+    {
+        static_assert(std::is_same<StorageType, Type>::value || (std::is_integral<StorageType>::value && std::is_signed<StorageType>::value
+            && std::is_floating_point<Type>::value), "PackedMatrix: StorageType must be Type, or a signed integer type for floating-point Type.");
+
+        // The largest integer must be exact in Type, or clamping to it could round past the
+        // range of StorageType before the conversion
+
+        static_assert(std::is_same<StorageType, Type>::value || std::numeric_limits<StorageType>::digits < std::numeric_limits<Type>::digits,
+            "PackedMatrix: StorageType must have fewer value bits than the mantissa of Type.");
+
+        static constexpr size_t MR = Detail::GemmMR<Type>;
+        static constexpr size_t PaddedRows = (Rows + MR - 1) / MR * MR;
+
+        public:
+
+        // True when elements are stored as scaled integers
+
+        static constexpr bool Quantized = !std::is_same<StorageType, Type>::value;
+
+        // Constructors
+
+        explicit PackedMatrix(const Matrix<Type, Rows, Cols> &mat)
+            : PackedMatrix(mat.data, Rows)
+        { }
+
+        // Packs a column-major matrix with leading dimension lda
+
+        PackedMatrix(const Type *a, size_t lda)
+            : packed(PaddedRows * Cols, StorageType(0))
+        {
+            if constexpr (Quantized)
+            {
+                // One scale per row, mapping the largest magnitude of the row to the largest integer
+
+                const Type largest = Type(std::numeric_limits<StorageType>::max());
+                this->scales.assign(PaddedRows, Type(0));
+
+                for (size_t col = 0; col < Cols; col++)
+                {
+                    for (size_t row = 0; row < Rows; row++)
+                        this->scales[row] = std::max(this->scales[row], std::abs(a[col * lda + row]));
+                }
+
+                for (size_t row = 0; row < PaddedRows; row++)
+                    this->scales[row] = this->scales[row] > Type(0) ? this->scales[row] / largest : Type(1);
+            }
+
+            for (size_t row = 0; row < Rows; row += MR)
+            {
+                const size_t mr = std::min(MR, Rows - row);
+                StorageType *sliver = this->packed.data() + row * Cols;
+
+                for (size_t col = 0; col < Cols; col++)
+                {
+                    for (size_t i = 0; i < mr; i++)
+                        sliver[col * MR + i] = this->Store(a[col * lda + row + i], row + i);
+                }
+            }
+        }
+
+        // Unpacking, to the stored (for quantized matrices, rounded) values
+
+        Matrix<Type, Rows, Cols> Unpack() const
+        {
+            Matrix<Type, Rows, Cols> newMat;
+
+            for (size_t col = 0; col < Cols; col++)
+            {
+                for (size_t row = 0; row < Rows; row++)
+                {
+                    Type value = Type(this->packed[(row - row % MR) * Cols + col * MR + row % MR]);
+
+                    if constexpr (Quantized)
+                        value *= this->scales[row];
+
+                    newMat.data[col * Rows + row] = value;
+                }
+            }
+
+            return newMat;
+        }
+
+        // Product with count column-major right-hand sides, Y = A X. Only X is packed, and rows of
+        // A are split between threads, so small batches of inputs still use every thread. Fewer
+        // columns than the micro-kernel tile are multiplied one at a time, without packing.
+
+        void Multiply(const Type *x, size_t ldx, Type *y, size_t ldy, size_t count) const
+        {
+            const size_t slivers = PaddedRows / MR;
+            const size_t minSlivers = std::max<size_t>(1, Detail::GemmParallelSize / std::max<size_t>(1, MR * Cols * count));
+
+            ParallelFor(0, slivers, minSlivers, [&](size_t begin, size_t end)
+            {
+                if (count < Detail::GemmNR)
+                    this->MultiplyNarrow(begin, end, x, ldx, y, ldy, count);
+                else
+                    this->MultiplyBlocked(begin, end, x, ldx, y, ldy, count);
+            });
+        }
+
+        std::vector<Type> Multiply(const std::vector<Type> &x) const
+        {
+            if (x.size() != Cols)
+                throw std::runtime_error("PackedMatrix::Multiply: vector size mismatch.");
+
+            std::vector<Type> y(Rows);
+            this->Multiply(x.data(), Cols, y.data(), Rows, 1);
+            return y;
+        }
+
+        Vector<Type, Rows> Multiply(const Vector<Type, Cols> &vec) const
+        {
+            Vector<Type, Rows> newVec;
+            this->Multiply(vec.data, Cols, newVec.data, Rows, 1);
+            return newVec;
+        }
+
+        template <size_t Count> Matrix<Type, Rows, Count> Multiply(const Matrix<Type, Cols, Count> &mat) const
+        {
+            Matrix<Type, Rows, Count> newMat;
+            this->Multiply(mat.data, Cols, newMat.data, Rows, Count);
+            return newMat;
+        }
+
+        // Multiplication operators
+
+        inline Vector<Type, Rows> operator*(const Vector<Type, Cols> &vec) const { return this->Multiply(vec); }
+        template <size_t Count> inline Matrix<Type, Rows, Count> operator*(const Matrix<Type, Cols, Count> &mat) const { return this->Multiply(mat); }
+
+        private:
+
+        std::vector<StorageType> packed;
+        std::vector<Type> scales;
+
+        StorageType Store(Type value, size_t row) const
+        {
+            if constexpr (Quantized)
+            {
+                const Type largest = Type(std::numeric_limits<StorageType>::max());
+                return StorageType(std::max(-largest, std::min(largest, std::round(value / this->scales[row]))));
+            }
+            else
+            {
+                return value;
+            }
+        }
+
+        // Columns [col, col + kc) of a sliver as a panel of Type, converted into buffer when quantized
+
+        const Type *Panel(size_t sliver, size_t col, size_t kc, Type *buffer) const
+        {
+            const StorageType *panel = this->packed.data() + sliver * MR * Cols + col * MR;
+
+            if constexpr (Quantized)
+            {
+                const Type *scale = this->scales.data() + sliver * MR;
+
+                for (size_t m = 0; m < kc; m++)
+                {
+                    __PACKED_LANE_LOOP
+                    for (size_t i = 0; i < MR; i++)
+                        buffer[m * MR + i] = Type(panel[m * MR + i]) * scale[i];
+                }
+
+                return buffer;
+            }
+            else
+            {
+                return panel;
+            }
+        }
+
+        void MultiplyNarrow(size_t begin, size_t end, const Type *x, size_t ldx, Type *y, size_t ldy, size_t count) const
+        {
+            std::vector<Type> buffer(Quantized ? MR * Cols : 0);
+
+            for (size_t sliver = begin; sliver < end; sliver++)
+            {
+                const size_t row = sliver * MR;
+                const Type *panel = this->Panel(sliver, 0, Cols, buffer.data());
+
+                for (size_t col = 0; col < count; col++)
+                    Detail::PackedVectorKernel(Cols, panel, x + col * ldx, y + col * ldy + row, std::min(MR, Rows - row));
+            }
+        }
+
+        // Blocked product over the slivers [begin, end), with the loop order of the GEMM kernel
+
+        void MultiplyBlocked(size_t begin, size_t end, const Type *x, size_t ldx, Type *y, size_t ldy, size_t count) const
+        {
+            constexpr size_t BlockSlivers = std::max<size_t>(1, Detail::GemmMC / MR);
+            std::vector<Type> packedX(Detail::GemmKC * (Detail::GemmNC + Detail::GemmNR));
+            std::vector<Type> buffer(Quantized ? BlockSlivers * MR * Detail::GemmKC : 0);
+            const Type *panels[BlockSlivers];
+
+            for (size_t jc = 0; jc < count; jc += Detail::GemmNC)
+            {
+                const size_t nc = std::min(Detail::GemmNC, count - jc);
+
+                for (size_t pc = 0; pc < Cols; pc += Detail::GemmKC)
+                {
+                    const size_t kc = std::min(Detail::GemmKC, Cols - pc);
+
+                    Detail::GemmPackB<PlusTimes>(kc, nc, x + jc * ldx + pc, ldx, packedX.data());
+
+                    for (size_t ic = begin; ic < end; ic += BlockSlivers)
+                    {
+                        const size_t icEnd = std::min(end, ic + BlockSlivers);
+
+                        for (size_t sliver = ic; sliver < icEnd; sliver++)
+                            panels[sliver - ic] = this->Panel(sliver, pc, kc, buffer.data() + (sliver - ic) * MR * kc);
+
+                        for (size_t jr = 0; jr < nc; jr += Detail::GemmNR)
+                        {
+                            for (size_t sliver = ic; sliver < icEnd; sliver++)
+                            {
+                                const size_t row = sliver * MR;
+
+                                Detail::GemmMicroKernel<PlusTimes>(kc, Type(1), panels[sliver - ic], packedX.data() + jr * kc, Type(1),
+                                    y + (jc + jr) * ldy + row, ldy, std::min(MR, Rows - row), std::min(Detail::GemmNR, nc - jr), pc > 0);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    #undef __PACKED_LANE_LOOP
+}
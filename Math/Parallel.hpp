@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Scoop::Math
+{
+    // Number of worker threads used by the parallel kernels
+
+    inline size_t ThreadCount()
+    {
+        static const size_t count = std::max<size_t>(1, std::thread::hardware_concurrency());
+        return count;
+    }
+
+    namespace Detail
+    {
+        // Persistent workers shared by every ParallelFor, started on first use, so a parallel loop
+        // costs a queue push and a wake-up per chunk instead of a thread start and join
+
+        class ThreadPool
+        {
+            public:
+
+            static ThreadPool &Instance()
+            {
+                static ThreadPool pool(ThreadCount() - 1);
+                return pool;
+            }
+
+            void Submit(std::function<void()> task)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    this->tasks.push_back(std::move(task));
+                }
+
+                this->wake.notify_one();
+            }
+
+            ~ThreadPool()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(this->mutex);
+                    this->stopping = true;
+                }
+
+                this->wake.notify_all();
+
+                for (std::thread &worker : this->workers)
+                    worker.join();
+            }
+
+            private:
+
+            std::vector<std::thread> workers;
+            std::deque<std::function<void()>> tasks;
+            std::mutex mutex;
+            std::condition_variable wake;
+            bool stopping = false;
+
+            explicit ThreadPool(size_t count)
+            {
+                this->workers.reserve(count);
+
+                for (size_t i = 0; i < count; i++)
+                    this->workers.emplace_back([this] { this->Work(); });
+            }
+
+            void Work()
+            {
+                for (;;)
+                {
+                    std::function<void()> task;
+
+                    {
+                        std::unique_lock<std::mutex> lock(this->mutex);
+                        this->wake.wait(lock, [this] { return this->stopping || !this->tasks.empty(); });
+
+                        if (this->tasks.empty())
+                            return;
+
+                        task = std::move(this->tasks.front());
+                        this->tasks.pop_front();
+                    }
+
+                    task();
+                }
+            }
+        };
+
+        // Set while a thread runs a chunk of a parallel loop. Nested loops then run inline, so
+        // workers never wait on their own queue and kernels called from a chunk do not oversubscribe.
+
+        inline thread_local bool InParallelLoop = false;
+    }
+
+    // Splits [begin, end) into contiguous chunks of at least minChunk indices and calls
+    // function(chunkBegin, chunkEnd) for each chunk, one chunk per thread. The calling
+    // thread processes the first chunk. Exceptions thrown by a chunk are rethrown here.
+
+    template <typename Function>
+    void ParallelFor(size_t begin, size_t end, size_t minChunk, const Function &function)
+    {
+        if (end <= begin)
+            return;
+
+        size_t count = end - begin;
+        size_t chunks = std::min(ThreadCount(), count / std::max<size_t>(minChunk, 1));
+
+        if (chunks <= 1 || Detail::InParallelLoop)
+        {
+            function(begin, end);
+            return;
+        }
+
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining = chunks - 1;
+
+        auto run = [&](size_t chunkBegin, size_t chunkEnd)
+        {
+            Detail::InParallelLoop = true;
+
+            try
+            {
+                function(chunkBegin, chunkEnd);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+
+            Detail::InParallelLoop = false;
+        };
+
+        for (size_t chunk = 1; chunk < chunks; chunk++)
+        {
+            const size_t chunkBegin = begin + count * chunk / chunks;
+            const size_t chunkEnd = begin + count * (chunk + 1) / chunks;
+
+            Detail::ThreadPool::Instance().Submit([&, chunkBegin, chunkEnd]
+            {
+                run(chunkBegin, chunkEnd);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--remaining == 0)
+                    done.notify_one();
+            });
+        }
+
+        run(begin, begin + count / chunks);
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [&] { return remaining == 0; });
+        }
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+}
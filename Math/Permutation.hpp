@@ -0,0 +1,448 @@
+#pragma once
+
+#include <Math/Matrix.hpp>
+
+namespace Scoop::Math
+{
+    // Permutation kernels
+    //
+    // A permutation P is stored as an index array where index[i] is the row of the operand that
+    // becomes row i of the result, (P x)[i] = x[index[i]], the convention of the sparse orderings.
+    // It is applied by moving elements, never by multiplying with a dense 0/1 matrix.
+
+    namespace Detail
+    {
+        // Returns false unless index holds each of 0 to n - 1 exactly once
+
+        inline bool IsPermutation(size_t n, const size_t *index)
+        {
+            std::vector<char> seen(n, 0);
+
+            for (size_t i = 0; i < n; i++)
+            {
+                if (index[i] >= n || seen[index[i]])
+                    return false;
+                seen[index[i]] = 1;
+            }
+
+            return true;
+        }
+
+        // Applies the swaps row k <-> pivots[k] of a pivoted factorization to the identity
+
+        inline void PivotsToPermutation(size_t n, const size_t *pivots, size_t *index)
+        {
+            for (size_t i = 0; i < n; i++)
+                index[i] = i;
+
+            for (size_t k = 0; k < n; k++)
+            {
+                if (pivots[k] >= n)
+                    throw std::runtime_error("Permutation: pivot out of range.");
+                std::swap(index[k], index[pivots[k]]);
+            }
+        }
+
+        // (-1) to the number of transpositions, n minus the number of cycles
+
+        inline int PermutationSign(size_t n, const size_t *index)
+        {
+            std::vector<char> visited(n, 0);
+            size_t parity = 0;
+
+            for (size_t start = 0; start < n; start++)
+            {
+                if (visited[start])
+                    continue;
+
+                for (size_t j = start; !visited[j]; j = index[j])
+                {
+                    visited[j] = 1;
+                    parity++;
+                }
+
+                parity--;
+            }
+
+            return parity % 2 == 0 ? 1 : -1;
+        }
+
+        // Moves block index[j] to block j in place, for n blocks of size elements stride apart.
+        // Each cycle is followed once with one block of scratch, so every block is moved once.
+
+        template <typename Type>
+        void PermuteBlocksInPlace(size_t n, const size_t *index, Type *data, size_t size, size_t stride)
+        {
+            std::vector<char> visited(n, 0);
+            std::vector<Type> saved(size);
+
+            for (size_t start = 0; start < n; start++)
+            {
+                if (visited[start])
+                    continue;
+
+                visited[start] = 1;
+
+                if (index[start] == start)
+                    continue;
+
+                std::copy(data + start * stride, data + start * stride + size, saved.begin());
+
+                size_t j = start;
+
+                while (index[j] != start)
+                {
+                    std::copy(data + index[j] * stride, data + index[j] * stride + size, data + j * stride);
+                    j = index[j];
+                    visited[j] = 1;
+                }
+
+                std::copy(saved.begin(), saved.end(), data + j * stride);
+            }
+        }
+
+        // dst(i, col) = src(index[i], col). Each column is an indexed load the compiler can turn
+        // into SIMD gathers, and columns are split between threads.
+
+        template <typename Type>
+        void GatherRows(size_t rows, size_t cols, const size_t *index, const Type *src, size_t lds, Type *dst, size_t ldd)
+        {
+            ParallelFor(0, cols, std::max<size_t>(1, 16384 / std::max<size_t>(rows, 1)), [&](size_t colBegin, size_t colEnd)
+            {
+                for (size_t col = colBegin; col < colEnd; col++)
+                {
+                    const Type *s = src + col * lds;
+                    Type *d = dst + col * ldd;
+
+                    for (size_t i = 0; i < rows; i++)
+                        d[i] = s[index[i]];
+                }
+            });
+        }
+
+        // Rows of a column-major matrix are strided, so instead of following cycles across
+        // columns each column is gathered into a per-thread buffer and copied back
+
+        template <typename Type>
+        void GatherRowsInPlace(size_t rows, size_t cols, const size_t *index, Type *data, size_t ld)
+        {
+            ParallelFor(0, cols, std::max<size_t>(1, 16384 / std::max<size_t>(rows, 1)), [&](size_t colBegin, size_t colEnd)
+            {
+                std::vector<Type> buffer(rows);
+
+                for (size_t col = colBegin; col < colEnd; col++)
+                {
+                    Type *column = data + col * ld;
+
+                    for (size_t i = 0; i < rows; i++)
+                        buffer[i] = column[index[i]];
+
+                    std::copy(buffer.begin(), buffer.end(), column);
+                }
+            });
+        }
+
+        // dst(:, j) = src(:, index[j]), contiguous column copies
+
+        template <typename Type>
+        void GatherCols(size_t rows, size_t cols, const size_t *index, const Type *src, size_t lds, Type *dst, size_t ldd)
+        {
+            ParallelFor(0, cols, std::max<size_t>(1, 16384 / std::max<size_t>(rows, 1)), [&](size_t colBegin, size_t colEnd)
+            {
+                for (size_t col = colBegin; col < colEnd; col++)
+                    std::copy(src + index[col] * lds, src + index[col] * lds + rows, dst + col * ldd);
+            });
+        }
+    }
+
+    // Permutation of fixed size
+    //
+    // P x gathers x[index[i]] into element i. Applied to a matrix, PermuteRows gives P A and
+    // PermuteCols gives the matrix with column j taken from column index[j] of A, A Pᵀ.
+
+    template <size_t Size> class Permutation
+    {
+        public:
+
+        // Index array, index[i] is the source of element i
+
+        size_t index[Size];
+
+        // Constructors
+
+        Permutation()
+        {
+            for (size_t i = 0; i < Size; i++)
+                this->index[i] = i;
+        }
+
+        explicit Permutation(const std::vector<size_t> &index)
+        {
+            if (index.size() != Size || !Detail::IsPermutation(Size, index.data()))
+                throw std::runtime_error("Permutation: index array is not a permutation.");
+
+            std::copy(index.begin(), index.end(), this->index);
+        }
+
+        // Permutation P with P A = L U from the row swaps of a pivoted LU factorization
+
+        static Permutation<Size> FromPivots(const size_t (&pivots)[Size])
+        {
+            Permutation<Size> newPerm;
+            Detail::PivotsToPermutation(Size, pivots, newPerm.index);
+            return newPerm;
+        }
+
+        // Swap of elements i and j
+
+        static Permutation<Size> Transposition(size_t i, size_t j)
+        {
+            if (i >= Size || j >= Size)
+                throw std::runtime_error("Permutation::Transposition: index out of range.");
+
+            Permutation<Size> newPerm;
+            std::swap(newPerm.index[i], newPerm.index[j]);
+            return newPerm;
+        }
+
+        // Composition and inverse. Compose returns P Q, which applies Q first.
+
+        Permutation<Size> Compose(const Permutation<Size> &perm) const
+        {
+            Permutation<Size> newPerm;
+
+            for (size_t i = 0; i < Size; i++)
+                newPerm.index[i] = perm.index[this->index[i]];
+
+            return newPerm;
+        }
+
+        Permutation<Size> Inverse() const
+        {
+            Permutation<Size> newPerm;
+
+            for (size_t i = 0; i < Size; i++)
+                newPerm.index[this->index[i]] = i;
+
+            return newPerm;
+        }
+
+        int Sign() const
+        { return Detail::PermutationSign(Size, this->index); }
+
+        bool IsIdentity() const
+        {
+            for (size_t i = 0; i < Size; i++)
+            {
+                if (this->index[i] != i)
+                    return false;
+            }
+
+            return true;
+        }
+
+        // Application to vectors
+
+        template <typename Type> Vector<Type, Size> Apply(const Vector<Type, Size> &vec) const
+        {
+            Vector<Type, Size> newVec;
+
+            for (size_t i = 0; i < Size; i++)
+                newVec.data[i] = vec.data[this->index[i]];
+
+            return newVec;
+        }
+
+        template <typename Type> void ApplyInPlace(Vector<Type, Size> &vec) const
+        { Detail::PermuteBlocksInPlace(Size, this->index, vec.data, 1, 1); }
+
+        // Application to matrices
+
+        template <typename Type, size_t Cols> Matrix<Type, Size, Cols> PermuteRows(const Matrix<Type, Size, Cols> &mat) const
+        {
+            Matrix<Type, Size, Cols> newMat;
+            Detail::GatherRows(Size, Cols, this->index, mat.data, Size, newMat.data, Size);
+            return newMat;
+        }
+
+        template <typename Type, size_t Cols> void PermuteRowsInPlace(Matrix<Type, Size, Cols> &mat) const
+        { Detail::GatherRowsInPlace(Size, Cols, this->index, mat.data, Size); }
+
+        template <typename Type, size_t Rows> Matrix<Type, Rows, Size> PermuteCols(const Matrix<Type, Rows, Size> &mat) const
+        {
+            Matrix<Type, Rows, Size> newMat;
+            Detail::GatherCols(Rows, Size, this->index, mat.data, Rows, newMat.data, Rows);
+            return newMat;
+        }
+
+        template <typename Type, size_t Rows> void PermuteColsInPlace(Matrix<Type, Rows, Size> &mat) const
+        { Detail::PermuteBlocksInPlace(Size, this->index, mat.data, Rows, Rows); }
+    };
+
+    // Permutation of runtime size, with the same conventions as Permutation. Index arrays from
+    // the sparse orderings can be used directly.
+
+    class DynamicPermutation
+    {
+        public:
+
+        // Index array, index[i] is the source of element i
+
+        std::vector<size_t> index;
+
+        // Constructors
+
+        DynamicPermutation() = default;
+
+        explicit DynamicPermutation(size_t size)
+            : index(size)
+        {
+            for (size_t i = 0; i < size; i++)
+                this->index[i] = i;
+        }
+
+        explicit DynamicPermutation(const std::vector<size_t> &index)
+            : index(index)
+        {
+            if (!Detail::IsPermutation(index.size(), index.data()))
+                throw std::runtime_error("DynamicPermutation: index array is not a permutation.");
+        }
+
+        template <size_t Size>
+        explicit DynamicPermutation(const Permutation<Size> &perm)
+            : index(perm.index, perm.index + Size)
+        { }
+
+        static DynamicPermutation FromPivots(const std::vector<size_t> &pivots)
+        {
+            DynamicPermutation newPerm(pivots.size());
+            Detail::PivotsToPermutation(pivots.size(), pivots.data(), newPerm.index.data());
+            return newPerm;
+        }
+
+        size_t Size() const
+        { return this->index.size(); }
+
+        // Composition and inverse. Compose returns P Q, which applies Q first.
+
+        DynamicPermutation Compose(const DynamicPermutation &perm) const
+        {
+            if (perm.Size() != this->Size())
+                throw std::runtime_error("DynamicPermutation::Compose: size mismatch.");
+
+            DynamicPermutation newPerm(this->Size());
+
+            for (size_t i = 0; i < this->Size(); i++)
+                newPerm.index[i] = perm.index[this->index[i]];
+
+            return newPerm;
+        }
+
+        DynamicPermutation Inverse() const
+        {
+            DynamicPermutation newPerm(this->Size());
+
+            for (size_t i = 0; i < this->Size(); i++)
+                newPerm.index[this->index[i]] = i;
+
+            return newPerm;
+        }
+
+        int Sign() const
+        { return Detail::PermutationSign(this->Size(), this->index.data()); }
+
+        // Application to vectors
+
+        template <typename Type> std::vector<Type> Apply(const std::vector<Type> &x) const
+        {
+            if (x.size() != this->Size())
+                throw std::runtime_error("DynamicPermutation::Apply: vector size mismatch.");
+
+            std::vector<Type> y(x.size());
+
+            for (size_t i = 0; i < x.size(); i++)
+                y[i] = x[this->index[i]];
+
+            return y;
+        }
+
+        template <typename Type> void ApplyInPlace(std::vector<Type> &x) const
+        {
+            if (x.size() != this->Size())
+                throw std::runtime_error("DynamicPermutation::ApplyInPlace: vector size mismatch.");
+
+            Detail::PermuteBlocksInPlace(x.size(), this->index.data(), x.data(), 1, 1);
+        }
+
+        template <typename Type, size_t Size> Vector<Type, Size> Apply(const Vector<Type, Size> &vec) const
+        {
+            if (Size != this->Size())
+                throw std::runtime_error("DynamicPermutation::Apply: size mismatch.");
+
+            Vector<Type, Size> newVec;
+
+            for (size_t i = 0; i < Size; i++)
+                newVec.data[i] = vec.data[this->index[i]];
+
+            return newVec;
+        }
+
+        template <typename Type, size_t Size> void ApplyInPlace(Vector<Type, Size> &vec) const
+        {
+            if (Size != this->Size())
+                throw std::runtime_error("DynamicPermutation::ApplyInPlace: size mismatch.");
+
+            Detail::PermuteBlocksInPlace(Size, this->index.data(), vec.data, 1, 1);
+        }
+
+        // Application to column-major matrices of Size() rows or columns
+
+        template <typename Type> void PermuteRows(const Type *src, size_t lds, Type *dst, size_t ldd, size_t cols) const
+        { Detail::GatherRows(this->Size(), cols, this->index.data(), src, lds, dst, ldd); }
+
+        template <typename Type> void PermuteRowsInPlace(Type *data, size_t ld, size_t cols) const
+        { Detail::GatherRowsInPlace(this->Size(), cols, this->index.data(), data, ld); }
+
+        template <typename Type> void PermuteCols(const Type *src, size_t lds, Type *dst, size_t ldd, size_t rows) const
+        { Detail::GatherCols(rows, this->Size(), this->index.data(), src, lds, dst, ldd); }
+
+        template <typename Type> void PermuteColsInPlace(Type *data, size_t ld, size_t rows) const
+        { Detail::PermuteBlocksInPlace(this->Size(), this->index.data(), data, rows, ld); }
+
+        template <typename Type, size_t Rows, size_t Cols> Matrix<Type, Rows, Cols> PermuteRows(const Matrix<Type, Rows, Cols> &mat) const
+        {
+            if (Rows != this->Size())
+                throw std::runtime_error("DynamicPermutation::PermuteRows: size mismatch.");
+
+            Matrix<Type, Rows, Cols> newMat;
+            this->PermuteRows(mat.data, Rows, newMat.data, Rows, Cols);
+            return newMat;
+        }
+
+        template <typename Type, size_t Rows, size_t Cols> void PermuteRowsInPlace(Matrix<Type, Rows, Cols> &mat) const
+        {
+            if (Rows != this->Size())
+                throw std::runtime_error("DynamicPermutation::PermuteRowsInPlace: size mismatch.");
+
+            this->PermuteRowsInPlace(mat.data, Rows, Cols);
+        }
+
+        template <typename Type, size_t Rows, size_t Cols> Matrix<Type, Rows, Cols> PermuteCols(const Matrix<Type, Rows, Cols> &mat) const
+        {
+            if (Cols != this->Size())
+                throw std::runtime_error("DynamicPermutation::PermuteCols: size mismatch.");
+
+            Matrix<Type, Rows, Cols> newMat;
+            this->PermuteCols(mat.data, Rows, newMat.data, Rows, Rows);
+            return newMat;
+        }
+
+        template <typename Type, size_t Rows, size_t Cols> void PermuteColsInPlace(Matrix<Type, Rows, Cols> &mat) const
+        {
+            if (Cols != this->Size())
+                throw std::runtime_error("DynamicPermutation::PermuteColsInPlace: size mismatch.");
+
+            this->PermuteColsInPlace(mat.data, Rows, Rows);
+        }
+    };
+}
@@ -0,0 +1,392 @@
+#pragma once
+
+#include <Math/Parallel.hpp>
+
+#include <limits>
+#include <type_traits>
+
+namespace Scoop::Math
+{
+    // Semiring policies
+    //
+    // Each policy provides Zero (the identity of Add and annihilator of Multiply), One (the
+    // identity of Multiply), Add and Multiply. The operations are written branch-free so the
+    // compiler can vectorize the GEMM micro-kernel for each of them.
+
+    namespace Detail
+    {
+        template <typename Type> inline Type SemiringInfinity()
+        {
+            if constexpr (std::numeric_limits<Type>::has_infinity)
+                return std::numeric_limits<Type>::infinity();
+            else
+                return std::numeric_limits<Type>::max();
+        }
+
+        template <typename Type> inline Type SemiringNegativeInfinity()
+        {
+            if constexpr (std::numeric_limits<Type>::has_infinity)
+                return -std::numeric_limits<Type>::infinity();
+            else
+                return std::numeric_limits<Type>::lowest();
+        }
+
+        // Integer types have no infinity, so adding to the saturated value must not wrap
+
+        template <typename Type> inline Type SaturatingAdd(Type a, Type b, Type saturated)
+        {
+            if constexpr (std::is_floating_point<Type>::value)
+                return a + b;
+            else
+                return (a == saturated || b == saturated) ? saturated : Type(a + b);
+        }
+    }
+
+    struct PlusTimes
+    {
+        template <typename Type> static inline Type Zero() { return Type(0); }
+        template <typename Type> static inline Type One() { return Type(1); }
+        template <typename Type> static inline Type Add(Type a, Type b) { return a + b; }
+        template <typename Type> static inline Type Multiply(Type a, Type b) { return a * b; }
+    };
+
+    struct MinPlus
+    {
+        template <typename Type> static inline Type Zero() { return Detail::SemiringInfinity<Type>(); }
+        template <typename Type> static inline Type One() { return Type(0); }
+        template <typename Type> static inline Type Add(Type a, Type b) { return b < a ? b : a; }
+        template <typename Type> static inline Type Multiply(Type a, Type b) { return Detail::SaturatingAdd(a, b, Zero<Type>()); }
+    };
+
+    struct MaxPlus
+    {
+        template <typename Type> static inline Type Zero() { return Detail::SemiringNegativeInfinity<Type>(); }
+        template <typename Type> static inline Type One() { return Type(0); }
+        template <typename Type> static inline Type Add(Type a, Type b) { return a < b ? b : a; }
+        template <typename Type> static inline Type Multiply(Type a, Type b) { return Detail::SaturatingAdd(a, b, Zero<Type>()); }
+    };
+
+    struct OrAnd
+    {
+        template <typename Type> static inline Type Zero() { return Type(0); }
+        template <typename Type> static inline Type One() { return Type(1); }
+        template <typename Type> static inline Type Add(Type a, Type b) { return Type((a != Type(0)) | (b != Type(0))); }
+        template <typename Type> static inline Type Multiply(Type a, Type b) { return Type((a != Type(0)) & (b != Type(0))); }
+    };
+
+    struct MaxMin
+    {
+        template <typename Type> static inline Type Zero() { return Detail::SemiringNegativeInfinity<Type>(); }
+        template <typename Type> static inline Type One() { return Detail::SemiringInfinity<Type>(); }
+        template <typename Type> static inline Type Add(Type a, Type b) { return a < b ? b : a; }
+        template <typename Type> static inline Type Multiply(Type a, Type b) { return b < a ? b : a; }
+    };
+
+    // Blocked GEMM kernel
+    //
+    // Computes C = A ⊗ B (or C = C ⊕ A ⊗ B when accumulate is set) for column-major operands
+    // with leading dimensions lda, ldb and ldc. Large products are packed into MR-row slivers
+    // of A and NR-column slivers of B sized to stay cache resident, and the columns of C are
+    // split between threads.
+    //
+    // The scaled form C = (α ⊗ A ⊗ B) ⊕ (β ⊗ C) applies α and β as each register tile is
+    // written back, so accumulating into C costs no extra pass over it. When β is the zero of the
+    // semiring, C is not read, as in BLAS.
+
+    // Fully unrolling the micro-kernel's lane loop before vectorization leaves GCC with
+    // scalar code, so the lane loops are kept rolled and vectorized instead
+
+    #if defined(__clang__)
+        #define __GEMM_LANE_LOOP _Pragma("clang loop unroll(disable)")
+    #elif defined(__GNUC__)
+        #define __GEMM_LANE_LOOP _Pragma("GCC unroll 1")
+    #else
+        #define __GEMM_LANE_LOOP
+    #endif
+
+    namespace Detail
+    {
+        template <typename Type> constexpr size_t GemmMR = std::max<size_t>(64 / sizeof(Type), 4);
+        constexpr size_t GemmNR = 6;
+        constexpr size_t GemmMC = 128;
+        constexpr size_t GemmKC = 256;
+        constexpr size_t GemmNC = 512;
+
+        constexpr size_t GemmSmallSize = 32 * 32 * 32;
+        constexpr size_t GemmParallelSize = 128 * 128 * 128;
+        constexpr size_t GemmSkinnyTile = 512;
+        constexpr size_t GemmSkinnyRows = 8192;
+
+        template <typename Semiring, typename Type>
+        void GemmSimple(size_t rows, size_t cols, size_t inner, Type alpha, const Type *a, size_t lda, const Type *b, size_t ldb,
+            Type beta, Type *c, size_t ldc, bool accumulate)
+        {
+            for (size_t col = 0; col < cols; col++)
+            {
+                Type *cCol = c + col * ldc;
+
+                if (!accumulate)
+                {
+                    for (size_t row = 0; row < rows; row++)
+                        cCol[row] = Semiring::template Zero<Type>();
+                }
+                else
+                {
+                    for (size_t row = 0; row < rows; row++)
+                        cCol[row] = Semiring::Multiply(beta, cCol[row]);
+                }
+
+                for (size_t m = 0; m < inner; m++)
+                {
+                    const Type scale = Semiring::Multiply(alpha, b[col * ldb + m]);
+                    const Type *aCol = a + m * lda;
+
+                    for (size_t row = 0; row < rows; row++)
+                        cCol[row] = Semiring::Add(cCol[row], Semiring::Multiply(aCol[row], scale));
+                }
+            }
+        }
+
+        template <typename Semiring, typename Type>
+        void GemmPackA(size_t rows, size_t inner, const Type *a, size_t lda, Type *packed)
+        {
+            for (size_t row = 0; row < rows; row += GemmMR<Type>)
+            {
+                size_t mr = std::min(GemmMR<Type>, rows - row);
+
+                for (size_t m = 0; m < inner; m++)
+                {
+                    const Type *src = a + m * lda + row;
+
+                    for (size_t i = 0; i < mr; i++)
+                        packed[i] = src[i];
+                    for (size_t i = mr; i < GemmMR<Type>; i++)
+                        packed[i] = Semiring::template Zero<Type>();
+
+                    packed += GemmMR<Type>;
+                }
+            }
+        }
+
+        template <typename Semiring, typename Type>
+        void GemmPackB(size_t inner, size_t cols, const Type *b, size_t ldb, Type *packed)
+        {
+            for (size_t col = 0; col < cols; col += GemmNR)
+            {
+                size_t nr = std::min(GemmNR, cols - col);
+
+                for (size_t m = 0; m < inner; m++)
+                {
+                    for (size_t j = 0; j < nr; j++)
+                        packed[j] = b[(col + j) * ldb + m];
+                    for (size_t j = nr; j < GemmNR; j++)
+                        packed[j] = Semiring::template Zero<Type>();
+
+                    packed += GemmNR;
+                }
+            }
+        }
+
+        template <typename Semiring, typename Type>
+        void GemmMicroKernel(size_t inner, Type alpha, const Type *a, const Type *b, Type beta, Type *c, size_t ldc, size_t mr, size_t nr, bool accumulate)
+        {
+            Type acc[GemmNR][GemmMR<Type>];
+
+            for (size_t j = 0; j < GemmNR; j++)
+            {
+                for (size_t i = 0; i < GemmMR<Type>; i++)
+                    acc[j][i] = Semiring::template Zero<Type>();
+            }
+
+            for (size_t m = 0; m < inner; m++)
+            {
+                for (size_t j = 0; j < GemmNR; j++)
+                {
+                    const Type scale = b[j];
+
+                    __GEMM_LANE_LOOP
+                    for (size_t i = 0; i < GemmMR<Type>; i++)
+                        acc[j][i] = Semiring::Add(acc[j][i], Semiring::Multiply(a[i], scale));
+                }
+
+                a += GemmMR<Type>;
+                b += GemmNR;
+            }
+
+            for (size_t j = 0; j < nr; j++)
+            {
+                Type *cCol = c + j * ldc;
+
+                if (accumulate)
+                {
+                    for (size_t i = 0; i < mr; i++)
+                        cCol[i] = Semiring::Add(Semiring::Multiply(beta, cCol[i]), Semiring::Multiply(alpha, acc[j][i]));
+                }
+                else
+                {
+                    for (size_t i = 0; i < mr; i++)
+                        cCol[i] = Semiring::Multiply(alpha, acc[j][i]);
+                }
+            }
+        }
+
+        template <typename Semiring, typename Type>
+        void GemmBlocked(size_t rows, size_t cols, size_t inner, Type alpha, const Type *a, size_t lda, const Type *b, size_t ldb,
+            Type beta, Type *c, size_t ldc, bool accumulate)
+        {
+            std::vector<Type> packedA(GemmMC * GemmKC);
+            std::vector<Type> packedB(GemmKC * (GemmNC + GemmNR));
+
+            for (size_t jc = 0; jc < cols; jc += GemmNC)
+            {
+                size_t nc = std::min(GemmNC, cols - jc);
+
+                for (size_t pc = 0; pc < inner; pc += GemmKC)
+                {
+                    size_t kc = std::min(GemmKC, inner - pc);
+                    bool accumulateBlock = accumulate || pc > 0;
+                    Type betaBlock = pc > 0 ? Semiring::template One<Type>() : beta;
+
+                    GemmPackB<Semiring>(kc, nc, b + jc * ldb + pc, ldb, packedB.data());
+
+                    for (size_t ic = 0; ic < rows; ic += GemmMC)
+                    {
+                        size_t mc = std::min(GemmMC, rows - ic);
+
+                        GemmPackA<Semiring>(mc, kc, a + pc * lda + ic, lda, packedA.data());
+
+                        for (size_t jr = 0; jr < nc; jr += GemmNR)
+                        {
+                            for (size_t ir = 0; ir < mc; ir += GemmMR<Type>)
+                            {
+                                GemmMicroKernel<Semiring>(kc, alpha, packedA.data() + ir * kc, packedB.data() + jr * kc,
+                                    betaBlock, c + (jc + jr) * ldc + ic + ir, ldc,
+                                    std::min(GemmMR<Type>, mc - ir), std::min(GemmNR, nc - jr), accumulateBlock);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        template <typename Semiring, typename Type>
+        void Gemm(size_t rows, size_t cols, size_t inner, Type alpha, const Type *a, size_t lda, const Type *b, size_t ldb,
+            Type beta, Type *c, size_t ldc)
+        {
+            size_t work = rows * cols * inner;
+            bool accumulate = !(beta == Semiring::template Zero<Type>());
+
+            if (work <= GemmSmallSize)
+            {
+                GemmSimple<Semiring>(rows, cols, inner, alpha, a, lda, b, ldb, beta, c, ldc, accumulate);
+                return;
+            }
+
+            // A few columns would leave most of the micro-kernel's register tile unused, so tiles of
+            // rows run the simple kernel instead, one block of the inner dimension at a time so the
+            // tile of a stays in cache for every column
+
+            if (cols < GemmNR)
+            {
+                ParallelFor(0, rows, GemmSkinnyRows, [&](size_t rowBegin, size_t rowEnd)
+                {
+                    for (size_t ic = rowBegin; ic < rowEnd; ic += GemmSkinnyTile)
+                    {
+                        size_t mc = std::min(GemmSkinnyTile, rowEnd - ic);
+
+                        for (size_t pc = 0; pc < inner; pc += GemmKC)
+                        {
+                            GemmSimple<Semiring>(mc, cols, std::min(GemmKC, inner - pc), alpha, a + pc * lda + ic, lda, b + pc, ldb,
+                                pc > 0 ? Semiring::template One<Type>() : beta, c + ic, ldc, accumulate || pc > 0);
+                        }
+                    }
+                });
+                return;
+            }
+
+            if (work < GemmParallelSize)
+            {
+                GemmBlocked<Semiring>(rows, cols, inner, alpha, a, lda, b, ldb, beta, c, ldc, accumulate);
+                return;
+            }
+
+            size_t slivers = (cols + GemmNR - 1) / GemmNR;
+
+            ParallelFor(0, slivers, 8, [&](size_t begin, size_t end)
+            {
+                size_t colBegin = begin * GemmNR;
+                size_t colEnd = std::min(cols, end * GemmNR);
+
+                GemmBlocked<Semiring>(rows, colEnd - colBegin, inner, alpha, a, lda, b + colBegin * ldb, ldb,
+                    beta, c + colBegin * ldc, ldc, accumulate);
+            });
+        }
+
+        template <typename Semiring, typename Type>
+        void Gemm(size_t rows, size_t cols, size_t inner, const Type *a, size_t lda, const Type *b, size_t ldb, Type *c, size_t ldc, bool accumulate)
+        {
+            Detail::Gemm<Semiring>(rows, cols, inner, Semiring::template One<Type>(), a, lda, b, ldb,
+                accumulate ? Semiring::template One<Type>() : Semiring::template Zero<Type>(), c, ldc);
+        }
+
+        // Dot product with independent partial sums, so the reduction vectorizes without
+        // reassociating floating-point addition
+
+        template <typename Type>
+        inline Type Dot(const Type *a, const Type *b, size_t count)
+        {
+            Type partial[8] = { };
+            size_t i = 0;
+
+            for (; i + 8 <= count; i += 8)
+            {
+                for (size_t lane = 0; lane < 8; lane++)
+                    partial[lane] += a[i + lane] * b[i + lane];
+            }
+
+            for (; i < count; i++)
+                partial[0] += a[i] * b[i];
+
+            return ((partial[0] + partial[4]) + (partial[1] + partial[5])) + ((partial[2] + partial[6]) + (partial[3] + partial[7]));
+        }
+
+        // C = AᵀB for tall a (rows x aCols) and b (rows x bCols), the transposed product of
+        // projections and Gram matrices. Rows are split between threads, each tile of rows is
+        // reduced while it is in cache, and the partial products are summed.
+
+        template <typename Type>
+        void InnerProducts(size_t rows, size_t aCols, size_t bCols, const Type *a, size_t lda, const Type *b, size_t ldb, Type *c, size_t ldc)
+        {
+            for (size_t j = 0; j < bCols; j++)
+                std::fill(c + j * ldc, c + j * ldc + aCols, Type(0));
+
+            std::mutex mutex;
+
+            ParallelFor(0, rows, GemmSkinnyRows, [&](size_t rowBegin, size_t rowEnd)
+            {
+                std::vector<Type> partial(aCols * bCols, Type(0));
+
+                for (size_t ic = rowBegin; ic < rowEnd; ic += GemmSkinnyTile)
+                {
+                    const size_t mc = std::min(GemmSkinnyTile, rowEnd - ic);
+
+                    for (size_t j = 0; j < bCols; j++)
+                    {
+                        for (size_t i = 0; i < aCols; i++)
+                            partial[j * aCols + i] += Dot(a + i * lda + ic, b + j * ldb + ic, mc);
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+
+                for (size_t j = 0; j < bCols; j++)
+                {
+                    for (size_t i = 0; i < aCols; i++)
+                        c[j * ldc + i] += partial[j * aCols + i];
+                }
+            });
+        }
+    }
+
+    #undef __GEMM_LANE_LOOP
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <Math/Matrix.hpp>
+
+namespace Scoop::Math
+{
+    // One element of a sparse matrix, used for assembly
+
+    template <typename Type> struct Triplet
+    {
+        size_t row;
+        size_t col;
+        Type value;
+    };
+
+    // Compressed sparse column matrix
+    //
+    // The elements of column j are values[colOffsets[j]] to values[colOffsets[j + 1] - 1], sorted by
+    // their row in rowIndices. Column storage matches the column-major layout of Matrix.
+
+    template <typename Type> class SparseMatrix
+    {
+        public:
+
+        // Matrix structure and elements
+
+        size_t rows;
+        size_t cols;
+        std::vector<size_t> colOffsets;
+        std::vector<size_t> rowIndices;
+        std::vector<Type> values;
+
+        // Constructors
+
+        SparseMatrix()
+            : rows(0), cols(0), colOffsets(1, 0)
+        { }
+
+        SparseMatrix(size_t rows, size_t cols)
+            : rows(rows), cols(cols), colOffsets(cols + 1, 0)
+        { }
+
+        // Assembles the matrix from triplets, summing elements given more than once
+
+        SparseMatrix(size_t rows, size_t cols, const std::vector<Triplet<Type>> &triplets)
+            : rows(rows), cols(cols), colOffsets(cols + 1, 0)
+        {
+            std::vector<size_t> bucketOffsets(cols + 1, 0);
+
+            for (const Triplet<Type> &triplet : triplets)
+            {
+                if (triplet.row >= rows || triplet.col >= cols)
+                    throw std::runtime_error("SparseMatrix: triplet index out of range.");
+                bucketOffsets[triplet.col + 1]++;
+            }
+
+            for (size_t col = 0; col < cols; col++)
+                bucketOffsets[col + 1] += bucketOffsets[col];
+
+            std::vector<size_t> order(triplets.size());
+            std::vector<size_t> fill(bucketOffsets.begin(), bucketOffsets.end() - 1);
+
+            for (size_t i = 0; i < triplets.size(); i++)
+                order[fill[triplets[i].col]++] = i;
+
+            this->rowIndices.reserve(triplets.size());
+            this->values.reserve(triplets.size());
+
+            for (size_t col = 0; col < cols; col++)
+            {
+                auto begin = order.begin() + bucketOffsets[col];
+                auto end = order.begin() + bucketOffsets[col + 1];
+
+                std::stable_sort(begin, end, [&](size_t a, size_t b) { return triplets[a].row < triplets[b].row; });
+
+                for (auto it = begin; it != end; ++it)
+                {
+                    const Triplet<Type> &triplet = triplets[*it];
+
+                    if (it != begin && triplet.row == this->rowIndices.back())
+                    {
+                        this->values.back() += triplet.value;
+                    }
+                    else
+                    {
+                        this->rowIndices.push_back(triplet.row);
+                        this->values.push_back(triplet.value);
+                    }
+                }
+
+                this->colOffsets[col + 1] = this->rowIndices.size();
+            }
+        }
+
+        // Element access, returning 0 for elements that are not stored
+
+        size_t NonZeroCount() const
+        { return this->values.size(); }
+
+        Type At(size_t row, size_t col) const
+        {
+            auto begin = this->rowIndices.begin() + this->colOffsets[col];
+            auto end = this->rowIndices.begin() + this->colOffsets[col + 1];
+            auto it = std::lower_bound(begin, end, row);
+
+            if (it == end || *it != row)
+                return Type(0);
+            return this->values[it - this->rowIndices.begin()];
+        }
+
+        // Sparse matrix-vector products
+
+        void Multiply(const Type *x, Type *y) const
+        {
+            std::fill(y, y + this->rows, Type(0));
+
+            for (size_t col = 0; col < this->cols; col++)
+            {
+                const Type value = x[col];
+
+                for (size_t i = this->colOffsets[col]; i < this->colOffsets[col + 1]; i++)
+                    y[this->rowIndices[i]] += this->values[i] * value;
+            }
+        }
+
+        std::vector<Type> Multiply(const std::vector<Type> &x) const
+        {
+            if (x.size() != this->cols)
+                throw std::runtime_error("SparseMatrix::Multiply: vector size mismatch.");
+
+            std::vector<Type> y(this->rows);
+            this->Multiply(x.data(), y.data());
+            return y;
+        }
+
+        // Sparse matrix-matrix product, Y = A X, for count column-major right-hand sides. Columns
+        // scatter into y, so right-hand sides are split between threads.
+
+        void Multiply(const Type *x, size_t ldx, Type *y, size_t ldy, size_t count) const
+        {
+            ParallelFor(0, count, 1, [&](size_t rhsBegin, size_t rhsEnd)
+            {
+                for (size_t rhs = rhsBegin; rhs < rhsEnd; rhs++)
+                    this->Multiply(x + rhs * ldx, y + rhs * ldy);
+            });
+        }
+
+        // Aᵀ x reads each column once, so columns are split between threads
+
+        void MultiplyTranspose(const Type *x, Type *y) const
+        {
+            ParallelFor(0, this->cols, 4096, [&](size_t colBegin, size_t colEnd)
+            {
+                for (size_t col = colBegin; col < colEnd; col++)
+                {
+                    Type dot = 0;
+
+                    for (size_t i = this->colOffsets[col]; i < this->colOffsets[col + 1]; i++)
+                        dot += this->values[i] * x[this->rowIndices[i]];
+
+                    y[col] = dot;
+                }
+            });
+        }
+
+        std::vector<Type> MultiplyTranspose(const std::vector<Type> &x) const
+        {
+            if (x.size() != this->rows)
+                throw std::runtime_error("SparseMatrix::MultiplyTranspose: vector size mismatch.");
+
+            std::vector<Type> y(this->cols);
+            this->MultiplyTranspose(x.data(), y.data());
+            return y;
+        }
+
+        SparseMatrix<Type> Transpose() const
+        {
+            SparseMatrix<Type> newMat(this->cols, this->rows);
+
+            newMat.rowIndices.resize(this->values.size());
+            newMat.values.resize(this->values.size());
+
+            for (size_t i = 0; i < this->rowIndices.size(); i++)
+                newMat.colOffsets[this->rowIndices[i] + 1]++;
+
+            for (size_t row = 0; row < this->rows; row++)
+                newMat.colOffsets[row + 1] += newMat.colOffsets[row];
+
+            std::vector<size_t> fill(newMat.colOffsets.begin(), newMat.colOffsets.end() - 1);
+
+            for (size_t col = 0; col < this->cols; col++)
+            {
+                for (size_t i = this->colOffsets[col]; i < this->colOffsets[col + 1]; i++)
+                {
+                    size_t at = fill[this->rowIndices[i]]++;
+                    newMat.rowIndices[at] = col;
+                    newMat.values[at] = this->values[i];
+                }
+            }
+
+            return newMat;
+        }
+    };
+}
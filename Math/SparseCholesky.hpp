@@ -0,0 +1,683 @@
+#pragma once
+
+#include <Math/Decomposition.hpp>
+#include <Math/Sparse.hpp>
+
+#include <atomic>
+
+namespace Scoop::Math
+{
+    // Supernodal sparse Cholesky decomposition, PAPᵀ = LLᵀ
+    //
+    // The symbolic analysis builds the elimination tree of the permuted matrix, the pattern of
+    // L, and its supernodes: runs of columns that share their pattern below the diagonal, relaxed
+    // to also merge runs whose patterns nearly match. Each supernode is stored as a dense
+    // column-major block of its rows, so the numeric factorization runs on the dense kernels. A
+    // supernode gathers the updates of the supernodes below it in the tree with GEMM, then
+    // factors its diagonal block with the blocked Cholesky and solves for the rows below it.
+    //
+    // Supernodes only depend on their descendants in the supernodal elimination tree, so all
+    // supernodes at the same height in the tree are factored in parallel.
+
+    template <typename Type> class SparseCholesky
+    {
+        public:
+
+        // permutation[i] is the row and column of A that becomes row and column i of PAPᵀ
+
+        size_t size;
+        std::vector<size_t> permutation;
+        bool positiveDefinite;
+
+        // Constructors
+
+        explicit SparseCholesky(const SparseMatrix<Type> &mat)
+            : SparseCholesky(mat, std::vector<size_t>())
+        { }
+
+        SparseCholesky(const SparseMatrix<Type> &mat, const std::vector<size_t> &permutation)
+            : size(mat.rows), permutation(permutation), positiveDefinite(false)
+        {
+            if (mat.rows != mat.cols)
+                throw std::runtime_error("SparseCholesky: matrix must be square.");
+
+            if (this->permutation.empty())
+            {
+                this->permutation.resize(this->size);
+
+                for (size_t i = 0; i < this->size; i++)
+                    this->permutation[i] = i;
+            }
+
+            if (this->permutation.size() != this->size)
+                throw std::runtime_error("SparseCholesky: permutation size mismatch.");
+
+            this->inversePermutation.assign(this->size, this->size);
+
+            for (size_t i = 0; i < this->size; i++)
+            {
+                if (this->permutation[i] >= this->size || this->inversePermutation[this->permutation[i]] != this->size)
+                    throw std::runtime_error("SparseCholesky: invalid permutation.");
+                this->inversePermutation[this->permutation[i]] = i;
+            }
+
+            this->Analyze(mat);
+            this->Factorize(mat);
+        }
+
+        // Refactors a matrix with the same pattern as the analyzed one, reusing the symbolic analysis
+
+        void Factorize(const SparseMatrix<Type> &mat)
+        {
+            if (mat.rows != this->size || mat.cols != this->size)
+                throw std::runtime_error("SparseCholesky::Factorize: matrix size mismatch.");
+
+            const SparseMatrix<Type> lower = this->PermutedLower(mat);
+            std::atomic<bool> failed(false);
+
+            std::fill(this->values.begin(), this->values.end(), Type(0));
+
+            // Scratch for each slot of a level, allocated once. A supernode writes the map entries
+            // of its own rows before reading them, so the map is never cleared.
+
+            std::vector<Scratch> scratch(ThreadCount());
+
+            for (Scratch &slot : scratch)
+                slot.map.resize(this->size);
+
+            for (size_t level = 0; level + 1 < this->levelOffsets.size(); level++)
+            {
+                const size_t *levelNodes = this->levelSupernodes.data() + this->levelOffsets[level];
+                const size_t count = this->levelOffsets[level + 1] - this->levelOffsets[level];
+
+                // A lone supernode runs on this thread and lets its GEMM use the pool itself
+
+                if (count == 1)
+                {
+                    if (!this->FactorSupernode(levelNodes[0], lower, scratch[0], false))
+                        failed = true;
+                }
+                else
+                {
+                    const size_t slots = std::min(count, scratch.size());
+
+                    ParallelFor(0, slots, 1, [&](size_t begin, size_t end)
+                    {
+                        for (size_t slot = begin; slot < end; slot++)
+                        {
+                            for (size_t i = count * slot / slots; i < count * (slot + 1) / slots; i++)
+                            {
+                                if (!this->FactorSupernode(levelNodes[i], lower, scratch[slot], true))
+                                    failed = true;
+                            }
+                        }
+                    });
+                }
+
+                if (failed)
+                    break;
+            }
+
+            this->positiveDefinite = !failed;
+        }
+
+        // Solving, in place for count column-major right-hand sides with leading dimension ldb
+
+        void Solve(Type *b, size_t ldb, size_t count) const
+        {
+            if (!this->positiveDefinite)
+                throw std::runtime_error("SparseCholesky::Solve: matrix is not positive definite.");
+
+            ParallelFor(0, count, 1, [&](size_t begin, size_t end)
+            {
+                std::vector<Type> x(this->size);
+
+                for (size_t rhs = begin; rhs < end; rhs++)
+                {
+                    Type *column = b + rhs * ldb;
+
+                    for (size_t i = 0; i < this->size; i++)
+                        x[i] = column[this->permutation[i]];
+
+                    this->SolvePermuted(x.data());
+
+                    for (size_t i = 0; i < this->size; i++)
+                        column[this->permutation[i]] = x[i];
+                }
+            });
+        }
+
+        std::vector<Type> Solve(const std::vector<Type> &b) const
+        {
+            if (b.size() != this->size)
+                throw std::runtime_error("SparseCholesky::Solve: vector size mismatch.");
+
+            std::vector<Type> x(b);
+            this->Solve(x.data(), this->size, 1);
+            return x;
+        }
+
+        // Factor statistics
+
+        size_t SupernodeCount() const
+        { return this->supernodeFirst.size() - 1; }
+
+        size_t NonZeroCount() const
+        {
+            size_t count = 0;
+
+            for (size_t s = 0; s < this->SupernodeCount(); s++)
+            {
+                const size_t width = this->supernodeFirst[s + 1] - this->supernodeFirst[s];
+                const size_t rows = this->rowOffsets[s + 1] - this->rowOffsets[s];
+                count += width * rows - width * (width - 1) / 2;
+            }
+
+            return count;
+        }
+
+        private:
+
+        std::vector<size_t> inversePermutation;
+
+        // Supernode s holds columns supernodeFirst[s] to supernodeFirst[s + 1] - 1. Its rows are
+        // rows[rowOffsets[s]] onwards (its own columns first), and its dense block starts at
+        // values[valueOffsets[s]] with a leading dimension of its row count.
+
+        std::vector<size_t> supernodeFirst;
+        std::vector<size_t> rowOffsets;
+        std::vector<size_t> rows;
+        std::vector<size_t> valueOffsets;
+        std::vector<Type> values;
+
+        // Supernodes that update supernode s, with the position of their first row inside s
+
+        std::vector<size_t> updateOffsets;
+        std::vector<size_t> updateSources;
+        std::vector<size_t> updatePositions;
+
+        // Supernodes grouped by height in the supernodal elimination tree
+
+        std::vector<size_t> levelOffsets;
+        std::vector<size_t> levelSupernodes;
+
+        static constexpr size_t None = size_t(-1);
+
+        // Per-thread workspace of the numeric factorization: the position of each row of the
+        // current supernode, and the buffers of one descendant update
+
+        struct Scratch
+        {
+            std::vector<size_t> map;
+            std::vector<Type> update;
+            std::vector<Type> transposed;
+        };
+
+        // Lower triangle of PAPᵀ. Only the lower triangle of A is read.
+
+        SparseMatrix<Type> PermutedLower(const SparseMatrix<Type> &mat) const
+        {
+            std::vector<Triplet<Type>> triplets;
+            triplets.reserve(mat.NonZeroCount());
+
+            for (size_t col = 0; col < mat.cols; col++)
+            {
+                for (size_t i = mat.colOffsets[col]; i < mat.colOffsets[col + 1]; i++)
+                {
+                    const size_t row = mat.rowIndices[i];
+
+                    if (row < col)
+                        continue;
+
+                    const size_t newRow = this->inversePermutation[row];
+                    const size_t newCol = this->inversePermutation[col];
+                    triplets.push_back({ std::max(newRow, newCol), std::min(newRow, newCol), mat.values[i] });
+                }
+            }
+
+            return SparseMatrix<Type>(this->size, this->size, triplets);
+        }
+
+        // Elimination tree, from the rows of the lower triangle (the columns of its transpose)
+
+        static std::vector<size_t> EliminationTree(const SparseMatrix<Type> &upper)
+        {
+            const size_t n = upper.cols;
+            std::vector<size_t> parent(n, None), ancestor(n, None);
+
+            for (size_t k = 0; k < n; k++)
+            {
+                for (size_t p = upper.colOffsets[k]; p < upper.colOffsets[k + 1]; p++)
+                {
+                    size_t i = upper.rowIndices[p];
+
+                    while (i != None && i < k)
+                    {
+                        const size_t next = ancestor[i];
+                        ancestor[i] = k;
+
+                        if (next == None)
+                            parent[i] = k;
+                        i = next;
+                    }
+                }
+            }
+
+            return parent;
+        }
+
+        // Depth-first postorder of a forest, visiting children in increasing order
+
+        static std::vector<size_t> Postorder(const std::vector<size_t> &parent)
+        {
+            const size_t n = parent.size();
+            std::vector<size_t> head(n, None), next(n, None), order, stack;
+            order.reserve(n);
+
+            for (size_t j = n; j-- > 0;)
+            {
+                if (parent[j] != None)
+                {
+                    next[j] = head[parent[j]];
+                    head[parent[j]] = j;
+                }
+            }
+
+            for (size_t root = 0; root < n; root++)
+            {
+                if (parent[root] != None)
+                    continue;
+
+                stack.push_back(root);
+
+                while (!stack.empty())
+                {
+                    const size_t j = stack.back();
+
+                    if (head[j] != None)
+                    {
+                        const size_t child = head[j];
+                        head[j] = next[child];
+                        stack.push_back(child);
+                    }
+                    else
+                    {
+                        stack.pop_back();
+                        order.push_back(j);
+                    }
+                }
+            }
+
+            return order;
+        }
+
+        void Analyze(const SparseMatrix<Type> &mat)
+        {
+            const size_t n = this->size;
+            SparseMatrix<Type> lower = this->PermutedLower(mat);
+            SparseMatrix<Type> upper = lower.Transpose();
+            std::vector<size_t> parent = EliminationTree(upper);
+
+            // Renumbering by a postorder of the tree leaves the fill unchanged and makes every
+            // subtree contiguous, so that supernodes are found whatever the given ordering
+
+            const std::vector<size_t> post = Postorder(parent);
+            bool postordered = true;
+
+            for (size_t i = 0; i < n && postordered; i++)
+                postordered = post[i] == i;
+
+            if (!postordered)
+            {
+                std::vector<size_t> permutation(n);
+
+                for (size_t i = 0; i < n; i++)
+                {
+                    permutation[i] = this->permutation[post[i]];
+                    this->inversePermutation[permutation[i]] = i;
+                }
+
+                this->permutation = permutation;
+                lower = this->PermutedLower(mat);
+                upper = lower.Transpose();
+                parent = EliminationTree(upper);
+            }
+
+            // Pattern of L: row k of L is the union of the tree paths from the nonzeros of row k
+            // of A up to k. Rows are visited in order, so every column pattern comes out sorted.
+
+            std::vector<size_t> counts(n, 1), mark(n, None);
+
+            auto visitRow = [&](size_t k, auto &&visit)
+            {
+                mark[k] = k;
+
+                for (size_t p = upper.colOffsets[k]; p < upper.colOffsets[k + 1]; p++)
+                {
+                    for (size_t i = upper.rowIndices[p]; i < k && mark[i] != k; i = parent[i])
+                    {
+                        mark[i] = k;
+                        visit(i);
+                    }
+                }
+            };
+
+            for (size_t k = 0; k < n; k++)
+                visitRow(k, [&](size_t col) { counts[col]++; });
+
+            std::vector<size_t> patternOffsets(n + 1, 0);
+
+            for (size_t col = 0; col < n; col++)
+                patternOffsets[col + 1] = patternOffsets[col] + counts[col];
+
+            std::vector<size_t> pattern(patternOffsets[n]);
+            std::vector<size_t> fill(patternOffsets.begin(), patternOffsets.end() - 1);
+
+            std::fill(mark.begin(), mark.end(), None);
+
+            for (size_t k = 0; k < n; k++)
+            {
+                pattern[fill[k]++] = k;
+                visitRow(k, [&](size_t col) { pattern[fill[col]++] = k; });
+            }
+
+            // Fundamental supernodes: column j joins column j - 1 when it is the only child of j and
+            // the patterns nest
+
+            std::vector<size_t> children(n, 0);
+
+            for (size_t j = 0; j < n; j++)
+            {
+                if (parent[j] != None)
+                    children[parent[j]]++;
+            }
+
+            std::vector<size_t> fundamental(1, 0);
+
+            for (size_t j = 1; j < n; j++)
+            {
+                if (!(parent[j - 1] == j && counts[j - 1] == counts[j] + 1 && children[j] == 1))
+                    fundamental.push_back(j);
+            }
+
+            fundamental.push_back(n);
+
+            // Relaxed supernodes: a fundamental supernode is merged into the one before it when that
+            // one's last column is its child and few explicit zeros are added, so that dense blocks
+            // are wide enough for GEMM
+
+            this->supernodeFirst.assign(1, 0);
+            size_t groupFirst = 0;
+            size_t groupNonZeros = 0;
+
+            for (size_t f = 0; f + 1 < fundamental.size(); f++)
+            {
+                const size_t first = fundamental[f];
+                const size_t last = fundamental[f + 1];
+                size_t nonZeros = 0;
+
+                for (size_t j = first; j < last; j++)
+                    nonZeros += counts[j];
+
+                if (f > 0 && parent[first - 1] == first)
+                {
+                    const size_t width = last - groupFirst;
+                    const size_t rowCount = width - 1 + counts[last - 1];
+                    const size_t entries = width * rowCount - width * (width - 1) / 2;
+                    const double zeros = double(entries - groupNonZeros - nonZeros) / double(entries);
+
+                    if (width <= 4 || (width <= 16 && zeros < 0.8) || (width <= 48 && zeros < 0.1) || zeros < 0.05)
+                    {
+                        groupNonZeros += nonZeros;
+                        continue;
+                    }
+                }
+
+                if (f > 0)
+                    this->supernodeFirst.push_back(first);
+
+                groupFirst = first;
+                groupNonZeros = nonZeros;
+            }
+
+            this->supernodeFirst.push_back(n);
+
+            const size_t supernodes = this->supernodeFirst.size() - 1;
+            std::vector<size_t> supernodeOf(n);
+
+            for (size_t s = 0; s < supernodes; s++)
+                std::fill(supernodeOf.begin() + this->supernodeFirst[s], supernodeOf.begin() + this->supernodeFirst[s + 1], s);
+
+            // The rows of a supernode are its own columns followed by the pattern of its last column
+
+            this->rowOffsets.assign(supernodes + 1, 0);
+            this->valueOffsets.assign(supernodes + 1, 0);
+
+            for (size_t s = 0; s < supernodes; s++)
+            {
+                const size_t width = this->supernodeFirst[s + 1] - this->supernodeFirst[s];
+                const size_t rowCount = width - 1 + counts[this->supernodeFirst[s + 1] - 1];
+
+                this->rowOffsets[s + 1] = this->rowOffsets[s] + rowCount;
+                this->valueOffsets[s + 1] = this->valueOffsets[s] + rowCount * width;
+            }
+
+            this->rows.resize(this->rowOffsets[supernodes]);
+            this->values.assign(this->valueOffsets[supernodes], Type(0));
+
+            for (size_t s = 0; s < supernodes; s++)
+            {
+                const size_t first = this->supernodeFirst[s];
+                const size_t last = this->supernodeFirst[s + 1] - 1;
+                size_t *sRows = this->rows.data() + this->rowOffsets[s];
+
+                for (size_t j = first; j < last; j++)
+                    *sRows++ = j;
+
+                std::copy(pattern.begin() + patternOffsets[last], pattern.begin() + patternOffsets[last + 1], sRows);
+            }
+
+            // Update lists: the rows of source supernode k below its diagonal block fall into
+            // consecutive runs, one per target supernode
+
+            std::vector<size_t> updateCounts(supernodes + 1, 0);
+
+            auto forEachUpdate = [&](auto &&visit)
+            {
+                for (size_t k = 0; k < supernodes; k++)
+                {
+                    const size_t width = this->supernodeFirst[k + 1] - this->supernodeFirst[k];
+
+                    for (size_t p = this->rowOffsets[k] + width; p < this->rowOffsets[k + 1]; p++)
+                    {
+                        const size_t target = supernodeOf[this->rows[p]];
+
+                        if (p == this->rowOffsets[k] + width || supernodeOf[this->rows[p - 1]] != target)
+                            visit(target, k, p - this->rowOffsets[k]);
+                    }
+                }
+            };
+
+            forEachUpdate([&](size_t target, size_t, size_t) { updateCounts[target + 1]++; });
+
+            for (size_t s = 0; s < supernodes; s++)
+                updateCounts[s + 1] += updateCounts[s];
+
+            this->updateOffsets = updateCounts;
+            this->updateSources.resize(updateCounts[supernodes]);
+            this->updatePositions.resize(updateCounts[supernodes]);
+
+            std::vector<size_t> updateFill(updateCounts.begin(), updateCounts.end() - 1);
+
+            forEachUpdate([&](size_t target, size_t source, size_t position)
+            {
+                const size_t at = updateFill[target]++;
+                this->updateSources[at] = source;
+                this->updatePositions[at] = position;
+            });
+
+            // Heights in the supernodal tree. Parents always come after their children.
+
+            std::vector<size_t> height(supernodes, 0);
+            size_t levels = 0;
+
+            for (size_t s = 0; s < supernodes; s++)
+            {
+                const size_t width = this->supernodeFirst[s + 1] - this->supernodeFirst[s];
+
+                if (this->rowOffsets[s] + width < this->rowOffsets[s + 1])
+                {
+                    const size_t up = supernodeOf[this->rows[this->rowOffsets[s] + width]];
+                    height[up] = std::max(height[up], height[s] + 1);
+                }
+
+                levels = std::max(levels, height[s] + 1);
+            }
+
+            this->levelOffsets.assign(levels + 1, 0);
+
+            for (size_t s = 0; s < supernodes; s++)
+                this->levelOffsets[height[s] + 1]++;
+
+            for (size_t level = 0; level < levels; level++)
+                this->levelOffsets[level + 1] += this->levelOffsets[level];
+
+            this->levelSupernodes.resize(supernodes);
+            std::vector<size_t> levelFill(this->levelOffsets.begin(), this->levelOffsets.end() - 1);
+
+            for (size_t s = 0; s < supernodes; s++)
+                this->levelSupernodes[levelFill[height[s]]++] = s;
+        }
+
+        // Factors supernode s. With serial set, as when other supernodes of its level run on the
+        // other threads, the updates use the single-threaded GEMM kernels.
+
+        bool FactorSupernode(size_t s, const SparseMatrix<Type> &lower, Scratch &scratch, bool serial)
+        {
+            std::vector<size_t> &map = scratch.map;
+            std::vector<Type> &update = scratch.update;
+            std::vector<Type> &transposed = scratch.transposed;
+
+            const size_t first = this->supernodeFirst[s];
+            const size_t width = this->supernodeFirst[s + 1] - first;
+            const size_t *sRows = this->rows.data() + this->rowOffsets[s];
+            const size_t ld = this->rowOffsets[s + 1] - this->rowOffsets[s];
+            Type *block = this->values.data() + this->valueOffsets[s];
+
+            for (size_t i = 0; i < ld; i++)
+                map[sRows[i]] = i;
+
+            for (size_t col = 0; col < width; col++)
+            {
+                for (size_t p = lower.colOffsets[first + col]; p < lower.colOffsets[first + col + 1]; p++)
+                    block[col * ld + map[lower.rowIndices[p]]] += lower.values[p];
+            }
+
+            // Gather the updates L_k[p:, :] L_k[p:q, :]ᵀ of every descendant k, where rows p to q - 1
+            // of k are columns of s
+
+            for (size_t u = this->updateOffsets[s]; u < this->updateOffsets[s + 1]; u++)
+            {
+                const size_t k = this->updateSources[u];
+                const size_t p = this->updatePositions[u];
+                const size_t kWidth = this->supernodeFirst[k + 1] - this->supernodeFirst[k];
+                const size_t *kRows = this->rows.data() + this->rowOffsets[k];
+                const size_t kLd = this->rowOffsets[k + 1] - this->rowOffsets[k];
+                const Type *kBlock = this->values.data() + this->valueOffsets[k];
+
+                size_t q = p;
+
+                while (q < kLd && kRows[q] < first + width)
+                    q++;
+
+                const size_t m = kLd - p;
+                const size_t cols = q - p;
+
+                transposed.resize(kWidth * cols);
+                update.resize(m * cols);
+
+                for (size_t col = 0; col < cols; col++)
+                {
+                    for (size_t t = 0; t < kWidth; t++)
+                        transposed[col * kWidth + t] = -kBlock[t * kLd + p + col];
+                }
+
+                if (!serial)
+                    Detail::Gemm<PlusTimes>(m, cols, kWidth, kBlock + p, kLd, transposed.data(), kWidth, update.data(), m, false);
+                else if (m * cols * kWidth <= Detail::GemmSmallSize)
+                {
+                    Detail::GemmSimple<PlusTimes>(m, cols, kWidth, Type(1), kBlock + p, kLd, transposed.data(), kWidth,
+                        Type(0), update.data(), m, false);
+                }
+                else
+                {
+                    Detail::GemmBlocked<PlusTimes>(m, cols, kWidth, Type(1), kBlock + p, kLd, transposed.data(), kWidth,
+                        Type(0), update.data(), m, false);
+                }
+
+                for (size_t col = 0; col < cols; col++)
+                {
+                    Type *dst = block + (kRows[p + col] - first) * ld;
+                    const Type *src = update.data() + col * m;
+
+                    for (size_t i = col; i < m; i++)
+                        dst[map[kRows[p + i]]] += src[i];
+                }
+            }
+
+            if (!Detail::CholeskyFactor(width, block, ld))
+                return false;
+
+            Detail::SolveLowerTransposeRight(ld - width, width, block, ld, block + width, ld);
+            return true;
+        }
+
+        void SolvePermuted(Type *x) const
+        {
+            const size_t supernodes = this->SupernodeCount();
+
+            for (size_t s = 0; s < supernodes; s++)
+            {
+                const size_t first = this->supernodeFirst[s];
+                const size_t width = this->supernodeFirst[s + 1] - first;
+                const size_t *sRows = this->rows.data() + this->rowOffsets[s];
+                const size_t ld = this->rowOffsets[s + 1] - this->rowOffsets[s];
+                const Type *block = this->values.data() + this->valueOffsets[s];
+
+                for (size_t col = 0; col < width; col++)
+                {
+                    const Type *lCol = block + col * ld;
+                    const Type value = x[first + col] / lCol[col];
+                    x[first + col] = value;
+
+                    for (size_t row = col + 1; row < width; row++)
+                        x[first + row] -= lCol[row] * value;
+                    for (size_t row = width; row < ld; row++)
+                        x[sRows[row]] -= lCol[row] * value;
+                }
+            }
+
+            for (size_t s = supernodes; s-- > 0;)
+            {
+                const size_t first = this->supernodeFirst[s];
+                const size_t width = this->supernodeFirst[s + 1] - first;
+                const size_t *sRows = this->rows.data() + this->rowOffsets[s];
+                const size_t ld = this->rowOffsets[s + 1] - this->rowOffsets[s];
+                const Type *block = this->values.data() + this->valueOffsets[s];
+
+                for (size_t col = width; col-- > 0;)
+                {
+                    const Type *lCol = block + col * ld;
+                    Type sum = x[first + col];
+
+                    for (size_t row = col + 1; row < width; row++)
+                        sum -= lCol[row] * x[first + row];
+                    for (size_t row = width; row < ld; row++)
+                        sum -= lCol[row] * x[sRows[row]];
+
+                    x[first + col] = sum / lCol[col];
+                }
+            }
+        }
+    };
+}
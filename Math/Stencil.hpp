@@ -0,0 +1,219 @@
+#pragma once
+
+#include <Math/Matrix.hpp>
+
+namespace Scoop::Math
+{
+    // Stencil options
+
+    struct StencilOptions
+    {
+        size_t timeBlock = 8;
+        size_t tileRows = 512;
+        size_t tileCols = 64;
+    };
+
+    // Neighbourhood of one grid point, passed to stencil functions. point(row, col) returns the
+    // value at the given offset from the point, for offsets between -1 and 1.
+
+    template <typename Type> class StencilPoint
+    {
+        public:
+
+        StencilPoint(const Type *center, size_t stride)
+            : center(center), stride(stride)
+        { }
+
+        Type operator()(ptrdiff_t row, ptrdiff_t col) const
+        { return this->center[col * (ptrdiff_t)this->stride + row]; }
+
+        private:
+
+        const Type *center;
+        size_t stride;
+    };
+
+    // Stencil kernels
+    //
+    // A sweep updates the interior points of a region from src to dst, one column at a time, so
+    // the row loop reads and writes contiguous memory and vectorizes once the stencil function is
+    // inlined. The first and last row and column of the grid are boundary values and are never
+    // updated.
+    //
+    // Temporal blocking uses overlapped tiles: each tile is copied with a halo as wide as the
+    // number of time steps it advances, and every step shrinks the valid region by one point on
+    // each side, so the tile advances several steps while it stays in cache. Halo points are
+    // recomputed by neighbouring tiles, which keeps tiles independent and lets them run on
+    // different threads.
+
+    namespace Detail
+    {
+        template <typename Type, typename Function>
+        void StencilSweep(size_t rowBegin, size_t rowEnd, size_t colBegin, size_t colEnd, const Type *src, Type *dst, size_t ld, const Function &function)
+        {
+            for (size_t col = colBegin; col < colEnd; col++)
+            {
+                const Type *srcCol = src + col * ld;
+                Type *dstCol = dst + col * ld;
+
+                for (size_t row = rowBegin; row < rowEnd; row++)
+                    dstCol[row] = function(StencilPoint<Type>(srcCol + row, ld));
+            }
+        }
+
+        // Advances the tile [rowBegin, rowEnd) x [colBegin, colEnd) of a rows x cols grid by steps
+        // time steps, reading src and writing dst. buffers holds two scratch tiles.
+
+        template <typename Type, typename Function>
+        void StencilTile(size_t rows, size_t cols, size_t rowBegin, size_t rowEnd, size_t colBegin, size_t colEnd, size_t steps,
+            const Type *src, Type *dst, Type *buffers, const Function &function)
+        {
+            const size_t haloRowBegin = rowBegin > steps ? rowBegin - steps : 0;
+            const size_t haloRowEnd = std::min(rows, rowEnd + steps);
+            const size_t haloColBegin = colBegin > steps ? colBegin - steps : 0;
+            const size_t haloColEnd = std::min(cols, colEnd + steps);
+            const size_t localRows = haloRowEnd - haloRowBegin;
+            const size_t localCols = haloColEnd - haloColBegin;
+
+            Type *current = buffers;
+            Type *next = buffers + localRows * localCols;
+
+            for (size_t col = 0; col < localCols; col++)
+            {
+                const Type *srcCol = src + (haloColBegin + col) * rows + haloRowBegin;
+                std::copy(srcCol, srcCol + localRows, current + col * localRows);
+                std::copy(srcCol, srcCol + localRows, next + col * localRows);
+            }
+
+            for (size_t step = 1; step <= steps; step++)
+            {
+                // Region still valid after this step, in grid coordinates, clipped to the interior
+
+                const size_t shrink = steps - step;
+                const size_t updateRowBegin = std::max<size_t>(1, rowBegin > shrink ? rowBegin - shrink : 0);
+                const size_t updateRowEnd = std::min(rows - 1, rowEnd + shrink);
+                const size_t updateColBegin = std::max<size_t>(1, colBegin > shrink ? colBegin - shrink : 0);
+                const size_t updateColEnd = std::min(cols - 1, colEnd + shrink);
+
+                if (updateRowBegin < updateRowEnd && updateColBegin < updateColEnd)
+                {
+                    StencilSweep(updateRowBegin - haloRowBegin, updateRowEnd - haloRowBegin, updateColBegin - haloColBegin, updateColEnd - haloColBegin,
+                        current, next, localRows, function);
+                }
+
+                std::swap(current, next);
+            }
+
+            for (size_t col = colBegin; col < colEnd; col++)
+            {
+                const Type *localCol = current + (col - haloColBegin) * localRows + (rowBegin - haloRowBegin);
+                std::copy(localCol, localCol + (rowEnd - rowBegin), dst + col * rows + rowBegin);
+            }
+        }
+
+        template <typename Type, typename Function>
+        void ApplyStencil(size_t rows, size_t cols, Type *grid, size_t steps, const StencilOptions &options, const Function &function)
+        {
+            if (rows < 3 || cols < 3 || steps == 0)
+                return;
+
+            std::vector<Type> other(grid, grid + rows * cols);
+            Type *src = grid;
+            Type *dst = other.data();
+
+            if (options.timeBlock <= 1)
+            {
+                for (size_t step = 0; step < steps; step++)
+                {
+                    ParallelFor(1, cols - 1, 16, [&](size_t colBegin, size_t colEnd)
+                    {
+                        StencilSweep(1, rows - 1, colBegin, colEnd, src, dst, rows, function);
+                    });
+
+                    std::swap(src, dst);
+                }
+            }
+            else
+            {
+                const size_t tileRows = std::min(std::max<size_t>(options.tileRows, 1), rows);
+                const size_t tileCols = std::min(std::max<size_t>(options.tileCols, 1), cols);
+                const size_t rowTiles = (rows + tileRows - 1) / tileRows;
+                const size_t colTiles = (cols + tileCols - 1) / tileCols;
+
+                for (size_t done = 0; done < steps; done += options.timeBlock)
+                {
+                    const size_t block = std::min(options.timeBlock, steps - done);
+                    const size_t bufferSize = 2 * std::min(rows, tileRows + 2 * block) * std::min(cols, tileCols + 2 * block);
+
+                    ParallelFor(0, rowTiles * colTiles, 1, [&](size_t tileBegin, size_t tileEnd)
+                    {
+                        std::vector<Type> buffers(bufferSize);
+
+                        for (size_t tile = tileBegin; tile < tileEnd; tile++)
+                        {
+                            const size_t rowBegin = (tile % rowTiles) * tileRows;
+                            const size_t colBegin = (tile / rowTiles) * tileCols;
+
+                            StencilTile(rows, cols, rowBegin, std::min(rows, rowBegin + tileRows), colBegin, std::min(cols, colBegin + tileCols), block,
+                                src, dst, buffers.data(), function);
+                        }
+                    });
+
+                    std::swap(src, dst);
+                }
+            }
+
+            if (src != grid)
+                std::copy(src, src + rows * cols, grid);
+        }
+    }
+
+    // Stencil application
+    //
+    // Advances a grid by steps time steps, where each step replaces every interior point with
+    // function(point) evaluated on the previous step. The first and last row and column are
+    // boundary values and are left untouched.
+
+    template <typename Type, typename Function>
+    void ApplyStencil(size_t rows, size_t cols, Type *grid, size_t steps, const Function &function, const StencilOptions &options = StencilOptions())
+    { Detail::ApplyStencil(rows, cols, grid, steps, options, function); }
+
+    template <typename Type, size_t Rows, size_t Cols, typename Function>
+    void ApplyStencil(Matrix<Type, Rows, Cols> &grid, size_t steps, const Function &function, const StencilOptions &options = StencilOptions())
+    { Detail::ApplyStencil(Rows, Cols, grid.data, steps, options, function); }
+
+    // Weighted stencils, where weights.At(1 + row, 1 + col) is the weight of the neighbour at offset
+    // (row, col). When the corner weights are zero, the 5-point form is used.
+
+    template <typename Type>
+    void ApplyStencil(size_t rows, size_t cols, Type *grid, size_t steps, const Matrix<Type, 3, 3> &weights, const StencilOptions &options = StencilOptions())
+    {
+        const Type *w = weights.data;
+
+        if (w[0] == Type(0) && w[2] == Type(0) && w[6] == Type(0) && w[8] == Type(0))
+        {
+            const Type up = w[3], left = w[1], center = w[4], right = w[7], down = w[5];
+
+            Detail::ApplyStencil(rows, cols, grid, steps, options, [=](const StencilPoint<Type> &point)
+            {
+                return center * point(0, 0) + up * point(-1, 0) + down * point(1, 0) + left * point(0, -1) + right * point(0, 1);
+            });
+        }
+        else
+        {
+            Type c[9];
+            std::copy(w, w + 9, c);
+
+            Detail::ApplyStencil(rows, cols, grid, steps, options, [=](const StencilPoint<Type> &point)
+            {
+                return c[0] * point(-1, -1) + c[1] * point(0, -1) + c[2] * point(1, -1)
+                    + c[3] * point(-1, 0) + c[4] * point(0, 0) + c[5] * point(1, 0)
+                    + c[6] * point(-1, 1) + c[7] * point(0, 1) + c[8] * point(1, 1);
+            });
+        }
+    }
+
+    template <typename Type, size_t Rows, size_t Cols>
+    void ApplyStencil(Matrix<Type, Rows, Cols> &grid, size_t steps, const Matrix<Type, 3, 3> &weights, const StencilOptions &options = StencilOptions())
+    { ApplyStencil(Rows, Cols, grid.data, steps, weights, options); }
+}
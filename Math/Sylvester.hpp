@@ -0,0 +1,398 @@
+#pragma once
+
+#include <Math/Decomposition.hpp>
+
+namespace Scoop::Math
+{
+    // Sylvester equation kernels
+
+    namespace Detail
+    {
+        // Systems with at most this many unknowns are solved through their Kronecker form, whose LU
+        // factorization is cheaper than two Schur decompositions
+
+        constexpr size_t SylvesterKroneckerSize = 16;
+
+        // Diagonal blocks of a real Schur form as (start, size) pairs, where a complex pair (the
+        // first with a positive imaginary part) is a 2 x 2 block
+
+        template <typename Type>
+        std::vector<std::pair<size_t, size_t>> SchurBlocks(size_t n, const Type *imag)
+        {
+            std::vector<std::pair<size_t, size_t>> blocks;
+
+            for (size_t i = 0; i < n;)
+            {
+                const size_t size = imag[i] > Type(0) && i + 1 < n ? 2 : 1;
+                blocks.push_back({ i, size });
+                i += size;
+            }
+
+            return blocks;
+        }
+
+        // Solves the small Sylvester system S Y + Y T = R in place of R, with S p x p and T q x q
+        // (p, q ≤ 2), through its Kronecker form (I ⊗ S + Tᵀ ⊗ I) vec Y = vec R. Returns false if
+        // S and -T share an eigenvalue.
+
+        template <typename Type>
+        bool SolveSmallSylvester(size_t p, size_t q, const Type *s, size_t lds, const Type *t, size_t ldt, bool transposeT, Type *r, size_t ldr)
+        {
+            const size_t size = p * q;
+            Type k[16];
+            Type rhs[4];
+            size_t pivots[4];
+
+            for (size_t col = 0; col < q; col++)
+            {
+                for (size_t row = 0; row < p; row++)
+                {
+                    const size_t i = col * p + row;
+                    rhs[i] = r[col * ldr + row];
+
+                    for (size_t col2 = 0; col2 < q; col2++)
+                    {
+                        for (size_t row2 = 0; row2 < p; row2++)
+                        {
+                            const size_t j = col2 * p + row2;
+                            Type value = col == col2 ? s[row2 * lds + row] : Type(0);
+
+                            if (row == row2)
+                                value += transposeT ? t[col2 * ldt + col] : t[col * ldt + col2];
+
+                            k[j * size + i] = value;
+                        }
+                    }
+                }
+            }
+
+            if (!LUFactor(size, k, size, pivots))
+                return false;
+
+            LUSolve(size, k, size, pivots, rhs, size, 1);
+
+            for (size_t col = 0; col < q; col++)
+            {
+                for (size_t row = 0; row < p; row++)
+                    r[col * ldr + row] = rhs[col * p + row];
+            }
+
+            return true;
+        }
+
+        // Bartels-Stewart back substitution. Solves S Y + Y T' = F in place of F for S (m x m) and
+        // T (n x n) in real Schur form, with T' = T or Tᵀ. With T' upper quasi-triangular the
+        // column blocks of Y are found left to right, with Tᵀ right to left. The coupling with the
+        // solved column blocks is one GEMM per block; the rest is back substitution over the
+        // diagonal blocks of S. Returns false if S and -T share an eigenvalue.
+
+        template <typename Type>
+        bool SolveQuasiTriangularSylvester(size_t m, size_t n, const Type *s, size_t lds, const Type *sImag,
+            const Type *t, size_t ldt, const Type *tImag, bool transposeT, Type *f, size_t ldf)
+        {
+            const std::vector<std::pair<size_t, size_t>> sBlocks = SchurBlocks(m, sImag);
+            std::vector<std::pair<size_t, size_t>> tBlocks = SchurBlocks(n, tImag);
+            std::vector<Type> coupling(2 * n);
+
+            if (transposeT)
+                std::reverse(tBlocks.begin(), tBlocks.end());
+
+            for (const auto &[k0, q] : tBlocks)
+            {
+                // F(:, k) -= Σ Y(:, j) T'(j, k) over the solved columns j, with the negated
+                // coefficients gathered so the update is an accumulating GEMM
+
+                const size_t solvedBegin = transposeT ? k0 + q : 0;
+                const size_t solvedCount = transposeT ? n - k0 - q : k0;
+
+                if (solvedCount > 0)
+                {
+                    for (size_t col = 0; col < q; col++)
+                    {
+                        for (size_t j = 0; j < solvedCount; j++)
+                        {
+                            const size_t row = solvedBegin + j;
+                            coupling[col * solvedCount + j] = -(transposeT ? t[row * ldt + k0 + col] : t[(k0 + col) * ldt + row]);
+                        }
+                    }
+
+                    Gemm<PlusTimes>(m, q, solvedCount, f + solvedBegin * ldf, ldf, coupling.data(), solvedCount, f + k0 * ldf, ldf, true);
+                }
+
+                // Back substitution over the diagonal blocks of S, bottom to top
+
+                for (auto it = sBlocks.rbegin(); it != sBlocks.rend(); ++it)
+                {
+                    const auto [i0, p] = *it;
+
+                    for (size_t col = k0; col < k0 + q; col++)
+                    {
+                        for (size_t row = i0; row < i0 + p; row++)
+                        {
+                            Type sum = 0;
+
+                            for (size_t l = i0 + p; l < m; l++)
+                                sum += s[l * lds + row] * f[col * ldf + l];
+
+                            f[col * ldf + row] -= sum;
+                        }
+                    }
+
+                    if (!SolveSmallSylvester(p, q, s + i0 * lds + i0, lds, t + k0 * ldt + k0, ldt, transposeT, f + k0 * ldf + i0, ldf))
+                        return false;
+                }
+            }
+
+            return true;
+        }
+
+        // Real Schur form A = Z S Zᵀ, in place of s, with z and the eigenvalue parts as outputs
+
+        template <typename Type>
+        bool SchurFactor(size_t n, Type *s, Type *z, Type *real, Type *imag)
+        {
+            HessenbergReduce(n, s, n, z, n);
+            return RealSchur(n, s, n, z, n, real, imag);
+        }
+
+        // Kronecker form I ⊗ A + Bᵀ ⊗ I of X -> A X + X B, for X m x n
+
+        template <typename Type>
+        void SylvesterKronecker(size_t m, size_t n, const Type *a, const Type *b, Type *k)
+        {
+            const size_t size = m * n;
+            std::fill(k, k + size * size, Type(0));
+
+            for (size_t col = 0; col < n; col++)
+            {
+                for (size_t row = 0; row < m; row++)
+                {
+                    const size_t i = col * m + row;
+
+                    for (size_t l = 0; l < m; l++)
+                        k[(col * m + l) * size + i] += a[l * m + row];
+                    for (size_t l = 0; l < n; l++)
+                        k[(l * m + row) * size + i] += b[col * n + l];
+                }
+            }
+        }
+    }
+
+    // Sylvester equation solver
+    //
+    // Solves A X + X B = C by the Bartels-Stewart algorithm: with the real Schur forms A = U S Uᵀ
+    // and B = V T Vᵀ, Y = Uᵀ X V solves the quasi-triangular equation S Y + Y T = Uᵀ C V. The
+    // Schur forms are computed once, so each Solve costs O(m²n + mn²). Small systems (up to
+    // SylvesterKroneckerSize unknowns) factor the Kronecker form instead.
+
+    template <typename Type, size_t Rows, size_t Cols> class SylvesterSolver
+    {
+        public:
+
+        // False if a Schur iteration did not converge
+
+        bool converged;
+
+        // Constructors
+
+        SylvesterSolver(const Matrix<Type, Rows, Rows> &a, const Matrix<Type, Cols, Cols> &b)
+        {
+            if constexpr (Rows * Cols <= Detail::SylvesterKroneckerSize)
+            {
+                this->kronecker.resize(Rows * Cols * Rows * Cols);
+                Detail::SylvesterKronecker(Rows, Cols, a.data, b.data, this->kronecker.data());
+                this->singular = !Detail::LUFactor(Rows * Cols, this->kronecker.data(), Rows * Cols, this->pivots);
+                this->converged = true;
+            }
+            else
+            {
+                this->s = a;
+                this->t = b;
+                this->converged = Detail::SchurFactor(Rows, this->s.data, this->u.data, this->sReal.data, this->sImag.data) &&
+                    Detail::SchurFactor(Cols, this->t.data, this->v.data, this->tReal.data, this->tImag.data);
+
+                for (size_t col = 0; col < Cols; col++)
+                {
+                    for (size_t row = 0; row < Cols; row++)
+                        this->vt.data[col * Cols + row] = this->v.data[row * Cols + col];
+                }
+
+                this->singular = false;
+            }
+        }
+
+        // Solving
+
+        Matrix<Type, Rows, Cols> Solve(const Matrix<Type, Rows, Cols> &c) const
+        {
+            if (!this->converged)
+                throw std::runtime_error("SylvesterSolver::Solve: Schur iteration did not converge.");
+            if (this->singular)
+                throw std::runtime_error("SylvesterSolver::Solve: equation has no unique solution.");
+
+            Matrix<Type, Rows, Cols> newMat(c);
+
+            if constexpr (Rows * Cols <= Detail::SylvesterKroneckerSize)
+            {
+                Detail::LUSolve(Rows * Cols, this->kronecker.data(), Rows * Cols, this->pivots, newMat.data, Rows * Cols, 1);
+                return newMat;
+            }
+            else
+            {
+                // F = Uᵀ C V, then X = U Y Vᵀ
+
+                Matrix<Type, Rows, Cols> utc;
+                Detail::InnerProducts(Rows, Rows, Cols, this->u.data, Rows, c.data, Rows, utc.data, Rows);
+                Detail::Gemm<PlusTimes>(Rows, Cols, Cols, utc.data, Rows, this->v.data, Cols, newMat.data, Rows, false);
+
+                if (!Detail::SolveQuasiTriangularSylvester(Rows, Cols, this->s.data, Rows, this->sImag.data, this->t.data, Cols, this->tImag.data, false, newMat.data, Rows))
+                    throw std::runtime_error("SylvesterSolver::Solve: equation has no unique solution.");
+
+                Matrix<Type, Rows, Cols> uy;
+                Detail::Gemm<PlusTimes>(Rows, Cols, Rows, this->u.data, Rows, newMat.data, Rows, uy.data, Rows, false);
+                Detail::Gemm<PlusTimes>(Rows, Cols, Cols, uy.data, Rows, this->vt.data, Cols, newMat.data, Rows, false);
+                return newMat;
+            }
+        }
+
+        private:
+
+        Matrix<Type, Rows, Rows> u;
+        Matrix<Type, Rows, Rows> s;
+        Matrix<Type, Cols, Cols> v;
+        Matrix<Type, Cols, Cols> t;
+        Matrix<Type, Cols, Cols> vt;
+        Vector<Type, Rows> sReal;
+        Vector<Type, Rows> sImag;
+        Vector<Type, Cols> tReal;
+        Vector<Type, Cols> tImag;
+        std::vector<Type> kronecker;
+        size_t pivots[Rows * Cols <= Detail::SylvesterKroneckerSize ? Rows * Cols : 1];
+        bool singular;
+    };
+
+    // Lyapunov equation solver
+    //
+    // Solves A X + X Aᵀ + Q = 0, the Sylvester equation with B = Aᵀ. Its Schur form is Sᵀ, so one
+    // Schur decomposition of A serves both sides and the column blocks are solved right to left.
+    // For symmetric Q the solution is symmetrized.
+
+    template <typename Type, size_t Size> class LyapunovSolver
+    {
+        public:
+
+        // False if the Schur iteration did not converge
+
+        bool converged;
+
+        // Constructors
+
+        explicit LyapunovSolver(const Matrix<Type, Size, Size> &a)
+        {
+            if constexpr (Size * Size <= Detail::SylvesterKroneckerSize)
+            {
+                Matrix<Type, Size, Size> transpose;
+
+                for (size_t col = 0; col < Size; col++)
+                {
+                    for (size_t row = 0; row < Size; row++)
+                        transpose.data[col * Size + row] = a.data[row * Size + col];
+                }
+
+                this->kronecker.resize(Size * Size * Size * Size);
+                Detail::SylvesterKronecker(Size, Size, a.data, transpose.data, this->kronecker.data());
+                this->singular = !Detail::LUFactor(Size * Size, this->kronecker.data(), Size * Size, this->pivots);
+                this->converged = true;
+            }
+            else
+            {
+                this->s = a;
+                this->converged = Detail::SchurFactor(Size, this->s.data, this->u.data, this->sReal.data, this->sImag.data);
+
+                for (size_t col = 0; col < Size; col++)
+                {
+                    for (size_t row = 0; row < Size; row++)
+                        this->ut.data[col * Size + row] = this->u.data[row * Size + col];
+                }
+
+                this->singular = false;
+            }
+        }
+
+        // Solving
+
+        Matrix<Type, Size, Size> Solve(const Matrix<Type, Size, Size> &q) const
+        {
+            if (!this->converged)
+                throw std::runtime_error("LyapunovSolver::Solve: Schur iteration did not converge.");
+            if (this->singular)
+                throw std::runtime_error("LyapunovSolver::Solve: equation has no unique solution.");
+
+            Matrix<Type, Size, Size> newMat = q.Scale(Type(-1));
+
+            if constexpr (Size * Size <= Detail::SylvesterKroneckerSize)
+            {
+                Detail::LUSolve(Size * Size, this->kronecker.data(), Size * Size, this->pivots, newMat.data, Size * Size, 1);
+            }
+            else
+            {
+                // F = -Uᵀ Q U, then X = U Y Uᵀ
+
+                Matrix<Type, Size, Size> utq;
+                Detail::InnerProducts(Size, Size, Size, this->u.data, Size, newMat.data, Size, utq.data, Size);
+                Detail::Gemm<PlusTimes>(Size, Size, Size, utq.data, Size, this->u.data, Size, newMat.data, Size, false);
+
+                if (!Detail::SolveQuasiTriangularSylvester(Size, Size, this->s.data, Size, this->sImag.data, this->s.data, Size, this->sImag.data, true, newMat.data, Size))
+                    throw std::runtime_error("LyapunovSolver::Solve: equation has no unique solution.");
+
+                Matrix<Type, Size, Size> uy;
+                Detail::Gemm<PlusTimes>(Size, Size, Size, this->u.data, Size, newMat.data, Size, uy.data, Size, false);
+                Detail::Gemm<PlusTimes>(Size, Size, Size, uy.data, Size, this->ut.data, Size, newMat.data, Size, false);
+            }
+
+            bool symmetric = true;
+
+            for (size_t col = 0; col < Size && symmetric; col++)
+            {
+                for (size_t row = col + 1; row < Size; row++)
+                    symmetric &= q.data[col * Size + row] == q.data[row * Size + col];
+            }
+
+            if (symmetric)
+            {
+                for (size_t col = 0; col < Size; col++)
+                {
+                    for (size_t row = col + 1; row < Size; row++)
+                    {
+                        const Type value = (newMat.data[col * Size + row] + newMat.data[row * Size + col]) / 2;
+                        newMat.data[col * Size + row] = value;
+                        newMat.data[row * Size + col] = value;
+                    }
+                }
+            }
+
+            return newMat;
+        }
+
+        private:
+
+        Matrix<Type, Size, Size> u;
+        Matrix<Type, Size, Size> s;
+        Matrix<Type, Size, Size> ut;
+        Vector<Type, Size> sReal;
+        Vector<Type, Size> sImag;
+        std::vector<Type> kronecker;
+        size_t pivots[Size * Size <= Detail::SylvesterKroneckerSize ? Size * Size : 1];
+        bool singular;
+    };
+
+    // One-off solves
+
+    template <typename Type, size_t Rows, size_t Cols>
+    Matrix<Type, Rows, Cols> SolveSylvester(const Matrix<Type, Rows, Rows> &a, const Matrix<Type, Cols, Cols> &b, const Matrix<Type, Rows, Cols> &c)
+    { return SylvesterSolver<Type, Rows, Cols>(a, b).Solve(c); }
+
+    template <typename Type, size_t Size>
+    Matrix<Type, Size, Size> SolveLyapunov(const Matrix<Type, Size, Size> &a, const Matrix<Type, Size, Size> &q)
+    { return LyapunovSolver<Type, Size>(a).Solve(q); }
+}
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <Math/Transform.hpp>
+
+namespace Scoop::Math
+{
+    // Structured matrix kernels
+
+    namespace Detail
+    {
+        // Y = C X for the circulant matrix with spectrum (the transform of its first column) and
+        // count real right-hand sides of length inputs, keeping the first outputs elements of each
+        // product. The circulant is real, so two right-hand sides share one complex transform as
+        // its real and imaginary parts. Pairs are split between threads.
+
+        template <typename Type>
+        void CirculantApply(const FourierTransform<Type> &transform, const std::vector<std::complex<Type>> &spectrum, bool divide,
+            size_t inputs, size_t outputs, const Type *x, size_t ldx, Type *y, size_t ldy, size_t count)
+        {
+            const size_t size = transform.Size();
+            const size_t pairs = (count + 1) / 2;
+
+            ParallelFor(0, pairs, std::max<size_t>(1, 16384 / size), [&](size_t pairBegin, size_t pairEnd)
+            {
+                std::vector<std::complex<Type>> work(size);
+
+                for (size_t pair = pairBegin; pair < pairEnd; pair++)
+                {
+                    const size_t first = 2 * pair;
+                    const bool both = first + 1 < count;
+                    const Type *x0 = x + first * ldx;
+                    const Type *x1 = x + (first + 1) * ldx;
+
+                    for (size_t i = 0; i < inputs; i++)
+                        work[i] = std::complex<Type>(x0[i], both ? x1[i] : Type(0));
+
+                    std::fill(work.begin() + inputs, work.end(), std::complex<Type>(0));
+                    transform.Forward(work.data());
+
+                    if (divide)
+                    {
+                        for (size_t k = 0; k < size; k++)
+                            work[k] /= spectrum[k];
+                    }
+                    else
+                    {
+                        for (size_t k = 0; k < size; k++)
+                            work[k] = ComplexMultiply(work[k], spectrum[k]);
+                    }
+
+                    transform.Inverse(work.data());
+
+                    Type *y0 = y + first * ldy;
+                    Type *y1 = y + (first + 1) * ldy;
+
+                    for (size_t i = 0; i < outputs; i++)
+                    {
+                        y0[i] = work[i].real();
+                        if (both)
+                            y1[i] = work[i].imag();
+                    }
+                }
+            });
+        }
+    }
+
+    // Circulant matrix
+    //
+    // Stores the first column c, so element (i, j) is c[(i - j) mod n]. The matrix is diagonalized
+    // by the Fourier transform, so products and solves cost O(n log n).
+
+    template <typename Type> class CirculantMatrix
+    {
+        public:
+
+        // First column
+
+        std::vector<Type> column;
+
+        // Constructors
+
+        explicit CirculantMatrix(const std::vector<Type> &column)
+            : column(column), transform(column.size())
+        {
+            this->spectrum.assign(column.begin(), column.end());
+            this->transform.Forward(this->spectrum.data());
+        }
+
+        size_t Size() const
+        { return this->column.size(); }
+
+        Type At(size_t row, size_t col) const
+        { return this->column[(row + this->Size() - col) % this->Size()]; }
+
+        // Eigenvalues, the Fourier transform of the first column
+
+        const std::vector<std::complex<Type>> &Eigenvalues() const
+        { return this->spectrum; }
+
+        // Products, y = C x, for one or count column-major right-hand sides
+
+        void Multiply(const Type *x, size_t ldx, Type *y, size_t ldy, size_t count) const
+        { Detail::CirculantApply(this->transform, this->spectrum, false, this->Size(), this->Size(), x, ldx, y, ldy, count); }
+
+        void Multiply(const Type *x, Type *y) const
+        { this->Multiply(x, this->Size(), y, this->Size(), 1); }
+
+        std::vector<Type> Multiply(const std::vector<Type> &x) const
+        {
+            if (x.size() != this->Size())
+                throw std::runtime_error("CirculantMatrix::Multiply: vector size mismatch.");
+
+            std::vector<Type> y(this->Size());
+            this->Multiply(x.data(), y.data());
+            return y;
+        }
+
+        // Solving, x = F⁻¹(F(b) / F(c))
+
+        void Solve(const Type *b, size_t ldb, Type *x, size_t ldx, size_t count) const
+        {
+            for (const std::complex<Type> &value : this->spectrum)
+            {
+                if (value == std::complex<Type>(0))
+                    throw std::runtime_error("CirculantMatrix::Solve: matrix is singular.");
+            }
+
+            Detail::CirculantApply(this->transform, this->spectrum, true, this->Size(), this->Size(), b, ldb, x, ldx, count);
+        }
+
+        std::vector<Type> Solve(const std::vector<Type> &b) const
+        {
+            if (b.size() != this->Size())
+                throw std::runtime_error("CirculantMatrix::Solve: vector size mismatch.");
+
+            std::vector<Type> x(this->Size());
+            this->Solve(b.data(), this->Size(), x.data(), this->Size(), 1);
+            return x;
+        }
+
+        private:
+
+        FourierTransform<Type> transform;
+        std::vector<std::complex<Type>> spectrum;
+    };
+
+    // Toeplitz matrix
+    //
+    // Stores the first column c and first row r (with r[0] = c[0]), so element (i, j) is c[i - j]
+    // below the diagonal and r[j - i] above it. Products embed the matrix in a circulant matrix of
+    // power-of-two size at least rows + cols - 1 and cost O(n log n).
+
+    template <typename Type> class ToeplitzMatrix
+    {
+        public:
+
+        // First column and first row
+
+        std::vector<Type> column;
+        std::vector<Type> row;
+
+        // Constructors
+
+        ToeplitzMatrix(const std::vector<Type> &column, const std::vector<Type> &row)
+            : column(column), row(row), transform(EmbeddingSize(column.size(), row.size()))
+        {
+            if (column[0] != row[0])
+                throw std::runtime_error("ToeplitzMatrix: first column and row must share their first element.");
+
+            // First column of the circulant: c, then zeros, then r reversed
+
+            const size_t size = this->transform.Size();
+            this->spectrum.assign(size, std::complex<Type>(0));
+
+            for (size_t i = 0; i < column.size(); i++)
+                this->spectrum[i] = column[i];
+            for (size_t i = 1; i < row.size(); i++)
+                this->spectrum[size - i] = row[i];
+
+            this->transform.Forward(this->spectrum.data());
+        }
+
+        // Symmetric Toeplitz matrix
+
+        explicit ToeplitzMatrix(const std::vector<Type> &column)
+            : ToeplitzMatrix(column, column)
+        { }
+
+        size_t Rows() const
+        { return this->column.size(); }
+
+        size_t Cols() const
+        { return this->row.size(); }
+
+        Type At(size_t row, size_t col) const
+        { return row >= col ? this->column[row - col] : this->row[col - row]; }
+
+        // Products, y = T x, for one or count column-major right-hand sides
+
+        void Multiply(const Type *x, size_t ldx, Type *y, size_t ldy, size_t count) const
+        { Detail::CirculantApply(this->transform, this->spectrum, false, this->Cols(), this->Rows(), x, ldx, y, ldy, count); }
+
+        void Multiply(const Type *x, Type *y) const
+        { this->Multiply(x, this->Cols(), y, this->Rows(), 1); }
+
+        std::vector<Type> Multiply(const std::vector<Type> &x) const
+        {
+            if (x.size() != this->Cols())
+                throw std::runtime_error("ToeplitzMatrix::Multiply: vector size mismatch.");
+
+            std::vector<Type> y(this->Rows());
+            this->Multiply(x.data(), y.data());
+            return y;
+        }
+
+        // Solving by the Levinson recursion in O(n²), for square matrices whose leading principal
+        // submatrices are all nonsingular. The forward and backward vectors (Tₖfₖ = e₁ and
+        // Tₖbₖ = eₖ) are grown one order at a time, and each order adds one element of x.
+
+        std::vector<Type> Solve(const std::vector<Type> &b) const
+        {
+            const size_t n = this->Rows();
+
+            if (n != this->Cols())
+                throw std::runtime_error("ToeplitzMatrix::Solve: matrix must be square.");
+            if (b.size() != n)
+                throw std::runtime_error("ToeplitzMatrix::Solve: vector size mismatch.");
+            if (this->column[0] == Type(0))
+                throw std::runtime_error("ToeplitzMatrix::Solve: leading principal submatrix is singular.");
+
+            std::vector<Type> forward(n), backward(n), x(n), newForward(n), newBackward(n);
+
+            forward[0] = Type(1) / this->column[0];
+            backward[0] = forward[0];
+            x[0] = b[0] * forward[0];
+
+            for (size_t k = 1; k < n; k++)
+            {
+                // Errors of [f; 0] in the new last row and [0; b] in the new first row
+
+                Type forwardError = 0;
+                Type backwardError = 0;
+                Type solutionError = 0;
+
+                for (size_t i = 0; i < k; i++)
+                {
+                    forwardError += this->column[k - i] * forward[i];
+                    backwardError += this->row[i + 1] * backward[i];
+                    solutionError += this->column[k - i] * x[i];
+                }
+
+                const Type denominator = 1 - forwardError * backwardError;
+
+                if (denominator == Type(0))
+                    throw std::runtime_error("ToeplitzMatrix::Solve: leading principal submatrix is singular.");
+
+                const Type scale = 1 / denominator;
+
+                for (size_t i = 0; i <= k; i++)
+                {
+                    const Type f = i < k ? forward[i] : Type(0);
+                    const Type g = i > 0 ? backward[i - 1] : Type(0);
+
+                    newForward[i] = (f - forwardError * g) * scale;
+                    newBackward[i] = (g - backwardError * f) * scale;
+                }
+
+                std::swap(forward, newForward);
+                std::swap(backward, newBackward);
+
+                const Type correction = b[k] - solutionError;
+
+                for (size_t i = 0; i <= k; i++)
+                    x[i] += correction * backward[i];
+            }
+
+            return x;
+        }
+
+        private:
+
+        FourierTransform<Type> transform;
+        std::vector<std::complex<Type>> spectrum;
+
+        // Also validates the sizes, since it runs in the initializer list before the constructor body
+
+        static size_t EmbeddingSize(size_t rows, size_t cols)
+        {
+            if (rows == 0 || cols == 0)
+                throw std::runtime_error("ToeplitzMatrix: matrix must not be empty.");
+
+            size_t size = 1;
+
+            while (size < rows + cols - 1)
+                size <<= 1;
+
+            return size;
+        }
+    };
+}
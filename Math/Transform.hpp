@@ -0,0 +1,403 @@
+#pragma once
+
+#include <Math/Matrix.hpp>
+
+#include <complex>
+#include <memory>
+
+namespace Scoop::Math
+{
+    // Transform kernels
+
+    namespace Detail
+    {
+        // Complex product written out, so it vectorizes and skips the NaN recovery of the
+        // library operator
+
+        template <typename Type>
+        inline std::complex<Type> ComplexMultiply(std::complex<Type> a, std::complex<Type> b)
+        { return std::complex<Type>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()); }
+
+        template <typename Type>
+        inline std::complex<Type> ComplexMultiplyConjugate(std::complex<Type> a, std::complex<Type> b)
+        { return std::complex<Type>(a.real() * b.real() + a.imag() * b.imag(), a.imag() * b.real() - a.real() * b.imag()); }
+    }
+
+    // Fast Fourier transform
+    //
+    // Plans a complex transform of a fixed size once: twiddle factors and the bit-reversal
+    // permutation for the iterative radix-2 transform, and for other sizes the chirp of
+    // Bluestein's algorithm, which evaluates the transform as a convolution of power-of-two size.
+    // A plan is read-only after construction, so one plan can be shared between threads.
+
+    template <typename Type> class FourierTransform
+    {
+        public:
+
+        // Constructors
+
+        explicit FourierTransform(size_t size)
+            : size(size)
+        {
+            if (size == 0)
+                throw std::runtime_error("FourierTransform: size must be positive.");
+
+            if ((size & (size - 1)) == 0)
+            {
+                this->twiddles.resize(size / 2);
+                this->reversed.resize(size);
+
+                for (size_t k = 0; k < size / 2; k++)
+                {
+                    const double angle = -2.0 * 3.14159265358979323846 * double(k) / double(size);
+                    this->twiddles[k] = std::complex<Type>(Type(std::cos(angle)), Type(std::sin(angle)));
+                }
+
+                size_t bits = 0;
+
+                while ((size_t(1) << bits) < size)
+                    bits++;
+
+                for (size_t i = 0; i < size; i++)
+                {
+                    size_t j = 0;
+
+                    for (size_t bit = 0; bit < bits; bit++)
+                        j |= ((i >> bit) & 1) << (bits - 1 - bit);
+
+                    this->reversed[i] = j;
+                }
+            }
+            else
+            {
+                // Chirp wₖ = exp(-iπk²/n), with k² reduced modulo 2n to keep the angle accurate
+
+                size_t padded = 1;
+
+                while (padded < 2 * size - 1)
+                    padded <<= 1;
+
+                this->chirp.resize(size);
+
+                for (size_t k = 0; k < size; k++)
+                {
+                    const double angle = -3.14159265358979323846 * double((k * k) % (2 * size)) / double(size);
+                    this->chirp[k] = std::complex<Type>(Type(std::cos(angle)), Type(std::sin(angle)));
+                }
+
+                this->inner = std::make_shared<FourierTransform<Type>>(padded);
+                this->kernel.assign(padded, std::complex<Type>(0));
+                this->kernel[0] = std::conj(this->chirp[0]);
+
+                for (size_t k = 1; k < size; k++)
+                {
+                    this->kernel[k] = std::conj(this->chirp[k]);
+                    this->kernel[padded - k] = std::conj(this->chirp[k]);
+                }
+
+                this->inner->Forward(this->kernel.data());
+            }
+        }
+
+        size_t Size() const
+        { return this->size; }
+
+        // Unnormalized forward transform, Xₖ = Σ xⱼ exp(-2πijk/n), in place
+
+        void Forward(std::complex<Type> *data) const
+        {
+            if (this->inner)
+                this->Bluestein(data);
+            else
+                this->Radix2(data, false);
+        }
+
+        // Inverse transform, scaled by 1/n so it undoes Forward, in place
+
+        void Inverse(std::complex<Type> *data) const
+        {
+            if (this->inner)
+            {
+                // The inverse is the conjugate of the forward transform of the conjugate
+
+                for (size_t i = 0; i < this->size; i++)
+                    data[i] = std::conj(data[i]);
+
+                this->Bluestein(data);
+
+                for (size_t i = 0; i < this->size; i++)
+                    data[i] = std::conj(data[i]);
+            }
+            else
+            {
+                this->Radix2(data, true);
+            }
+
+            const Type scale = Type(1) / Type(this->size);
+
+            for (size_t i = 0; i < this->size; i++)
+                data[i] *= scale;
+        }
+
+        std::vector<std::complex<Type>> Forward(const std::vector<std::complex<Type>> &data) const
+        {
+            if (data.size() != this->size)
+                throw std::runtime_error("FourierTransform::Forward: vector size mismatch.");
+
+            std::vector<std::complex<Type>> newData(data);
+            this->Forward(newData.data());
+            return newData;
+        }
+
+        std::vector<std::complex<Type>> Inverse(const std::vector<std::complex<Type>> &data) const
+        {
+            if (data.size() != this->size)
+                throw std::runtime_error("FourierTransform::Inverse: vector size mismatch.");
+
+            std::vector<std::complex<Type>> newData(data);
+            this->Inverse(newData.data());
+            return newData;
+        }
+
+        private:
+
+        size_t size;
+        std::vector<std::complex<Type>> twiddles;
+        std::vector<size_t> reversed;
+        std::vector<std::complex<Type>> chirp;
+        std::vector<std::complex<Type>> kernel;
+        std::shared_ptr<FourierTransform<Type>> inner;
+
+        // Iterative decimation in time. Inverse transforms use the conjugate twiddles and are not
+        // scaled here.
+
+        void Radix2(std::complex<Type> *data, bool inverse) const
+        {
+            const size_t n = this->size;
+
+            for (size_t i = 0; i < n; i++)
+            {
+                const size_t j = this->reversed[i];
+
+                if (i < j)
+                    std::swap(data[i], data[j]);
+            }
+
+            for (size_t length = 2; length <= n; length <<= 1)
+            {
+                const size_t half = length / 2;
+                const size_t step = n / length;
+
+                for (size_t start = 0; start < n; start += length)
+                {
+                    std::complex<Type> *low = data + start;
+                    std::complex<Type> *high = data + start + half;
+
+                    for (size_t k = 0; k < half; k++)
+                    {
+                        const std::complex<Type> w = this->twiddles[k * step];
+                        const std::complex<Type> t = inverse ? Detail::ComplexMultiplyConjugate(high[k], w) : Detail::ComplexMultiply(high[k], w);
+
+                        high[k] = low[k] - t;
+                        low[k] += t;
+                    }
+                }
+            }
+        }
+
+        // Xₖ = wₖ Σ (xⱼwⱼ) conj(wₖ₋ⱼ), a convolution evaluated with the padded power-of-two plan
+
+        void Bluestein(std::complex<Type> *data) const
+        {
+            const size_t padded = this->kernel.size();
+            std::vector<std::complex<Type>> work(padded, std::complex<Type>(0));
+
+            for (size_t k = 0; k < this->size; k++)
+                work[k] = Detail::ComplexMultiply(data[k], this->chirp[k]);
+
+            this->inner->Forward(work.data());
+
+            for (size_t k = 0; k < padded; k++)
+                work[k] = Detail::ComplexMultiply(work[k], this->kernel[k]);
+
+            this->inner->Inverse(work.data());
+
+            for (size_t k = 0; k < this->size; k++)
+                data[k] = Detail::ComplexMultiply(work[k], this->chirp[k]);
+        }
+    };
+
+    // Walsh-Hadamard transform kernels
+
+    namespace Detail
+    {
+        // Elements transformed completely before the stages that span more than one block, so
+        // the early stages stay in cache
+
+        constexpr size_t WalshHadamardBlock = 4096;
+
+        // Butterflies (a + b, a - b) of half width half over size elements. The inner loop is
+        // contiguous, so it vectorizes once half reaches the SIMD width.
+
+        template <typename Type>
+        void WalshHadamardStage(Type *data, size_t size, size_t half)
+        {
+            for (size_t start = 0; start < size; start += 2 * half)
+            {
+                Type *low = data + start;
+                Type *high = low + half;
+
+                for (size_t k = 0; k < half; k++)
+                {
+                    const Type a = low[k];
+                    const Type b = high[k];
+
+                    low[k] = a + b;
+                    high[k] = a - b;
+                }
+            }
+        }
+
+        // Unnormalized transform of one block. The first two stages are too narrow for SIMD, so
+        // they are fused into radix-4 butterflies.
+
+        template <typename Type>
+        void WalshHadamardBlocked(Type *data, size_t size)
+        {
+            if (size == 2)
+            {
+                const Type a = data[0];
+                data[0] = a + data[1];
+                data[1] = a - data[1];
+                return;
+            }
+
+            for (size_t i = 0; i + 3 < size; i += 4)
+            {
+                const Type a = data[i] + data[i + 1];
+                const Type b = data[i] - data[i + 1];
+                const Type c = data[i + 2] + data[i + 3];
+                const Type d = data[i + 2] - data[i + 3];
+
+                data[i] = a + c;
+                data[i + 1] = b + d;
+                data[i + 2] = a - c;
+                data[i + 3] = b - d;
+            }
+
+            for (size_t half = 4; half < size; half <<= 1)
+                WalshHadamardStage(data, size, half);
+        }
+
+        // Transform of one power-of-two column in natural (Sylvester) order, scaled by scale.
+        // When threaded, blocks and then the butterflies of each wide stage are split between
+        // threads.
+
+        template <typename Type>
+        void WalshHadamard(size_t size, Type *data, Type scale, bool threaded)
+        {
+            const size_t block = std::min(size, WalshHadamardBlock);
+
+            ParallelFor(0, size / block, threaded ? 1 : size, [&](size_t blockBegin, size_t blockEnd)
+            {
+                for (size_t b = blockBegin; b < blockEnd; b++)
+                    WalshHadamardBlocked(data + b * block, block);
+            });
+
+            for (size_t half = block; half < size; half <<= 1)
+            {
+                // Butterfly k pairs element (k / half) * 2half + k % half with the one half later
+
+                ParallelFor(0, size / 2, threaded ? block : size, [&](size_t begin, size_t end)
+                {
+                    for (size_t k = begin; k < end;)
+                    {
+                        const size_t offset = k % half;
+                        const size_t length = std::min(half - offset, end - k);
+                        Type *low = data + (k / half) * 2 * half + offset;
+                        Type *high = low + half;
+
+                        for (size_t i = 0; i < length; i++)
+                        {
+                            const Type a = low[i];
+                            const Type b = high[i];
+
+                            low[i] = a + b;
+                            high[i] = a - b;
+                        }
+
+                        k += length;
+                    }
+                });
+            }
+
+            if (scale != Type(1))
+            {
+                for (size_t i = 0; i < size; i++)
+                    data[i] *= scale;
+            }
+        }
+    }
+
+    // Walsh-Hadamard transform
+    //
+    // Applies the Hadamard matrix H (H(i, j) = (-1)^popcount(i & j)) in O(n log n) additions, in
+    // place. The normalized transform is scaled by 1/√n, which makes it orthogonal and its own
+    // inverse; the unnormalized one satisfies H H = n I.
+
+    // Transforms count column-major columns of size elements. Columns are split between threads;
+    // a single column is split by blocks and butterflies instead.
+
+    template <typename Type>
+    void WalshHadamard(size_t size, Type *data, size_t ld, size_t count, bool normalized = false)
+    {
+        if (size == 0 || (size & (size - 1)) != 0)
+            throw std::runtime_error("WalshHadamard: size must be a power of two.");
+
+        const Type scale = normalized ? Type(1) / std::sqrt(Type(size)) : Type(1);
+
+        if (count == 1)
+        {
+            Detail::WalshHadamard(size, data, scale, true);
+            return;
+        }
+
+        ParallelFor(0, count, std::max<size_t>(1, 16384 / size), [&](size_t colBegin, size_t colEnd)
+        {
+            for (size_t col = colBegin; col < colEnd; col++)
+                Detail::WalshHadamard(size, data + col * ld, scale, false);
+        });
+    }
+
+    template <typename Type, size_t Size>
+    void WalshHadamardInPlace(Vector<Type, Size> &vec, bool normalized = false)
+    {
+        static_assert(Size != 0 && (Size & (Size - 1)) == 0, "WalshHadamard: size must be a power of two.");
+        WalshHadamard(Size, vec.data, Size, 1, normalized);
+    }
+
+    template <typename Type, size_t Size>
+    Vector<Type, Size> WalshHadamard(const Vector<Type, Size> &vec, bool normalized = false)
+    {
+        Vector<Type, Size> newVec(vec);
+        WalshHadamardInPlace(newVec, normalized);
+        return newVec;
+    }
+
+    // Transforms each column, H A
+
+    template <typename Type, size_t Rows, size_t Cols>
+    void WalshHadamardInPlace(Matrix<Type, Rows, Cols> &mat, bool normalized = false)
+    {
+        static_assert(Rows != 0 && (Rows & (Rows - 1)) == 0, "WalshHadamard: row count must be a power of two.");
+        WalshHadamard(Rows, mat.data, Rows, Cols, normalized);
+    }
+
+    template <typename Type, size_t Rows, size_t Cols>
+    Matrix<Type, Rows, Cols> WalshHadamard(const Matrix<Type, Rows, Cols> &mat, bool normalized = false)
+    {
+        Matrix<Type, Rows, Cols> newMat(mat);
+        WalshHadamardInPlace(newMat, normalized);
+        return newMat;
+    }
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <Math/Decomposition.hpp>
+
+namespace Scoop::Math
+{
+    // Tridiagonal systems
+    //
+    // A system of n equations is given by three diagonals of length n, where row i reads
+    // lower[i] * x[i - 1] + diag[i] * x[i] + upper[i] * x[i + 1] = rhs[i]. lower[0] and
+    // upper[n - 1] lie outside the matrix and are ignored.
+
+    namespace Detail
+    {
+        constexpr size_t TridiagonalLanes = 16;
+        constexpr size_t CyclicReductionChunk = 4096;
+
+        // Thomas algorithm. Solves in place in x, using scratch (length n) for the modified upper
+        // diagonal. Consecutive elements of one system are stride apart.
+
+        template <typename Type>
+        void ThomasSolve(size_t n, const Type *lower, const Type *diag, const Type *upper, Type *x, Type *scratch, size_t stride)
+        {
+            if (n == 0)
+                return;
+
+            Type pivot = diag[0];
+
+            if (pivot == Type(0))
+                throw std::runtime_error("SolveTridiagonal: zero pivot.");
+
+            scratch[0] = upper[0] / pivot;
+            x[0] = x[0] / pivot;
+
+            for (size_t i = 1; i < n; i++)
+            {
+                const size_t at = i * stride;
+                pivot = diag[at] - lower[at] * scratch[i - 1];
+
+                if (pivot == Type(0))
+                    throw std::runtime_error("SolveTridiagonal: zero pivot.");
+
+                scratch[i] = upper[at] / pivot;
+                x[at] = (x[at] - lower[at] * x[at - stride]) / pivot;
+            }
+
+            for (size_t i = n - 1; i-- > 0;)
+                x[i * stride] -= scratch[i] * x[(i + 1) * stride];
+        }
+
+        // Thomas algorithm over a group of systems interleaved with the given stride, where element
+        // i of system s is at index i * stride + s. All lanes advance in lock-step, so the lane
+        // loops vectorize.
+
+        template <typename Type>
+        void ThomasSolveLanes(size_t n, size_t lanes, const Type *lower, const Type *diag, const Type *upper, Type *x, Type *scratch, size_t stride)
+        {
+            if (n == 0)
+                return;
+
+            bool singular = false;
+
+            for (size_t lane = 0; lane < lanes; lane++)
+            {
+                const Type pivot = diag[lane];
+                singular |= pivot == Type(0);
+                scratch[lane] = upper[lane] / pivot;
+                x[lane] = x[lane] / pivot;
+            }
+
+            for (size_t i = 1; i < n; i++)
+            {
+                const size_t at = i * stride;
+                const Type *prevScratch = scratch + (i - 1) * lanes;
+                Type *curScratch = scratch + i * lanes;
+
+                for (size_t lane = 0; lane < lanes; lane++)
+                {
+                    const Type pivot = diag[at + lane] - lower[at + lane] * prevScratch[lane];
+                    singular |= pivot == Type(0);
+                    curScratch[lane] = upper[at + lane] / pivot;
+                    x[at + lane] = (x[at + lane] - lower[at + lane] * x[at - stride + lane]) / pivot;
+                }
+            }
+
+            if (singular)
+                throw std::runtime_error("SolveTridiagonalBatch: zero pivot.");
+
+            for (size_t i = n - 1; i-- > 0;)
+            {
+                const size_t at = i * stride;
+                const Type *curScratch = scratch + i * lanes;
+
+                for (size_t lane = 0; lane < lanes; lane++)
+                    x[at + lane] -= curScratch[lane] * x[at + stride + lane];
+            }
+        }
+    }
+
+    template <typename Type, size_t Size>
+    Vector<Type, Size> SolveTridiagonal(const Vector<Type, Size> &lower, const Vector<Type, Size> &diag, const Vector<Type, Size> &upper, const Vector<Type, Size> &rhs)
+    {
+        Vector<Type, Size> x(rhs);
+        Type scratch[Size];
+        Detail::ThomasSolve(Size, lower.data, diag.data, upper.data, x.data, scratch, 1);
+        return x;
+    }
+
+    template <typename Type>
+    std::vector<Type> SolveTridiagonal(const std::vector<Type> &lower, const std::vector<Type> &diag, const std::vector<Type> &upper, const std::vector<Type> &rhs)
+    {
+        const size_t n = diag.size();
+
+        if (lower.size() != n || upper.size() != n || rhs.size() != n)
+            throw std::runtime_error("SolveTridiagonal: diagonal size mismatch.");
+
+        std::vector<Type> x(rhs);
+        std::vector<Type> scratch(n);
+        Detail::ThomasSolve(n, lower.data(), diag.data(), upper.data(), x.data(), scratch.data(), 1);
+        return x;
+    }
+
+    // Batched tridiagonal systems
+    //
+    // Solves count independent systems of size equations each, in place in rhs. The systems are
+    // interleaved: element i of system s is at index i * count + s in every array. Groups of
+    // systems are solved in lock-step across SIMD lanes, and groups are split between threads.
+
+    template <typename Type>
+    void SolveTridiagonalBatch(size_t size, size_t count, const Type *lower, const Type *diag, const Type *upper, Type *rhs)
+    {
+        const size_t groups = (count + Detail::TridiagonalLanes - 1) / Detail::TridiagonalLanes;
+
+        ParallelFor(0, groups, std::max<size_t>(1, 65536 / std::max<size_t>(size * Detail::TridiagonalLanes, 1)), [&](size_t groupBegin, size_t groupEnd)
+        {
+            std::vector<Type> scratch(size * Detail::TridiagonalLanes);
+
+            for (size_t group = groupBegin; group < groupEnd; group++)
+            {
+                const size_t first = group * Detail::TridiagonalLanes;
+                const size_t lanes = std::min(Detail::TridiagonalLanes, count - first);
+
+                Detail::ThomasSolveLanes(size, lanes, lower + first, diag + first, upper + first, rhs + first, scratch.data(), count);
+            }
+        });
+    }
+
+    // Block tridiagonal systems
+    //
+    // Same layout as the scalar solver, with Size x Size blocks. Each pivot block is factored
+    // with LUDecomposition.
+
+    template <typename Type, size_t Size>
+    std::vector<Vector<Type, Size>> SolveBlockTridiagonal(const std::vector<Matrix<Type, Size, Size>> &lower, const std::vector<Matrix<Type, Size, Size>> &diag,
+        const std::vector<Matrix<Type, Size, Size>> &upper, const std::vector<Vector<Type, Size>> &rhs)
+    {
+        const size_t n = diag.size();
+
+        if (lower.size() != n || upper.size() != n || rhs.size() != n)
+            throw std::runtime_error("SolveBlockTridiagonal: diagonal size mismatch.");
+
+        std::vector<Matrix<Type, Size, Size>> modifiedUpper(n);
+        std::vector<Vector<Type, Size>> x(rhs);
+
+        if (n == 0)
+            return x;
+
+        for (size_t i = 0; i < n; i++)
+        {
+            Matrix<Type, Size, Size> pivot(diag[i]);
+
+            if (i > 0)
+            {
+                pivot -= lower[i].Multiply(modifiedUpper[i - 1]);
+                x[i] -= lower[i].Multiply(x[i - 1]);
+            }
+
+            LUDecomposition<Type, Size> lu(pivot);
+
+            if (lu.singular)
+                throw std::runtime_error("SolveBlockTridiagonal: singular pivot block.");
+
+            if (i + 1 < n)
+                modifiedUpper[i] = lu.Solve(upper[i]);
+            x[i] = lu.Solve(x[i]);
+        }
+
+        for (size_t i = n - 1; i-- > 0;)
+            x[i] -= modifiedUpper[i].Multiply(x[i + 1]);
+
+        return x;
+    }
+
+    // Cyclic reduction
+    //
+    // For a single very long system. Each reduction level eliminates every other remaining
+    // equation, and the equations of a level are independent, so each level is split between
+    // threads. Like the Thomas algorithm, no pivoting is performed; the system should be
+    // diagonally dominant.
+
+    template <typename Type>
+    std::vector<Type> SolveTridiagonalCyclic(const std::vector<Type> &lower, const std::vector<Type> &diag, const std::vector<Type> &upper, const std::vector<Type> &rhs)
+    {
+        const size_t n = diag.size();
+
+        if (lower.size() != n || upper.size() != n || rhs.size() != n)
+            throw std::runtime_error("SolveTridiagonalCyclic: diagonal size mismatch.");
+
+        std::vector<Type> x(n);
+
+        if (n == 0)
+            return x;
+
+        std::vector<Type> a(lower), b(diag), c(upper), d(rhs);
+        a[0] = 0;
+        c[n - 1] = 0;
+
+        // Forward reduction: at stride h, equation i = 2h - 1, 4h - 1, ... absorbs i - h and i + h
+
+        size_t stride = 1;
+
+        for (; stride * 2 <= n; stride *= 2)
+        {
+            const size_t h = stride;
+            const size_t count = n / (2 * h);
+
+            ParallelFor(0, count, Detail::CyclicReductionChunk, [&](size_t begin, size_t end)
+            {
+                for (size_t k = begin; k < end; k++)
+                {
+                    const size_t i = (k + 1) * 2 * h - 1;
+                    const size_t left = i - h;
+
+                    if (b[left] == Type(0))
+                        throw std::runtime_error("SolveTridiagonalCyclic: zero pivot.");
+
+                    const Type alpha = -a[i] / b[left];
+
+                    b[i] += alpha * c[left];
+                    d[i] += alpha * d[left];
+                    a[i] = alpha * a[left];
+
+                    if (i + h < n)
+                    {
+                        const size_t right = i + h;
+
+                        if (b[right] == Type(0))
+                            throw std::runtime_error("SolveTridiagonalCyclic: zero pivot.");
+
+                        const Type gamma = -c[i] / b[right];
+
+                        b[i] += gamma * a[right];
+                        d[i] += gamma * d[right];
+                        c[i] = gamma * c[right];
+                    }
+                    else
+                    {
+                        c[i] = 0;
+                    }
+                }
+            });
+        }
+
+        // The last remaining equation, stride - 1, no longer couples to any other
+
+        if (b[stride - 1] == Type(0))
+            throw std::runtime_error("SolveTridiagonalCyclic: zero pivot.");
+
+        x[stride - 1] = d[stride - 1] / b[stride - 1];
+
+        // Back substitution: at stride h, equations h - 1, 3h - 1, ... are solved from their neighbours
+
+        for (size_t h = stride / 2; h >= 1; h /= 2)
+        {
+            const size_t count = (n + h) / (2 * h);
+
+            ParallelFor(0, count, Detail::CyclicReductionChunk, [&](size_t begin, size_t end)
+            {
+                for (size_t k = begin; k < end; k++)
+                {
+                    const size_t i = (2 * k + 1) * h - 1;
+                    Type sum = d[i];
+
+                    if (i >= h)
+                        sum -= a[i] * x[i - h];
+                    if (i + h < n)
+                        sum -= c[i] * x[i + h];
+
+                    x[i] = sum / b[i];
+                }
+            });
+        }
+
+        return x;
+    }
+}
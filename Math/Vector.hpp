@@ -4,9 +4,19 @@
 #include <cstdint>
 #include <cstring>
 #include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 namespace Scoop::Math
 {
+    namespace Detail
+    {
+        // Magnitudes and distances are double for arithmetic elements, and of the element type
+        // otherwise (such as dual numbers, whose sqrt is found by argument-dependent lookup)
+
+        template <typename Type> using MagnitudeType = typename std::conditional<std::is_arithmetic<Type>::value, double, Type>::type;
+    }
+
     #define __VEC_FOREACH for (size_t i = 0; i < Size; i++)
 
     template <typename Type, size_t Size> class Vector
@@ -33,13 +43,13 @@ namespace Scoop::Math
         { __VEC_FOREACH this->data[i] = value; }
 
         void Assign(const Vector<Type, Size> &vec)
-        { std::memcpy(this->data, vec.data, sizeof(Type) * Size); }
+        { __VEC_FOREACH this->data[i] = vec.data[i]; }
 
         void Assign(const std::vector<Type> &values)
         {
             if (values.size() != Size)
                 throw std::runtime_error("Vector::Assign: vector size mismatch.");
-            std::memcpy(this->data, &values[0], sizeof(Type) * Size);
+            __VEC_FOREACH this->data[i] = values[i];
         }
 
         // Indexing
@@ -84,8 +94,9 @@ namespace Scoop::Math
             return sum;
         }
 
-        double Magnitude() const
+        Detail::MagnitudeType<Type> Magnitude() const
         {
+            using std::sqrt;
             Type sum = 0;
 
             __VEC_FOREACH
@@ -94,20 +105,21 @@ namespace Scoop::Math
                 sum += element * element;
             }
 
-            return sqrt(sum);
+            return sqrt(Detail::MagnitudeType<Type>(sum));
         }
 
-        double Distance(const Vector<Type, Size> &vec) const
+        Detail::MagnitudeType<Type> Distance(const Vector<Type, Size> &vec) const
         {
+            using std::sqrt;
             Type sum = 0;
 
             __VEC_FOREACH
             {
-                Type delta = this->data[i] - vec->data[i];
+                Type delta = this->data[i] - vec.data[i];
                 sum += delta * delta;
             }
 
-            return sqrt(sum);
+            return sqrt(Detail::MagnitudeType<Type>(sum));
         }
 
         Type Dot(const Vector<Type, Size> &vec) const